@@ -0,0 +1,352 @@
+//
+// Micro benchmarks of the geometry library
+//
+// Run through the bench target to get a JSON report, or directly with
+// --benchmark_out=<file> --benchmark_out_format=json
+//
+
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "BezierBatch.h"
+#include "BezierCurve.h"
+#include "ClearanceChecker.h"
+#include "FlexTrackSegment.h"
+#include "Geometry.h"
+#include "LayoutRecalculator.h"
+#include "LevelOfDetail.h"
+#include "SegmentStore.h"
+#include "TaskPool.h"
+#include "TrackGraph.h"
+
+namespace ByteTrail {
+
+    static void SetCurve(BezierCurve &curve, double x, double y) {
+        curve.SetControlPoint(x, y, 0);
+        curve.SetControlPoint(x + 100, y, 1);
+        curve.SetControlPoint(x + 100, y + 100, 2);
+        curve.SetControlPoint(x + 200, y + 100, 3);
+    }
+
+    //-----------------------------------------------------------------------------------
+    // The argument is the number of line segments, the inverse of the resolution
+    //-----------------------------------------------------------------------------------
+    static void BM_Recalculate(benchmark::State &state, EvaluationMode mode, SamplingMode sampling) {
+        BezierCurve curve;
+        SetCurve(curve, 0, 0);
+        curve.SetResolution(1.0F / state.range(0));
+        curve.SetEvaluationMode(mode);
+        curve.SetSamplingMode(sampling);
+        curve.Update();
+
+        double offset = 1.0;
+        for (auto _ : state) {
+            curve.Move(offset, 0);
+            offset = -offset;
+            curve.Update();
+            benchmark::DoNotOptimize(curve.GetCenterline().data());
+        }
+        state.SetItemsProcessed(state.iterations() * curve.GetPointCount());
+    }
+    BENCHMARK_CAPTURE(BM_Recalculate, forward_difference, EVAL_FORWARD_DIFFERENCE, SAMPLE_UNIFORM)
+        ->Arg(10)->Arg(40)->Arg(100)->Arg(400);
+    BENCHMARK_CAPTURE(BM_Recalculate, reference, EVAL_REFERENCE, SAMPLE_UNIFORM)
+        ->Arg(10)->Arg(40)->Arg(100)->Arg(400);
+    BENCHMARK_CAPTURE(BM_Recalculate, arc_length, EVAL_FORWARD_DIFFERENCE, SAMPLE_ARC_LENGTH)
+        ->Arg(10)->Arg(40)->Arg(100)->Arg(400);
+
+    static void BM_RecalculateAdaptive(benchmark::State &state) {
+        BezierCurve curve;
+        SetCurve(curve, 0, 0);
+        curve.SetSamplingMode(SAMPLE_ADAPTIVE);
+        curve.SetTolerance(0.25);
+
+        double offset = 1.0;
+        for (auto _ : state) {
+            curve.Move(offset, 0);
+            offset = -offset;
+            curve.Update();
+            benchmark::DoNotOptimize(curve.GetCenterline().data());
+        }
+    }
+    BENCHMARK(BM_RecalculateAdaptive);
+
+    //-----------------------------------------------------------------------------------
+    // Length of a curve whose control points change every iteration
+    //-----------------------------------------------------------------------------------
+    static void BM_GetLength(benchmark::State &state) {
+        BezierCurve curve;
+        SetCurve(curve, 0, 0);
+        curve.SetResolution(1.0F / state.range(0));
+
+        double y = 100.0;
+        for (auto _ : state) {
+            curve.SetControlPoint(200, y, 3);
+            y = y == 100.0 ? 101.0 : 100.0;
+            benchmark::DoNotOptimize(curve.GetLength());
+        }
+    }
+    BENCHMARK(BM_GetLength)->Arg(40)->Arg(400);
+
+    static void BM_RecalculateParallels(benchmark::State &state) {
+        BezierCurve curve;
+        SetCurve(curve, 0, 0);
+        curve.SetResolution(1.0F / state.range(0));
+        curve.Update();
+
+        float distance = 4.5F;
+        for (auto _ : state) {
+            distance = distance == 4.5F ? 5.0F : 4.5F;
+            curve.SetParallelsDistance(distance);
+            curve.Update();
+            benchmark::DoNotOptimize(curve.GetLeftRail().data());
+        }
+        state.SetItemsProcessed(state.iterations() * curve.GetPointCount());
+    }
+    BENCHMARK(BM_RecalculateParallels)->Arg(40)->Arg(400);
+
+    //-----------------------------------------------------------------------------------
+    // Roadbed edges and the centerline of a second track alongside a curve, four
+    // lines from the cached normals
+    //-----------------------------------------------------------------------------------
+    static void BM_OffsetLines(benchmark::State &state) {
+        BezierCurve curve;
+        SetCurve(curve, 0, 0);
+        curve.SetResolution(1.0F / state.range(0));
+        curve.Update();
+        const double offsets[] = {kRoadbedWidth / 2.0, -kRoadbedWidth / 2.0,
+                                  kDoubleTrackSpacing, -kDoubleTrackSpacing};
+        std::vector<Point> lines[4];
+
+        for (auto _ : state) {
+            for (unsigned i = 0; i < 4; i++)
+                curve.GetOffsetLine(offsets[i], lines[i]);
+            benchmark::DoNotOptimize(lines[3].data());
+        }
+        state.SetItemsProcessed(state.iterations() * 4 * curve.GetPointCount());
+    }
+    BENCHMARK(BM_OffsetLines)->Arg(40)->Arg(400);
+
+    //-----------------------------------------------------------------------------------
+    // Hit test of a curve against a moving location, and the cached properties read
+    // back while the curve does not change
+    //-----------------------------------------------------------------------------------
+    static void BM_ClosestPoint(benchmark::State &state) {
+        BezierCurve curve;
+        SetCurve(curve, 0, 0);
+        curve.SetResolution(1.0F / state.range(0));
+        curve.Update();
+
+        double x = 0.0;
+        for (auto _ : state) {
+            x = x < 200.0 ? x + 1.0 : 0.0;
+            benchmark::DoNotOptimize(curve.GetClosestPoint(Point(x, 60.0)));
+        }
+    }
+    BENCHMARK(BM_ClosestPoint)->Arg(40)->Arg(400);
+
+    static void BM_CachedProperties(benchmark::State &state) {
+        BezierCurve curve;
+        SetCurve(curve, 0, 0);
+        curve.Update();
+
+        for (auto _ : state) {
+            benchmark::DoNotOptimize(curve.GetTightBounds());
+            benchmark::DoNotOptimize(curve.GetExactLength());
+            benchmark::DoNotOptimize(curve.GetMinimumRadius());
+        }
+    }
+    BENCHMARK(BM_CachedProperties);
+
+    //-----------------------------------------------------------------------------------
+    // The argument is the length of the segment in scale inches
+    //-----------------------------------------------------------------------------------
+    static void BM_GetTies(benchmark::State &state) {
+        FlexTrackSegment segment;
+        std::shared_ptr<BezierCurve> curve = segment.GetCurve();
+        const double length = state.range(0);
+        curve->SetControlPoint(0, 0, 0);
+        curve->SetControlPoint(length / 3, length / 4, 1);
+        curve->SetControlPoint(2 * length / 3, -length / 4, 2);
+        curve->SetControlPoint(length, 0, 3);
+
+        double offset = 1.0;
+        for (auto _ : state) {
+            curve->Move(0, offset);
+            offset = -offset;
+            benchmark::DoNotOptimize(segment.GetTieData());
+        }
+        state.SetItemsProcessed(state.iterations() * segment.GetTieCount());
+    }
+    BENCHMARK(BM_GetTies)->Arg(120)->Arg(1200);
+
+    static void BM_PolygonAdd(benchmark::State &state) {
+        Polygon polygon;
+        const unsigned vertices = state.range(0);
+        for (auto _ : state) {
+            polygon.Clear();
+            for (unsigned i = 0; i < vertices; i++) {
+                polygon.Add(Point(i, i & 1));
+            }
+            benchmark::DoNotOptimize(polygon.GetPath().GetPoints());
+        }
+        state.SetItemsProcessed(state.iterations() * vertices);
+    }
+    BENCHMARK(BM_PolygonAdd)->Arg(4)->Arg(64)->Arg(1024);
+
+    //-----------------------------------------------------------------------------------
+    // Rebuild of a layout of N chained segments after every segment moved, either one
+    // curve at a time, through the batch evaluator or spread over a task pool
+    //-----------------------------------------------------------------------------------
+    enum RebuildMode {
+        REBUILD_SERIAL,
+        REBUILD_BATCHED,
+        REBUILD_THREADED
+    };
+
+    static void BM_LayoutRebuild(benchmark::State &state, RebuildMode mode) {
+        std::vector<std::shared_ptr<BezierCurve>> layout;
+        for (int i = 0; i < state.range(0); i++) {
+            std::shared_ptr<BezierCurve> curve = std::make_shared<BezierCurve>();
+            SetCurve(*curve, 200.0 * i, 100.0 * i);
+            curve->Update();
+            layout.push_back(curve);
+        }
+        BezierBatch batch;
+        TaskPool pool;
+        LayoutRecalculator recalculator(pool);
+
+        double offset = 1.0;
+        for (auto _ : state) {
+            for (auto &curve : layout)
+                curve->Move(offset, 0);
+            offset = -offset;
+            if (mode == REBUILD_BATCHED) {
+                batch.Recalculate(layout);
+            } else if (mode == REBUILD_THREADED) {
+                recalculator.Recalculate(layout);
+            } else {
+                for (auto &curve : layout)
+                    curve->Update();
+            }
+            benchmark::DoNotOptimize(layout.back()->GetCenterline().data());
+        }
+        state.SetItemsProcessed(state.iterations() * layout.size());
+    }
+    BENCHMARK_CAPTURE(BM_LayoutRebuild, serial, REBUILD_SERIAL)->Arg(16)->Arg(256)->Arg(4096);
+    BENCHMARK_CAPTURE(BM_LayoutRebuild, batched, REBUILD_BATCHED)->Arg(16)->Arg(256)->Arg(4096);
+    BENCHMARK_CAPTURE(BM_LayoutRebuild, threaded, REBUILD_THREADED)->Arg(16)->Arg(256)->Arg(4096)
+        ->UseRealTime();
+
+    //-----------------------------------------------------------------------------------
+    // The batched rebuild above with the curves held by value in a SegmentStore
+    //-----------------------------------------------------------------------------------
+    static void BM_StoreRebuild(benchmark::State &state) {
+        SegmentStore layout;
+        layout.Reserve(state.range(0));
+        for (int i = 0; i < state.range(0); i++) {
+            BezierCurve curve;
+            SetCurve(curve, 200.0 * i, 100.0 * i);
+            curve.Update();
+            layout.Add(std::move(curve));
+        }
+        BezierBatch batch;
+
+        double offset = 1.0;
+        for (auto _ : state) {
+            for (BezierCurve &curve : layout)
+                curve.Move(offset, 0);
+            offset = -offset;
+            batch.Recalculate(layout);
+            benchmark::DoNotOptimize(layout[layout.GetSize() - 1].GetCenterline().data());
+        }
+        state.SetItemsProcessed(state.iterations() * layout.GetSize());
+    }
+    BENCHMARK(BM_StoreRebuild)->Arg(16)->Arg(256)->Arg(4096);
+
+    //-----------------------------------------------------------------------------------
+    // Geometry handed to the renderer for a layout of N segments at a zoom, with the
+    // detail chosen per segment. The vertices counter is the number of path points
+    // a draw of the whole layout issues.
+    //-----------------------------------------------------------------------------------
+    static void BM_DetailBuild(benchmark::State &state, double scale) {
+        std::vector<std::shared_ptr<BezierCurve>> layout;
+        for (int i = 0; i < state.range(0); i++) {
+            std::shared_ptr<BezierCurve> curve = std::make_shared<BezierCurve>();
+            SetCurve(*curve, 200.0 * i, 100.0 * i);
+            curve->Update();
+            layout.push_back(curve);
+        }
+        LevelOfDetail detail;
+
+        std::size_t vertices = 0;
+        for (auto _ : state) {
+            vertices = 0;
+            for (auto &curve : layout) {
+                detail.Build(*curve, LevelOfDetail::Select(scale, curve->GetParallelsDistance(),
+                                                           curve->GetLength()), scale);
+                vertices += detail.GetPoints().size() + 4 * detail.GetTies().size();
+            }
+            benchmark::DoNotOptimize(detail.GetPoints().data());
+        }
+        state.counters["vertices"] = vertices;
+        state.SetItemsProcessed(state.iterations() * layout.size());
+    }
+    BENCHMARK_CAPTURE(BM_DetailBuild, ties, 2.0)->Arg(256);
+    BENCHMARK_CAPTURE(BM_DetailBuild, rails, 0.5)->Arg(256);
+    BENCHMARK_CAPTURE(BM_DetailBuild, centerline, 0.1)->Arg(256);
+
+    //-----------------------------------------------------------------------------------
+    // Clearance of a layout of N segments in rows of 16, each row joined end to start
+    // and 25 from the next, so every segment conflicts with its neighbors. The full
+    // check compares all pairs once, the update re-checks one segment being dragged.
+    //-----------------------------------------------------------------------------------
+    static void BuildRows(TrackGraph &graph, int count) {
+        for (int i = 0; i < count; i++) {
+            std::shared_ptr<BezierCurve> curve = std::make_shared<BezierCurve>();
+            SetCurve(*curve, 200.0 * (i % 16), 25.0 * (i / 16));
+            curve->SetControlPoint(200.0 * (i % 16) + 100, 25.0 * (i / 16) + 20, 2);
+            curve->SetControlPoint(200.0 * (i % 16) + 200, 25.0 * (i / 16), 3);
+            const unsigned segment = graph.AddSegment(curve);
+            if (i % 16 != 0)
+                graph.Connect(segment - 1, TrackGraph::END_FINISH, segment, TrackGraph::END_START);
+        }
+    }
+
+    static void BM_ClearanceFull(benchmark::State &state) {
+        TrackGraph graph;
+        BuildRows(graph, state.range(0));
+        ClearanceChecker checker;
+
+        for (auto _ : state) {
+            checker.Update(graph);
+            benchmark::DoNotOptimize(checker.GetConflictCount());
+        }
+        state.counters["conflicts"] = checker.GetConflictCount();
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_ClearanceFull)->Arg(256)->Arg(4096);
+
+    static void BM_ClearanceUpdate(benchmark::State &state) {
+        TrackGraph graph;
+        BuildRows(graph, state.range(0));
+        ClearanceChecker checker;
+        checker.Update(graph);
+        const unsigned segment = state.range(0) / 2;
+        BezierCurve &curve = *graph.GetCurve(segment);
+
+        double offset = 1.0;
+        for (auto _ : state) {
+            curve.Move(offset, 0);
+            offset = -offset;
+            checker.Update(graph, segment);
+            benchmark::DoNotOptimize(checker.GetConflicts(segment).data());
+        }
+    }
+    BENCHMARK(BM_ClearanceUpdate)->Arg(256)->Arg(4096);
+
+}
+
+BENCHMARK_MAIN();
@@ -1,14 +1,25 @@
 #include <cmath>
+#include <cstdlib>
+#include <fstream>
 #include <memory>
 #include <iostream>
 #include <gtkmm.h>
 #include "CurveView.h"
+#include "LayoutGLArea.h"
 
 
 int segments;
 
 static ByteTrail::CurveView  *curve_view;
 static Gtk::CheckButton *edit_button;
+static Gtk::CheckButton *stats_button;
+static Gtk::CheckButton *background_button;
+static Gtk::CheckButton *coalesce_button;
+static Gtk::CheckButton *gl_button;
+static Gtk::Button *undo_button;
+static Gtk::Button *redo_button;
+static ByteTrail::LayoutGLArea *gl_area;
+static std::ofstream stats_file;
 static std::unique_ptr<Gtk::SpinButton> segments_button;
 static std::unique_ptr<Gtk::SpinButton> width_button;
 
@@ -17,6 +28,41 @@ void on_button_toggled()
    curve_view->SetEditMode(edit_button->get_active());
 }
 
+void OnStatsToggled()
+{
+   curve_view->SetStatsOverlay(stats_button->get_active());
+}
+
+void OnBackgroundToggled()
+{
+   curve_view->SetBackgroundGeometry(background_button->get_active());
+}
+
+void OnCoalesceToggled()
+{
+   curve_view->SetMotionCoalescing(coalesce_button->get_active());
+}
+
+void OnGLToggled()
+{
+   curve_view->SetGLArea(gl_button->get_active() ? gl_area : nullptr);
+}
+
+void OnUndoClicked()
+{
+   curve_view->Undo();
+}
+
+void OnRedoClicked()
+{
+   curve_view->Redo();
+}
+
+void OnFrameStats(const ByteTrail::FrameStats & stats)
+{
+    stats.WriteCsv(stats_file);
+}
+
 void OnSegmentsChanged()
 {
     int delta = segments_button->get_value() - segments;
@@ -36,6 +82,7 @@ void OnSegmentsChanged()
 
 void OnZoomChanged()
 {
+    curve_view->SetScale(width_button->get_value() / 100.0);
 }
 
 int main(int argc, char **argv)
@@ -70,7 +117,7 @@ int main(int argc, char **argv)
     width_button = std::unique_ptr<Gtk::SpinButton>(new Gtk::SpinButton());
     width_button->set_adjustment(width_adjustment);
     grid.attach(*width_button, 1, 1, 1, 1);
-    segments_button->signal_value_changed().connect(sigc::ptr_fun(&OnZoomChanged));
+    width_button->signal_value_changed().connect(sigc::ptr_fun(&OnZoomChanged));
 
     edit_button = new Gtk::CheckButton();
     edit_button->set_label("Editing");
@@ -78,9 +125,62 @@ int main(int argc, char **argv)
     grid.attach(*edit_button, 0, 2, 2, 1);
     edit_button->signal_toggled().connect(sigc::ptr_fun(&on_button_toggled));
 
+    stats_button = new Gtk::CheckButton();
+    stats_button->set_label("Statistics");
+    stats_button->set_active(false);
+    grid.attach(*stats_button, 0, 3, 2, 1);
+    stats_button->signal_toggled().connect(sigc::ptr_fun(&OnStatsToggled));
+
+    background_button = new Gtk::CheckButton();
+    background_button->set_label("Background geometry");
+    background_button->set_active(false);
+    grid.attach(*background_button, 0, 4, 2, 1);
+    background_button->signal_toggled().connect(sigc::ptr_fun(&OnBackgroundToggled));
+
+    coalesce_button = new Gtk::CheckButton();
+    coalesce_button->set_label("Coalesce motion");
+    coalesce_button->set_active(false);
+    grid.attach(*coalesce_button, 0, 5, 2, 1);
+    coalesce_button->signal_toggled().connect(sigc::ptr_fun(&OnCoalesceToggled));
+
+    gl_button = new Gtk::CheckButton();
+    gl_button->set_label("GPU rendering");
+    gl_button->set_active(false);
+    grid.attach(*gl_button, 0, 6, 2, 1);
+    gl_button->signal_toggled().connect(sigc::ptr_fun(&OnGLToggled));
+
+    undo_button = new Gtk::Button("Undo");
+    grid.attach(*undo_button, 0, 7, 1, 1);
+    undo_button->signal_clicked().connect(sigc::ptr_fun(&OnUndoClicked));
+
+    redo_button = new Gtk::Button("Redo");
+    grid.attach(*redo_button, 1, 7, 1, 1);
+    redo_button->signal_clicked().connect(sigc::ptr_fun(&OnRedoClicked));
+
     h_box.pack_end(grid, false, false, 0);
+
+    // the view draws its handles over the layout drawn by the GL area
+    Gtk::Overlay overlay;
+    gl_area = new ByteTrail::LayoutGLArea();
+    overlay.add(*gl_area);
     curve_view = new ByteTrail::CurveView();
-    h_box.pack_start(*curve_view, true, true, 0);
+    overlay.add_overlay(*curve_view);
+    h_box.pack_start(overlay, true, true, 0);
+
+    // FLEXTRACK_STATS_CSV=<file> records the statistics of every frame
+    const char * stats_path = std::getenv("FLEXTRACK_STATS_CSV");
+    if(stats_path != nullptr)
+    {
+        stats_file.open(stats_path);
+        if(stats_file)
+        {
+            ByteTrail::FrameStats::WriteCsvHeader(stats_file);
+            ByteTrail::Stats::GetInstance().SetEnabled(true);
+            curve_view->signal_frame_stats().connect(sigc::ptr_fun(&OnFrameStats));
+        }
+        else
+            std::cerr << "cannot write statistics to " << stats_path << std::endl;
+    }
 
     window.add(h_box);
     window.show_all();
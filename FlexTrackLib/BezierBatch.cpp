@@ -0,0 +1,783 @@
+#include "BezierBatch.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "Stats.h"
+#include "Trace.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define FLEXTRACK_BATCH_X86
+#include <emmintrin.h>
+#if defined(__GNUC__)
+#define FLEXTRACK_BATCH_AVX
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(__aarch64__)
+#define FLEXTRACK_BATCH_NEON
+#include <arm_neon.h>
+#endif
+
+namespace ByteTrail {
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Arguments shared by the batch kernels
+    //-----------------------------------------------------------------------------------
+    struct BatchKernelArgs {
+        const double *control_x[4];
+        const double *control_y[4];
+        const double *weights;
+        BatchLane *lanes;
+        unsigned stride;
+        unsigned samples;
+        double distance;
+    };
+
+    //! number of weights stored per sample, 4 for the position and 4 for the derivative
+    static constexpr unsigned kWeightsPerSample = 8;
+
+    // the kernels write the x and y of a sample with one store
+    static_assert(sizeof(Point) == 2 * sizeof(double), "Point must be two packed doubles");
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Portable kernel, one curve at a time
+    //-----------------------------------------------------------------------------------
+    static void EvaluateScalar(const BatchKernelArgs &args) {
+        for (unsigned c = 0; c < args.stride; c++) {
+            BatchLane &lane = args.lanes[c];
+            const double x0 = args.control_x[0][c], x1 = args.control_x[1][c];
+            const double x2 = args.control_x[2][c], x3 = args.control_x[3][c];
+            const double y0 = args.control_y[0][c], y1 = args.control_y[1][c];
+            const double y2 = args.control_y[2][c], y3 = args.control_y[3][c];
+
+            double arc = 0.0;
+            double last_x = x0, last_y = y0;
+            lane.degenerate = false;
+            for (unsigned i = 0; i < args.samples; i++) {
+                const double *w = args.weights + i * kWeightsPerSample;
+                double px = w[0] * x0 + w[1] * x1 + w[2] * x2 + w[3] * x3;
+                double py = w[0] * y0 + w[1] * y1 + w[2] * y2 + w[3] * y3;
+                double tx = w[4] * x0 + w[5] * x1 + w[6] * x2 + w[7] * x3;
+                double ty = w[4] * y0 + w[5] * y1 + w[6] * y2 + w[7] * y3;
+
+                double length = std::sqrt(tx * tx + ty * ty);
+                double inverse = length > 0.0 ? 1.0 / length : 0.0;
+                double nx = ty * inverse;
+                double ny = -tx * inverse;
+                lane.degenerate |= length == 0.0;
+
+                arc += std::sqrt((last_x - px) * (last_x - px) + (last_y - py) * (last_y - py));
+                last_x = px;
+                last_y = py;
+
+                lane.points[i] = Point(px, py);
+                lane.tangents[i] = Point(tx, ty);
+                lane.normals[i] = Point(nx, ny);
+                lane.left_rail[i] = Point(px + nx * args.distance, py + ny * args.distance);
+                lane.right_rail[i] = Point(px - nx * args.distance, py - ny * args.distance);
+                lane.arc_lengths[i] = arc;
+            }
+        }
+    }
+
+#if defined(FLEXTRACK_BATCH_X86)
+    //-----------------------------------------------------------------------------------
+    //! \brief Writes one sample of two lanes, interleaving x and y into points
+    //-----------------------------------------------------------------------------------
+    static inline void StoreSSE2(Point *first, Point *second, __m128d x, __m128d y) {
+        _mm_storeu_pd(&first->x, _mm_unpacklo_pd(x, y));
+        _mm_storeu_pd(&second->x, _mm_unpackhi_pd(x, y));
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief SSE2 kernel, two curves per operation
+    //-----------------------------------------------------------------------------------
+    static void EvaluateSSE2(const BatchKernelArgs &args) {
+        const __m128d distance = _mm_set1_pd(args.distance);
+        const __m128d one = _mm_set1_pd(1.0);
+        const __m128d zero = _mm_setzero_pd();
+        for (unsigned c = 0; c < args.stride; c += 2) {
+            BatchLane &a = args.lanes[c];
+            BatchLane &b = args.lanes[c + 1];
+            const __m128d x0 = _mm_loadu_pd(args.control_x[0] + c);
+            const __m128d x1 = _mm_loadu_pd(args.control_x[1] + c);
+            const __m128d x2 = _mm_loadu_pd(args.control_x[2] + c);
+            const __m128d x3 = _mm_loadu_pd(args.control_x[3] + c);
+            const __m128d y0 = _mm_loadu_pd(args.control_y[0] + c);
+            const __m128d y1 = _mm_loadu_pd(args.control_y[1] + c);
+            const __m128d y2 = _mm_loadu_pd(args.control_y[2] + c);
+            const __m128d y3 = _mm_loadu_pd(args.control_y[3] + c);
+
+            __m128d arc = zero;
+            __m128d last_x = x0, last_y = y0;
+            __m128d degenerate = zero;
+            for (unsigned i = 0; i < args.samples; i++) {
+                const double *w = args.weights + i * kWeightsPerSample;
+                __m128d b0 = _mm_set1_pd(w[0]), b1 = _mm_set1_pd(w[1]);
+                __m128d b2 = _mm_set1_pd(w[2]), b3 = _mm_set1_pd(w[3]);
+                __m128d d0 = _mm_set1_pd(w[4]), d1 = _mm_set1_pd(w[5]);
+                __m128d d2 = _mm_set1_pd(w[6]), d3 = _mm_set1_pd(w[7]);
+
+                __m128d px = _mm_add_pd(_mm_add_pd(_mm_mul_pd(b0, x0), _mm_mul_pd(b1, x1)),
+                                        _mm_add_pd(_mm_mul_pd(b2, x2), _mm_mul_pd(b3, x3)));
+                __m128d py = _mm_add_pd(_mm_add_pd(_mm_mul_pd(b0, y0), _mm_mul_pd(b1, y1)),
+                                        _mm_add_pd(_mm_mul_pd(b2, y2), _mm_mul_pd(b3, y3)));
+                __m128d tx = _mm_add_pd(_mm_add_pd(_mm_mul_pd(d0, x0), _mm_mul_pd(d1, x1)),
+                                        _mm_add_pd(_mm_mul_pd(d2, x2), _mm_mul_pd(d3, x3)));
+                __m128d ty = _mm_add_pd(_mm_add_pd(_mm_mul_pd(d0, y0), _mm_mul_pd(d1, y1)),
+                                        _mm_add_pd(_mm_mul_pd(d2, y2), _mm_mul_pd(d3, y3)));
+
+                __m128d length = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(tx, tx), _mm_mul_pd(ty, ty)));
+                __m128d inverse = _mm_and_pd(_mm_cmpgt_pd(length, zero), _mm_div_pd(one, length));
+                __m128d nx = _mm_mul_pd(ty, inverse);
+                __m128d ny = _mm_sub_pd(zero, _mm_mul_pd(tx, inverse));
+                __m128d ox = _mm_mul_pd(nx, distance);
+                __m128d oy = _mm_mul_pd(ny, distance);
+                degenerate = _mm_or_pd(degenerate, _mm_cmpeq_pd(length, zero));
+
+                __m128d dx = _mm_sub_pd(last_x, px);
+                __m128d dy = _mm_sub_pd(last_y, py);
+                arc = _mm_add_pd(arc, _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy))));
+                last_x = px;
+                last_y = py;
+
+                StoreSSE2(a.points + i, b.points + i, px, py);
+                StoreSSE2(a.tangents + i, b.tangents + i, tx, ty);
+                StoreSSE2(a.normals + i, b.normals + i, nx, ny);
+                StoreSSE2(a.left_rail + i, b.left_rail + i, _mm_add_pd(px, ox), _mm_add_pd(py, oy));
+                StoreSSE2(a.right_rail + i, b.right_rail + i, _mm_sub_pd(px, ox), _mm_sub_pd(py, oy));
+                _mm_storel_pd(a.arc_lengths + i, arc);
+                _mm_storeh_pd(b.arc_lengths + i, arc);
+            }
+            const int mask = _mm_movemask_pd(degenerate);
+            a.degenerate = (mask & 1) != 0;
+            b.degenerate = (mask & 2) != 0;
+        }
+    }
+#endif
+
+#if defined(FLEXTRACK_BATCH_AVX)
+    //-----------------------------------------------------------------------------------
+    //! \brief Writes one sample of four lanes, interleaving x and y into points
+    //-----------------------------------------------------------------------------------
+    __attribute__((target("avx")))
+    static inline void StoreAVX(const BatchLane *lanes, Point *BatchLane::*buffer, unsigned i,
+                                __m256d x, __m256d y) {
+        const __m256d even = _mm256_unpacklo_pd(x, y);
+        const __m256d odd = _mm256_unpackhi_pd(x, y);
+        _mm_storeu_pd(&(lanes[0].*buffer)[i].x, _mm256_castpd256_pd128(even));
+        _mm_storeu_pd(&(lanes[1].*buffer)[i].x, _mm256_castpd256_pd128(odd));
+        _mm_storeu_pd(&(lanes[2].*buffer)[i].x, _mm256_extractf128_pd(even, 1));
+        _mm_storeu_pd(&(lanes[3].*buffer)[i].x, _mm256_extractf128_pd(odd, 1));
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief AVX kernel, four curves per operation
+    //!
+    //! Compiled for AVX through the target attribute so the library itself does not
+    //! require AVX; it is only called once DetectKernel() has confirmed support.
+    //-----------------------------------------------------------------------------------
+    __attribute__((target("avx")))
+    static void EvaluateAVX(const BatchKernelArgs &args) {
+        const __m256d distance = _mm256_set1_pd(args.distance);
+        const __m256d one = _mm256_set1_pd(1.0);
+        const __m256d zero = _mm256_setzero_pd();
+        for (unsigned c = 0; c < args.stride; c += 4) {
+            BatchLane *lanes = args.lanes + c;
+            const __m256d x0 = _mm256_loadu_pd(args.control_x[0] + c);
+            const __m256d x1 = _mm256_loadu_pd(args.control_x[1] + c);
+            const __m256d x2 = _mm256_loadu_pd(args.control_x[2] + c);
+            const __m256d x3 = _mm256_loadu_pd(args.control_x[3] + c);
+            const __m256d y0 = _mm256_loadu_pd(args.control_y[0] + c);
+            const __m256d y1 = _mm256_loadu_pd(args.control_y[1] + c);
+            const __m256d y2 = _mm256_loadu_pd(args.control_y[2] + c);
+            const __m256d y3 = _mm256_loadu_pd(args.control_y[3] + c);
+
+            __m256d arc = zero;
+            __m256d last_x = x0, last_y = y0;
+            __m256d degenerate = zero;
+            for (unsigned i = 0; i < args.samples; i++) {
+                const double *w = args.weights + i * kWeightsPerSample;
+                __m256d b0 = _mm256_set1_pd(w[0]), b1 = _mm256_set1_pd(w[1]);
+                __m256d b2 = _mm256_set1_pd(w[2]), b3 = _mm256_set1_pd(w[3]);
+                __m256d d0 = _mm256_set1_pd(w[4]), d1 = _mm256_set1_pd(w[5]);
+                __m256d d2 = _mm256_set1_pd(w[6]), d3 = _mm256_set1_pd(w[7]);
+
+                __m256d px = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(b0, x0), _mm256_mul_pd(b1, x1)),
+                                           _mm256_add_pd(_mm256_mul_pd(b2, x2), _mm256_mul_pd(b3, x3)));
+                __m256d py = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(b0, y0), _mm256_mul_pd(b1, y1)),
+                                           _mm256_add_pd(_mm256_mul_pd(b2, y2), _mm256_mul_pd(b3, y3)));
+                __m256d tx = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(d0, x0), _mm256_mul_pd(d1, x1)),
+                                           _mm256_add_pd(_mm256_mul_pd(d2, x2), _mm256_mul_pd(d3, x3)));
+                __m256d ty = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(d0, y0), _mm256_mul_pd(d1, y1)),
+                                           _mm256_add_pd(_mm256_mul_pd(d2, y2), _mm256_mul_pd(d3, y3)));
+
+                __m256d length = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(tx, tx), _mm256_mul_pd(ty, ty)));
+                __m256d inverse = _mm256_and_pd(_mm256_cmp_pd(length, zero, _CMP_GT_OQ),
+                                                _mm256_div_pd(one, length));
+                __m256d nx = _mm256_mul_pd(ty, inverse);
+                __m256d ny = _mm256_sub_pd(zero, _mm256_mul_pd(tx, inverse));
+                __m256d ox = _mm256_mul_pd(nx, distance);
+                __m256d oy = _mm256_mul_pd(ny, distance);
+                degenerate = _mm256_or_pd(degenerate, _mm256_cmp_pd(length, zero, _CMP_EQ_OQ));
+
+                __m256d dx = _mm256_sub_pd(last_x, px);
+                __m256d dy = _mm256_sub_pd(last_y, py);
+                arc = _mm256_add_pd(arc, _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx),
+                                                                      _mm256_mul_pd(dy, dy))));
+                last_x = px;
+                last_y = py;
+
+                StoreAVX(lanes, &BatchLane::points, i, px, py);
+                StoreAVX(lanes, &BatchLane::tangents, i, tx, ty);
+                StoreAVX(lanes, &BatchLane::normals, i, nx, ny);
+                StoreAVX(lanes, &BatchLane::left_rail, i, _mm256_add_pd(px, ox), _mm256_add_pd(py, oy));
+                StoreAVX(lanes, &BatchLane::right_rail, i, _mm256_sub_pd(px, ox), _mm256_sub_pd(py, oy));
+                const __m128d low = _mm256_castpd256_pd128(arc);
+                const __m128d high = _mm256_extractf128_pd(arc, 1);
+                _mm_storel_pd(lanes[0].arc_lengths + i, low);
+                _mm_storeh_pd(lanes[1].arc_lengths + i, low);
+                _mm_storel_pd(lanes[2].arc_lengths + i, high);
+                _mm_storeh_pd(lanes[3].arc_lengths + i, high);
+            }
+            const int mask = _mm256_movemask_pd(degenerate);
+            for (unsigned l = 0; l < 4; l++)
+                lanes[l].degenerate = (mask & (1 << l)) != 0;
+        }
+    }
+#endif
+
+#if defined(FLEXTRACK_BATCH_NEON)
+    //-----------------------------------------------------------------------------------
+    //! \brief Writes one sample of two lanes, interleaving x and y into points
+    //-----------------------------------------------------------------------------------
+    static inline void StoreNEON(Point *first, Point *second, float64x2_t x, float64x2_t y) {
+        vst1q_f64(&first->x, vzip1q_f64(x, y));
+        vst1q_f64(&second->x, vzip2q_f64(x, y));
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief NEON kernel, two curves per operation
+    //-----------------------------------------------------------------------------------
+    static void EvaluateNEON(const BatchKernelArgs &args) {
+        const float64x2_t distance = vdupq_n_f64(args.distance);
+        const float64x2_t one = vdupq_n_f64(1.0);
+        const float64x2_t zero = vdupq_n_f64(0.0);
+        for (unsigned c = 0; c < args.stride; c += 2) {
+            BatchLane &a = args.lanes[c];
+            BatchLane &b = args.lanes[c + 1];
+            const float64x2_t x0 = vld1q_f64(args.control_x[0] + c);
+            const float64x2_t x1 = vld1q_f64(args.control_x[1] + c);
+            const float64x2_t x2 = vld1q_f64(args.control_x[2] + c);
+            const float64x2_t x3 = vld1q_f64(args.control_x[3] + c);
+            const float64x2_t y0 = vld1q_f64(args.control_y[0] + c);
+            const float64x2_t y1 = vld1q_f64(args.control_y[1] + c);
+            const float64x2_t y2 = vld1q_f64(args.control_y[2] + c);
+            const float64x2_t y3 = vld1q_f64(args.control_y[3] + c);
+
+            float64x2_t arc = zero;
+            float64x2_t last_x = x0, last_y = y0;
+            uint64x2_t degenerate = vdupq_n_u64(0);
+            for (unsigned i = 0; i < args.samples; i++) {
+                const double *w = args.weights + i * kWeightsPerSample;
+                float64x2_t px = vaddq_f64(vaddq_f64(vmulq_n_f64(x0, w[0]), vmulq_n_f64(x1, w[1])),
+                                           vaddq_f64(vmulq_n_f64(x2, w[2]), vmulq_n_f64(x3, w[3])));
+                float64x2_t py = vaddq_f64(vaddq_f64(vmulq_n_f64(y0, w[0]), vmulq_n_f64(y1, w[1])),
+                                           vaddq_f64(vmulq_n_f64(y2, w[2]), vmulq_n_f64(y3, w[3])));
+                float64x2_t tx = vaddq_f64(vaddq_f64(vmulq_n_f64(x0, w[4]), vmulq_n_f64(x1, w[5])),
+                                           vaddq_f64(vmulq_n_f64(x2, w[6]), vmulq_n_f64(x3, w[7])));
+                float64x2_t ty = vaddq_f64(vaddq_f64(vmulq_n_f64(y0, w[4]), vmulq_n_f64(y1, w[5])),
+                                           vaddq_f64(vmulq_n_f64(y2, w[6]), vmulq_n_f64(y3, w[7])));
+
+                float64x2_t length = vsqrtq_f64(vaddq_f64(vmulq_f64(tx, tx), vmulq_f64(ty, ty)));
+                float64x2_t inverse = vbslq_f64(vcgtq_f64(length, zero), vdivq_f64(one, length), zero);
+                float64x2_t nx = vmulq_f64(ty, inverse);
+                float64x2_t ny = vnegq_f64(vmulq_f64(tx, inverse));
+                float64x2_t ox = vmulq_f64(nx, distance);
+                float64x2_t oy = vmulq_f64(ny, distance);
+                degenerate = vorrq_u64(degenerate, vceqq_f64(length, zero));
+
+                float64x2_t dx = vsubq_f64(last_x, px);
+                float64x2_t dy = vsubq_f64(last_y, py);
+                arc = vaddq_f64(arc, vsqrtq_f64(vaddq_f64(vmulq_f64(dx, dx), vmulq_f64(dy, dy))));
+                last_x = px;
+                last_y = py;
+
+                StoreNEON(a.points + i, b.points + i, px, py);
+                StoreNEON(a.tangents + i, b.tangents + i, tx, ty);
+                StoreNEON(a.normals + i, b.normals + i, nx, ny);
+                StoreNEON(a.left_rail + i, b.left_rail + i, vaddq_f64(px, ox), vaddq_f64(py, oy));
+                StoreNEON(a.right_rail + i, b.right_rail + i, vsubq_f64(px, ox), vsubq_f64(py, oy));
+                vst1q_lane_f64(a.arc_lengths + i, arc, 0);
+                vst1q_lane_f64(b.arc_lengths + i, arc, 1);
+            }
+            a.degenerate = vgetq_lane_u64(degenerate, 0) != 0;
+            b.degenerate = vgetq_lane_u64(degenerate, 1) != 0;
+        }
+    }
+#endif
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Default constructor
+    //!
+    //! Creates an empty batch using the best kernel supported by the processor
+    //-----------------------------------------------------------------------------------
+    BezierBatch::BezierBatch() :
+            _kernel(DetectKernel()),
+            _resolution(BezierCurve::kDefaultResolution),
+            _parallels_distance(BezierCurve::kDefaultDistance),
+            _size(0),
+            _stride(0),
+            _samples(0) {
+        RecalculateWeights();
+    }
+
+    BezierBatch::~BezierBatch() {
+        //dtor
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the widest kernel supported by the running processor
+    //-----------------------------------------------------------------------------------
+    BatchKernel BezierBatch::DetectKernel() {
+        if (IsKernelSupported(KERNEL_AVX))
+            return KERNEL_AVX;
+        if (IsKernelSupported(KERNEL_SSE2))
+            return KERNEL_SSE2;
+        if (IsKernelSupported(KERNEL_NEON))
+            return KERNEL_NEON;
+        return KERNEL_SCALAR;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Checks whether a kernel was compiled in and can run on this processor
+    //-----------------------------------------------------------------------------------
+    bool BezierBatch::IsKernelSupported(BatchKernel kernel) {
+        switch (kernel) {
+            case KERNEL_SCALAR:
+                return true;
+            case KERNEL_SSE2:
+#if defined(FLEXTRACK_BATCH_X86)
+                return true;
+#else
+                return false;
+#endif
+            case KERNEL_AVX:
+#if defined(FLEXTRACK_BATCH_AVX)
+                return __builtin_cpu_supports("avx");
+#else
+                return false;
+#endif
+            case KERNEL_NEON:
+#if defined(FLEXTRACK_BATCH_NEON)
+                return true;
+#else
+                return false;
+#endif
+        }
+        return false;
+    }
+
+    BatchKernel BezierBatch::GetKernel() const {
+        return _kernel;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Forces a kernel
+    //!
+    //! \param kernel the kernel to use. Unsupported kernels fall back to the scalar
+    //!        kernel.
+    //-----------------------------------------------------------------------------------
+    void BezierBatch::SetKernel(BatchKernel kernel) {
+        _kernel = IsKernelSupported(kernel) ? kernel : KERNEL_SCALAR;
+    }
+
+    float BezierBatch::GetResolution() const {
+        return _resolution;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Sets the resolution shared by every curve in the batch
+    //!
+    //! \param resolution the parameter step, see BezierCurve::SetResolution()
+    //-----------------------------------------------------------------------------------
+    void BezierBatch::SetResolution(float resolution) {
+        assert(resolution > 0.0F && resolution < 1.0F);
+        if (resolution != _resolution) {
+            _resolution = resolution;
+            RecalculateWeights();
+        }
+    }
+
+    double BezierBatch::GetParallelsDistance() const {
+        return _parallels_distance;
+    }
+
+    void BezierBatch::SetParallelsDistance(double distance) {
+        _parallels_distance = distance;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Removes all curves from the batch, keeping the allocated storage
+    //-----------------------------------------------------------------------------------
+    void BezierBatch::Clear() {
+        _size = 0;
+        _stride = 0;
+        for (unsigned i = 0; i < 4; i++) {
+            _control_x[i].clear();
+            _control_y[i].clear();
+        }
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Adds the control points of a curve to the batch
+    //!
+    //! \return the lane index of the curve in the results
+    //-----------------------------------------------------------------------------------
+    unsigned BezierBatch::Add(const BezierCurve &curve) {
+        for (unsigned i = 0; i < 4; i++) {
+            const Point &p = curve.GetControlPoint(i);
+            _control_x[i].push_back(p.x);
+            _control_y[i].push_back(p.y);
+        }
+        return _size++;
+    }
+
+    unsigned BezierBatch::GetSize() const {
+        return _size;
+    }
+
+    unsigned BezierBatch::GetSamples() const {
+        return _samples;
+    }
+
+    unsigned BezierBatch::GetStride() const {
+        return _stride;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Evaluates points, tangents and rails for every curve in the batch
+    //-----------------------------------------------------------------------------------
+    void BezierBatch::Evaluate() {
+        PadLanes();
+        ResizeResults();
+        for (unsigned c = 0; c < _size; c++) {
+            const size_t begin = static_cast<size_t>(c) * _samples;
+            BatchLane &lane = _lanes[c];
+            lane.points = &_points[begin];
+            lane.tangents = &_tangents[begin];
+            lane.normals = &_normals[begin];
+            lane.left_rail = &_left_rail[begin];
+            lane.right_rail = &_right_rail[begin];
+            lane.arc_lengths = &_arc_lengths[begin];
+        }
+        EvaluateLanes();
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Pads the lanes to a whole register so the kernels need no tail loop
+    //!
+    //! The padding lanes evaluate zero control points into a buffer of their own.
+    //-----------------------------------------------------------------------------------
+    void BezierBatch::PadLanes() {
+        _stride = (_size + kLaneWidth - 1) / kLaneWidth * kLaneWidth;
+        for (unsigned i = 0; i < 4; i++) {
+            _control_x[i].resize(_stride, 0.0);
+            _control_y[i].resize(_stride, 0.0);
+        }
+        _lanes.resize(_stride);
+        _padding.resize(5 * _samples);
+        _padding_lengths.resize(_samples);
+        for (unsigned c = _size; c < _stride; c++) {
+            BatchLane &lane = _lanes[c];
+            lane.points = &_padding[0];
+            lane.tangents = &_padding[_samples];
+            lane.normals = &_padding[2 * _samples];
+            lane.left_rail = &_padding[3 * _samples];
+            lane.right_rail = &_padding[4 * _samples];
+            lane.arc_lengths = &_padding_lengths[0];
+        }
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Runs the kernel, writing every sample to the buffers of its lane
+    //-----------------------------------------------------------------------------------
+    void BezierBatch::EvaluateLanes() {
+        ScopedTimer timer(STAT_TIMER_RECALCULATE_CURVE);
+        FT_TRACE2(TRACE_GEOMETRY, "evaluate batch", _size, _samples);
+
+        BatchKernelArgs args;
+        for (unsigned i = 0; i < 4; i++) {
+            args.control_x[i] = _control_x[i].data();
+            args.control_y[i] = _control_y[i].data();
+        }
+        args.weights = _weights.data();
+        args.lanes = _lanes.data();
+        args.stride = _stride;
+        args.samples = _samples;
+        args.distance = _parallels_distance;
+
+        switch (_kernel) {
+#if defined(FLEXTRACK_BATCH_AVX)
+            case KERNEL_AVX:
+                EvaluateAVX(args);
+                break;
+#endif
+#if defined(FLEXTRACK_BATCH_X86)
+            case KERNEL_SSE2:
+                EvaluateSSE2(args);
+                break;
+#endif
+#if defined(FLEXTRACK_BATCH_NEON)
+            case KERNEL_NEON:
+                EvaluateNEON(args);
+                break;
+#endif
+            default:
+                EvaluateScalar(args);
+                break;
+        }
+        RecalculateLimitNormals();
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Replaces the zero normals the kernels leave where a tangent vanishes
+    //!
+    //! Takes the limit direction as BezierCurve does, so both produce the same rails
+    //! where a handle coincides with its end. Only the lanes the kernel flagged are
+    //! scanned.
+    //-----------------------------------------------------------------------------------
+    void BezierBatch::RecalculateLimitNormals() {
+        for (unsigned c = 0; c < _size; c++) {
+            BatchLane &lane = _lanes[c];
+            if (!lane.degenerate)
+                continue;
+
+            Point points[4];
+            for (unsigned p = 0; p < 4; p++)
+                points[p] = Point(_control_x[p][c], _control_y[p][c]);
+            for (unsigned i = 0; i < _samples; i++) {
+                if (lane.tangents[i].x != 0.0 || lane.tangents[i].y != 0.0)
+                    continue;
+                const Point normal = BezierCurve::GetLimitNormal(points, _parameters[i]);
+                const Point &center = lane.points[i];
+                lane.normals[i] = normal;
+                lane.left_rail[i] = Point(center.x + normal.x * _parallels_distance,
+                                          center.y + normal.y * _parallels_distance);
+                lane.right_rail[i] = Point(center.x - normal.x * _parallels_distance,
+                                           center.y - normal.y * _parallels_distance);
+            }
+        }
+    }
+
+    Point BezierBatch::GetPoint(unsigned curve, unsigned sample) const {
+        return _points[curve * _samples + sample];
+    }
+
+    Point BezierBatch::GetTangent(unsigned curve, unsigned sample) const {
+        return _tangents[curve * _samples + sample];
+    }
+
+    Point BezierBatch::GetNormal(unsigned curve, unsigned sample) const {
+        return _normals[curve * _samples + sample];
+    }
+
+    Point BezierBatch::GetLeftRail(unsigned curve, unsigned sample) const {
+        return _left_rail[curve * _samples + sample];
+    }
+
+    Point BezierBatch::GetRightRail(unsigned curve, unsigned sample) const {
+        return _right_rail[curve * _samples + sample];
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Copies the results for one lane into a curve
+    //!
+    //! The samples of a lane are contiguous, so this is a sequential copy per buffer.
+    //! The curve is marked as up to date so that the next call to GetCurve() returns
+    //! the batch results without recalculating.
+    //!
+    //! \param curve the lane index returned by Add()
+    //! \param target the curve that was added at that lane. Its resolution must match
+    //!        the batch resolution.
+    //-----------------------------------------------------------------------------------
+    void BezierBatch::Store(unsigned curve, BezierCurve &target) const {
+        assert(curve < _size);
+        assert(target._resolution == _resolution);
+
+        if (target._resolution_modified || target._curve_points.size() != _samples)
+            target.ResizeCurve();
+        assert(target._curve_points.size() == _samples);
+
+        const size_t begin = static_cast<size_t>(curve) * _samples;
+        const size_t end = begin + _samples;
+        std::copy(_points.begin() + begin, _points.begin() + end, target._curve_points.begin());
+        std::copy(_tangents.begin() + begin, _tangents.begin() + end, target._tangent_points.begin());
+        std::copy(_normals.begin() + begin, _normals.begin() + end, target._normal_points.begin());
+        std::copy(_left_rail.begin() + begin, _left_rail.begin() + end, target._top_left_points.begin());
+        std::copy(_right_rail.begin() + begin, _right_rail.begin() + end, target._bottom_right_points.begin());
+        std::copy(_arc_lengths.begin() + begin, _arc_lengths.begin() + end, target._arc_lengths.begin());
+        Finish(target);
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Points a lane at the buffers of a curve, so the kernel writes its samples
+    //!        in place
+    //-----------------------------------------------------------------------------------
+    void BezierBatch::Target(unsigned curve, BezierCurve &target) {
+        assert(target._resolution == _resolution);
+        if (target._resolution_modified || target._curve_points.size() != _samples)
+            target.ResizeCurve();
+        assert(target._curve_points.size() == _samples);
+
+        BatchLane &lane = _lanes[curve];
+        lane.points = target._curve_points.data();
+        lane.tangents = target._tangent_points.data();
+        lane.normals = target._normal_points.data();
+        lane.left_rail = target._top_left_points.data();
+        lane.right_rail = target._bottom_right_points.data();
+        lane.arc_lengths = target._arc_lengths.data();
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Completes a curve whose samples the batch has written
+    //!
+    //! The parameters are those of the shared grid and the length is the last arc
+    //! length, so nothing is recalculated per sample.
+    //-----------------------------------------------------------------------------------
+    void BezierBatch::Finish(BezierCurve &target) const {
+        for (unsigned i = 0; i < BezierCurve::kDerivativeControlPoints; i++) {
+            target.m_derivative_ctrl_pts[i].x = 3.0F * (target._control_points[i + 1].x - target._control_points[i].x);
+            target.m_derivative_ctrl_pts[i].y = 3.0F * (target._control_points[i + 1].y - target._control_points[i].y);
+        }
+        std::copy(_parameters.begin(), _parameters.end(), target._parameters.begin());
+        target._curve_length = target._arc_lengths.back();
+
+        ++target._revision;
+        target._control_point_modified = false;
+        target._resolution_modified = false;
+        target._parallels_modified = false;
+        Stats::GetInstance().Add(STAT_CURVES_RECALCULATED, 1);
+        Stats::GetInstance().Add(STAT_POINTS_EMITTED, 3 * _samples);
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Recalculates every modified curve in a collection
+    //!
+    //! Modified curves are grouped by resolution and parallels distance and each group
+    //! is evaluated in batches of at most kMaximumBatch curves, the kernel writing
+    //! straight into the buffers of the curves. Groups too small to benefit, curves
+    //! set to the reference evaluation mode and curves that are not sampled uniformly
+    //! are recalculated by the curve itself.
+    //!
+    //! \param curves the curves to bring up to date
+    //-----------------------------------------------------------------------------------
+    void BezierBatch::Recalculate(std::vector<std::shared_ptr<BezierCurve>> &curves) {
+        _pending.clear();
+        for (auto &curve : curves)
+            Collect(*curve);
+        RecalculatePending();
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Recalculates every modified curve of a store, like the collection of
+    //!        shared curves above
+    //-----------------------------------------------------------------------------------
+    void BezierBatch::Recalculate(SegmentStore &curves) {
+        _pending.clear();
+        for (BezierCurve &curve : curves)
+            Collect(curve);
+        RecalculatePending();
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Queues a modified curve for the batches, or recalculates it right away
+    //!        if the batches cannot evaluate it
+    //-----------------------------------------------------------------------------------
+    void BezierBatch::Collect(BezierCurve &curve) {
+        if (!curve.IsModified())
+            return;
+        if (curve.GetEvaluationMode() == EVAL_REFERENCE || curve.GetSamplingMode() != SAMPLE_UNIFORM)
+            curve.Update();
+        else
+            _pending.push_back(&curve);
+    }
+
+    void BezierBatch::RecalculatePending() {
+        auto begin = _pending.begin();
+        while (begin != _pending.end()) {
+            const float resolution = (*begin)->_resolution;
+            const float distance = (*begin)->_parallels_distance;
+            auto end = std::partition(begin, _pending.end(),
+                    [resolution, distance](const BezierCurve *curve) {
+                        return curve->_resolution == resolution && curve->_parallels_distance == distance;
+                    });
+
+            if (end - begin < static_cast<std::ptrdiff_t>(kMinimumBatch)) {
+                for (auto itr = begin; itr != end; ++itr)
+                    (*itr)->Update();
+            } else {
+                SetResolution(resolution);
+                SetParallelsDistance(distance);
+                while (begin != end) {
+                    auto last = end - begin > static_cast<std::ptrdiff_t>(kMaximumBatch) ?
+                                begin + kMaximumBatch : end;
+                    Clear();
+                    for (auto itr = begin; itr != last; ++itr)
+                        Add(**itr);
+                    PadLanes();
+                    unsigned lane = 0;
+                    for (auto itr = begin; itr != last; ++itr)
+                        Target(lane++, **itr);
+                    EvaluateLanes();
+                    for (auto itr = begin; itr != last; ++itr)
+                        Finish(**itr);
+                    begin = last;
+                }
+            }
+            begin = end;
+        }
+        _pending.clear();
+    }
+
+    void BezierBatch::ResizeResults() {
+        const size_t size = static_cast<size_t>(_samples) * _size;
+        _points.resize(size);
+        _tangents.resize(size);
+        _normals.resize(size);
+        _left_rail.resize(size);
+        _right_rail.resize(size);
+        _arc_lengths.resize(size);
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Builds the Bernstein weights and the parameters for the sample grid
+    //!
+    //! The grid matches BezierCurve: samples are spaced by the resolution with the
+    //! final sample placed exactly at t = 1.
+    //-----------------------------------------------------------------------------------
+    void BezierBatch::RecalculateWeights() {
+        _samples = (unsigned) (1.0F / _resolution + 1);
+        _weights.resize(_samples * kWeightsPerSample);
+        _parameters.resize(_samples);
+        for (unsigned i = 0; i < _samples; i++) {
+            double t = (i == _samples - 1) ? 1.0 : static_cast<double>(_resolution) * i;
+            double s = 1.0 - t;
+            double *w = &_weights[i * kWeightsPerSample];
+            _parameters[i] = t;
+            // position
+            w[0] = s * s * s;
+            w[1] = 3.0 * s * s * t;
+            w[2] = 3.0 * s * t * t;
+            w[3] = t * t * t;
+            // derivative
+            w[4] = -3.0 * s * s;
+            w[5] = 3.0 * s * s - 6.0 * s * t;
+            w[6] = 6.0 * s * t - 3.0 * t * t;
+            w[7] = 3.0 * t * t;
+        }
+    }
+}
@@ -1,11 +1,135 @@
 #include "BezierCurve.h"
+#include "BezierCurveT.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <iostream>
+#include <limits>
+
+#include "Stats.h"
+#include "Trace.h"
 
 namespace ByteTrail {
 
+    //-----------------------------------------------------------------------------------
+    //! \brief Power basis form of a cubic, B(t) = a*t^3 + b*t^2 + c*t + d
+    //-----------------------------------------------------------------------------------
+    struct PowerBasis {
+        Point a, b, c, d;
+
+        explicit PowerBasis(const Point *p) {
+            a.x = -p[0].x + 3.0 * p[1].x - 3.0 * p[2].x + p[3].x;
+            a.y = -p[0].y + 3.0 * p[1].y - 3.0 * p[2].y + p[3].y;
+            b.x = 3.0 * p[0].x - 6.0 * p[1].x + 3.0 * p[2].x;
+            b.y = 3.0 * p[0].y - 6.0 * p[1].y + 3.0 * p[2].y;
+            c.x = 3.0 * (p[1].x - p[0].x);
+            c.y = 3.0 * (p[1].y - p[0].y);
+            d.x = p[0].x;
+            d.y = p[0].y;
+        }
+
+        inline Point Evaluate(double t) const {
+            return Point(((a.x * t + b.x) * t + c.x) * t + d.x,
+                         ((a.y * t + b.y) * t + c.y) * t + d.y);
+        }
+
+        inline Point EvaluateDerivative(double t) const {
+            return Point((3.0 * a.x * t + 2.0 * b.x) * t + c.x,
+                         (3.0 * a.y * t + 2.0 * b.y) * t + c.y);
+        }
+
+        inline Point EvaluateSecondDerivative(double t) const {
+            return Point(6.0 * a.x * t + 2.0 * b.x, 6.0 * a.y * t + 2.0 * b.y);
+        }
+
+        //! \brief Gets the curvature at a parameter
+        //!
+        //! About a parameter t0 where the speed is zero the derivative is exactly
+        //! (t - t0) * d2 + (t - t0)^2 / 2 * d3, d2 and d3 being the second and third
+        //! derivatives at t0. With those parallel the curve keeps to a straight line
+        //! and the limit is 0, otherwise t0 is a cusp and the curvature infinite.
+        inline double GetCurvature(double t) const {
+            Point d1 = EvaluateDerivative(t);
+            Point d2 = EvaluateSecondDerivative(t);
+            double speed = std::sqrt(d1.x * d1.x + d1.y * d1.y);
+            if (speed == 0.0) {
+                Point d3(6.0 * a.x, 6.0 * a.y);
+                double cross = d2.x * d3.y - d2.y * d3.x;
+                double scale = std::sqrt((d2.x * d2.x + d2.y * d2.y) * (d3.x * d3.x + d3.y * d3.y));
+                return std::abs(cross) <= kParallelTolerance * scale ? 0.0 : std::numeric_limits<double>::infinity();
+            }
+            return std::abs(d1.x * d2.y - d1.y * d2.x) / (speed * speed * speed);
+        }
+
+        //! relative size of a cross product below which two vectors are parallel
+        static constexpr double kParallelTolerance = 1e-9;
+    };
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Tells if the control points of a cubic lie on one line, the curve then
+    //!        never turns whatever its handles
+    //-----------------------------------------------------------------------------------
+    static bool IsCollinear(const Point *p) {
+        // the control point farthest from the first gives the direction of the line
+        Point direction(0.0, 0.0);
+        double length = 0.0;
+        for (unsigned i = 1; i < 4; i++) {
+            Point d(p[i].x - p[0].x, p[i].y - p[0].y);
+            double square = d.x * d.x + d.y * d.y;
+            if (square > length) {
+                direction = d;
+                length = square;
+            }
+        }
+        for (unsigned i = 1; i < 4; i++) {
+            double cross = direction.x * (p[i].y - p[0].y) - direction.y * (p[i].x - p[0].x);
+            if (std::abs(cross) > PowerBasis::kParallelTolerance * length)
+                return false;
+        }
+        return true;
+    }
+
+    // 5 point Gauss-Legendre rule on [-1, 1]
+    static const double kGaussNodes[] = {0.0, -0.5384693101056831, 0.5384693101056831,
+                                         -0.9061798459386640, 0.9061798459386640};
+    static const double kGaussWeights[] = {0.5688888888888889, 0.4786286704993665, 0.4786286704993665,
+                                           0.2369268850561891, 0.2369268850561891};
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Widens a range by the extrema of one coordinate of a cubic
+    //!
+    //! The extrema are the roots of the derivative 3a*t^2 + 2b*t + c inside (0, 1).
+    //-----------------------------------------------------------------------------------
+    static void AddExtrema(double a, double b, double c, double d, double &min, double &max) {
+        double roots[2];
+        unsigned count = 0;
+        const double qa = 3.0 * a;
+        const double qb = 2.0 * b;
+        if (std::abs(qa) < 1e-12) {
+            if (std::abs(qb) > 1e-12)
+                roots[count++] = -c / qb;
+        } else {
+            double discriminant = qb * qb - 4.0 * qa * c;
+            if (discriminant >= 0.0) {
+                double root = std::sqrt(discriminant);
+                roots[count++] = (-qb + root) / (2.0 * qa);
+                roots[count++] = (-qb - root) / (2.0 * qa);
+            }
+        }
+        for (unsigned i = 0; i < count; i++) {
+            const double t = roots[i];
+            if (t > 0.0 && t < 1.0) {
+                double value = ((a * t + b) * t + c) * t + d;
+                min = std::min(min, value);
+                max = std::max(max, value);
+            }
+        }
+    }
+
+    constexpr float BezierCurve::kDefaultResolution;
+    constexpr float BezierCurve::kDefaultDistance;
+
     //-----------------------------------------------------------------------------------
     //! \brief Default constructor
     //!
@@ -15,9 +139,19 @@ namespace ByteTrail {
             _resolution(kDefaultResolution),
             _length(kDefaultLength),
             _fixed_length(false),
-            _parallels_distance(kDefaultDistance) {
+            _parallels_distance(kDefaultDistance),
+            _evaluation_mode(EVAL_FORWARD_DIFFERENCE),
+            _sampling_mode(SAMPLE_UNIFORM),
+            _curve_length(0.0),
+            _tolerance(kDefaultTolerance),
+            _revision(0) {
         _resolution_modified = true;
         _control_point_modified = true;
+        _parallels_modified = false;
+        _properties.bounds_revision = kNoRevision;
+        _properties.length_revision = kNoRevision;
+        _properties.radius_revision = kNoRevision;
+        RecalculateBounds();
     }
 
     BezierCurve::~BezierCurve() {
@@ -54,22 +188,129 @@ namespace ByteTrail {
         }
     }
 
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the distance of the rails from the centerline
+    //-----------------------------------------------------------------------------------
+    float BezierCurve::GetParallelsDistance() const {
+        return _parallels_distance;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Sets the distance of the rails from the centerline
+    //!
+    //! Only the rails are recalculated when nothing else changed.
+    //!
+    //! \param distance the offset of each rail from the centerline
+    //-----------------------------------------------------------------------------------
+    void BezierCurve::SetParallelsDistance(float distance) {
+        if (distance != _parallels_distance) {
+            _parallels_distance = distance;
+            _parallels_modified = true;
+            RecalculateBounds();
+        }
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the evaluation mode
+    //!
+    //! \return the strategy used to evaluate the curve points and tangents
+    //-----------------------------------------------------------------------------------
+    EvaluationMode BezierCurve::GetEvaluationMode() const {
+        return _evaluation_mode;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Sets the evaluation mode
+    //!
+    //! EVAL_FORWARD_DIFFERENCE steps through the sample grid incrementally and is the
+    //! default. EVAL_REFERENCE evaluates every sample directly from the Bernstein
+    //! polynomials and is retained to validate the incremental engine. The mode
+    //! applies to uniform sampling; arc length sampling always evaluates each sample
+    //! directly.
+    //!
+    //! \param mode the evaluation strategy for subsequent recalculations
+    //-----------------------------------------------------------------------------------
+    void BezierCurve::SetEvaluationMode(EvaluationMode mode) {
+        if (mode != _evaluation_mode) {
+            _evaluation_mode = mode;
+            _control_point_modified = true;
+        }
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the sampling mode
+    //!
+    //! \return the distribution of the samples along the curve
+    //-----------------------------------------------------------------------------------
+    SamplingMode BezierCurve::GetSamplingMode() const {
+        return _sampling_mode;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Sets the sampling mode
+    //!
+    //! SAMPLE_UNIFORM spaces the samples by the resolution in the curve parameter,
+    //! so the distance between points varies with curvature. SAMPLE_ARC_LENGTH keeps
+    //! the same number of samples but spaces them evenly along the curve, which
+    //! avoids faceting in tight curves without raising the sample count.
+    //!
+    //! \param mode the sample distribution for subsequent recalculations
+    //-----------------------------------------------------------------------------------
+    void BezierCurve::SetSamplingMode(SamplingMode mode) {
+        if (mode != _sampling_mode) {
+            _sampling_mode = mode;
+            _control_point_modified = true;
+        }
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the tolerance for adaptive sampling
+    //!
+    //! \return the maximum distance between the curve and its polyline
+    //-----------------------------------------------------------------------------------
+    double BezierCurve::GetTolerance() const {
+        return _tolerance;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Sets the tolerance for adaptive sampling
+    //!
+    //! With SAMPLE_ADAPTIVE the curve is subdivided until the polyline between
+    //! consecutive samples is no further than the tolerance from the curve, so
+    //! straight runs need only a few points and the points are spent where the
+    //! curvature is high. Callers drawing at a scale typically pass the allowed
+    //! error in pixels divided by that scale.
+    //!
+    //! \param tolerance the maximum distance in curve units, greater than 0.0
+    //-----------------------------------------------------------------------------------
+    void BezierCurve::SetTolerance(double tolerance) {
+        assert(tolerance > 0.0);
+        if (tolerance != _tolerance) {
+            _tolerance = tolerance;
+            if (_sampling_mode == SAMPLE_ADAPTIVE)
+                _control_point_modified = true;
+        }
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the number of points in the curve and in each rail
+    //-----------------------------------------------------------------------------------
+    unsigned BezierCurve::GetPointCount() {
+        Update();
+        return _curve_points.size();
+    }
+
     //-----------------------------------------------------------------------------------
     //! \brief Gets the length of the curve
+    //!
+    //! The length is cached when the curve is recalculated.
     //!
     //! \return the length of the curve approximated by the line segments that make up
     //!         the curve
     //-----------------------------------------------------------------------------------
     const double BezierCurve::GetLength() {
-        double len = 0.0;
-
-        const std::vector<Point> &points = GetCurve(0);
-        Point &prev = const_cast<Point &>(points[0]);
-        for(auto itr = points.begin()+1; itr != points.end(); ++itr) {
-            len += prev.Distance(*itr);
-            prev = const_cast<Point &>(*itr);
-        }
-        return len;
+        Update();
+        return _curve_length;
     }
 
     const Point & BezierCurve::GetControlPoint(int index) const {
@@ -88,6 +329,7 @@ namespace ByteTrail {
             _control_point_modified = true;
             _control_points[index].x = x;
             _control_points[index].y = y;
+            RecalculateBounds();
         }
     }
 
@@ -104,11 +346,350 @@ namespace ByteTrail {
                 _control_points[i].x += cx;
                 _control_points[i].y += cy;
             }
+            _bounds.x += cx;
+            _bounds.y += cy;
             _control_point_modified = true;
         }
     }
 
-    const std::vector<Point> &BezierCurve::GetCurve(unsigned idx) {
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the bounding box of the curve
+    //!
+    //! A bezier curve lies inside the convex hull of its control points, so the box
+    //! around the control points grown by the rail distance encloses the centerline,
+    //! both rails and the control handles. The box is kept up to date as control
+    //! points change and does not require the curve to be recalculated.
+    //!
+    //! \return the bounding box in curve coordinates
+    //-----------------------------------------------------------------------------------
+    const Rect & BezierCurve::GetBounds() const {
+        return _bounds;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the smallest box around the curve and its rails
+    //!
+    //! Found from the end points and the points where the derivative of either
+    //! coordinate is zero, then grown by the rail distance. Much closer than
+    //! GetBounds() on curves with long control handles, but only valid once the
+    //! curve is up to date, so it is computed on first use after each change.
+    //-----------------------------------------------------------------------------------
+    const Rect &BezierCurve::GetTightBounds() {
+        Update();
+        if (_properties.bounds_revision != _revision) {
+            const PowerBasis basis(_control_points);
+            double min_x = std::min(_control_points[0].x, _control_points[3].x);
+            double max_x = std::max(_control_points[0].x, _control_points[3].x);
+            double min_y = std::min(_control_points[0].y, _control_points[3].y);
+            double max_y = std::max(_control_points[0].y, _control_points[3].y);
+            AddExtrema(basis.a.x, basis.b.x, basis.c.x, basis.d.x, min_x, max_x);
+            AddExtrema(basis.a.y, basis.b.y, basis.c.y, basis.d.y, min_y, max_y);
+
+            Rect &bounds = _properties.bounds;
+            bounds.x = min_x - _parallels_distance;
+            bounds.y = min_y - _parallels_distance;
+            bounds.width = (max_x - min_x) + 2.0 * _parallels_distance;
+            bounds.height = (max_y - min_y) + 2.0 * _parallels_distance;
+            _properties.bounds_revision = _revision;
+        }
+        return _properties.bounds;
+    }
+
+    void BezierCurve::RecalculateBounds() {
+        double min_x = _control_points[0].x;
+        double max_x = min_x;
+        double min_y = _control_points[0].y;
+        double max_y = min_y;
+        for(unsigned i = 1; i < kControlPoints; i++) {
+            min_x = std::min(min_x, _control_points[i].x);
+            max_x = std::max(max_x, _control_points[i].x);
+            min_y = std::min(min_y, _control_points[i].y);
+            max_y = std::max(max_y, _control_points[i].y);
+        }
+        _bounds.x = min_x - _parallels_distance;
+        _bounds.y = min_y - _parallels_distance;
+        _bounds.width = (max_x - min_x) + 2.0 * _parallels_distance;
+        _bounds.height = (max_y - min_y) + 2.0 * _parallels_distance;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Evaluates the curve at a parameter value
+    //!
+    //! \param t the curve parameter from 0.0 to 1.0
+    //! \return the point on the curve
+    //-----------------------------------------------------------------------------------
+    Point BezierCurve::Evaluate(double t) const {
+        return PowerBasis(_control_points).Evaluate(t);
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Evaluates the first derivative of the curve at a parameter value
+    //!
+    //! \param t the curve parameter from 0.0 to 1.0
+    //! \return the tangent vector, not normalized
+    //-----------------------------------------------------------------------------------
+    Point BezierCurve::EvaluateDerivative(double t) const {
+        return PowerBasis(_control_points).EvaluateDerivative(t);
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the curve parameter at a distance along the curve
+    //!
+    //! The arc length table built when the curve is recalculated is searched with a
+    //! binary search and the parameter interpolated between the bracketing samples,
+    //! so the query is O(log n) in the number of samples. The interpolated parameter
+    //! is then refined with Newton steps on the chord length from the previous
+    //! sample, since the curve speed varies within a sample interval.
+    //!
+    //! \param distance the distance from control point 0, clamped to the curve length
+    //! \return the curve parameter t
+    //-----------------------------------------------------------------------------------
+    double BezierCurve::GetParameterAtDistance(double distance) {
+        Update();
+        if (distance <= 0.0)
+            return 0.0;
+        if (distance >= _curve_length)
+            return 1.0;
+
+        auto upper = std::upper_bound(_arc_lengths.begin(), _arc_lengths.end(), distance);
+        size_t idx = upper - _arc_lengths.begin();
+        double s0 = _arc_lengths[idx - 1];
+        double s1 = _arc_lengths[idx];
+        double t0 = _parameters[idx - 1];
+        double t1 = _parameters[idx];
+        double t = t0 + (t1 - t0) * (distance - s0) / (s1 - s0);
+
+        const PowerBasis basis(_control_points);
+        const Point &start = _curve_points[idx - 1];
+        for (unsigned i = 0; i < kDistanceRefinements; i++) {
+            Point d = basis.EvaluateDerivative(t);
+            double speed = std::sqrt(d.x * d.x + d.y * d.y);
+            if (speed == 0.0)
+                break;
+            double error = s0 + start.Distance(basis.Evaluate(t)) - distance;
+            t = std::min(t1, std::max(t0, t - error / speed));
+        }
+        return t;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the point at a distance along the curve
+    //!
+    //! \param distance the distance from control point 0, clamped to the curve length
+    //! \return the point on the curve
+    //-----------------------------------------------------------------------------------
+    Point BezierCurve::GetPointAtDistance(double distance) {
+        return Evaluate(GetParameterAtDistance(distance));
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the direction of the curve at a distance along the curve
+    //!
+    //! \param distance the distance from control point 0, clamped to the curve length
+    //! \return the unit tangent vector
+    //-----------------------------------------------------------------------------------
+    Point BezierCurve::GetTangentAtDistance(double distance) {
+        const double t = GetParameterAtDistance(distance);
+        Point tangent = EvaluateDerivative(t);
+        double dist = std::sqrt(tangent.x * tangent.x + tangent.y * tangent.y);
+        if (dist == 0.0) {
+            const Point normal = GetLimitNormal(_control_points, t);
+            return Point(-normal.y, normal.x);
+        }
+        tangent.x /= dist;
+        tangent.y /= dist;
+        return tangent;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the normal of the curve at a distance along the curve
+    //!
+    //! Interpolated between the cached normals of the samples around the distance.
+    //! The interpolated vector is brought back to unit length by one Newton step
+    //! instead of a square root, leaving an error of a few parts per million for
+    //! the angles between neighbouring samples. Where the normals of the samples
+    //! differ too much for that, as around a cusp, the square root is taken.
+    //!
+    //! \param distance the distance from control point 0, clamped to the curve length
+    //! \return the unit normal to the left of the direction of travel
+    //-----------------------------------------------------------------------------------
+    Point BezierCurve::GetNormalAtDistance(double distance) {
+        Update();
+        if (distance <= 0.0)
+            return _normal_points.front();
+        if (distance >= _curve_length)
+            return _normal_points.back();
+
+        auto upper = std::upper_bound(_arc_lengths.begin(), _arc_lengths.end(), distance);
+        size_t idx = upper - _arc_lengths.begin();
+        double s0 = _arc_lengths[idx - 1];
+        double s1 = _arc_lengths[idx];
+        double f = s1 > s0 ? (distance - s0) / (s1 - s0) : 0.0;
+        const Point &n0 = _normal_points[idx - 1];
+        const Point &n1 = _normal_points[idx];
+        Point normal(n0.x + (n1.x - n0.x) * f, n0.y + (n1.y - n0.y) * f);
+        const double square = normal.x * normal.x + normal.y * normal.y;
+        double scale = 1.5 - 0.5 * square;
+        if (std::abs(square - 1.0) > kNormalTolerance) {
+            if (square == 0.0)
+                return f < 0.5 ? n0 : n1;
+            scale = 1.0 / std::sqrt(square);
+        }
+        normal.x *= scale;
+        normal.y *= scale;
+        return normal;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the length of the curve itself rather than of its polyline
+    //!
+    //! Integrates the speed with a 5 point Gauss-Legendre rule over kLengthIntervals
+    //! equal parameter intervals. GetLength() is the length of the samples, which is
+    //! what distances along the curve are measured in, and always a little shorter.
+    //-----------------------------------------------------------------------------------
+    double BezierCurve::GetExactLength() {
+        Update();
+        if (_properties.length_revision != _revision) {
+            const PowerBasis basis(_control_points);
+            const double half = 0.5 / kLengthIntervals;
+            double length = 0.0;
+            for (unsigned interval = 0; interval < kLengthIntervals; interval++) {
+                const double middle = (2 * interval + 1) * half;
+                for (unsigned i = 0; i < 5; i++) {
+                    Point d = basis.EvaluateDerivative(middle + half * kGaussNodes[i]);
+                    length += kGaussWeights[i] * std::sqrt(d.x * d.x + d.y * d.y);
+                }
+            }
+            _properties.length = length * half;
+            _properties.length_revision = _revision;
+        }
+        return _properties.length;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the smallest radius of curvature along the curve
+    //!
+    //! The sample with the largest curvature brackets the maximum, which is then
+    //! refined by a golden section search between its neighbours.
+    //!
+    //! \return the radius, infinite for a straight curve whatever its handles and 0
+    //!         where the curvature is unbounded, at a cusp or at a bent end whose
+    //!         handle coincides with it
+    //-----------------------------------------------------------------------------------
+    double BezierCurve::GetMinimumRadius() {
+        Update();
+        if (_properties.radius_revision != _revision) {
+            _properties.radius = std::numeric_limits<double>::infinity();
+            _properties.radius_revision = _revision;
+            if (IsCollinear(_control_points))
+                return _properties.radius;
+
+            const PowerBasis basis(_control_points);
+            const size_t last = _parameters.size() - 1;
+            size_t best = 0;
+            double curvature = basis.GetCurvature(_parameters[0]);
+            for (size_t idx = 1; idx <= last; ++idx) {
+                double value = basis.GetCurvature(_parameters[idx]);
+                if (value > curvature) {
+                    curvature = value;
+                    best = idx;
+                }
+            }
+
+            const double ratio = 0.6180339887498949;
+            double t0 = _parameters[best > 0 ? best - 1 : 0];
+            double t1 = _parameters[best < last ? best + 1 : last];
+            double a = t1 - ratio * (t1 - t0);
+            double b = t0 + ratio * (t1 - t0);
+            double ka = basis.GetCurvature(a);
+            double kb = basis.GetCurvature(b);
+            for (unsigned i = 0; i < kRadiusRefinements && std::isfinite(curvature); i++) {
+                if (ka > kb) {
+                    t1 = b;
+                    b = a;
+                    kb = ka;
+                    a = t1 - ratio * (t1 - t0);
+                    ka = basis.GetCurvature(a);
+                } else {
+                    t0 = a;
+                    a = b;
+                    ka = kb;
+                    b = t0 + ratio * (t1 - t0);
+                    kb = basis.GetCurvature(b);
+                }
+            }
+            curvature = std::max(curvature, std::max(ka, kb));
+            _properties.radius = curvature > 0.0 ? 1.0 / curvature : std::numeric_limits<double>::infinity();
+            _properties.radius_revision = _revision;
+        }
+        return _properties.radius;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the parameter of the point of the curve closest to a location
+    //!
+    //! The closest sample is refined with Newton steps on the derivative of the
+    //! squared distance, kept between the neighbouring samples.
+    //!
+    //! \param location the location in curve coordinates
+    //! \return the curve parameter t
+    //-----------------------------------------------------------------------------------
+    double BezierCurve::GetClosestParameter(const Point &location) {
+        Update();
+        const size_t last = _curve_points.size() - 1;
+        size_t best = 0;
+        double closest = std::numeric_limits<double>::max();
+        for (size_t idx = 0; idx <= last; ++idx) {
+            double dx = _curve_points[idx].x - location.x;
+            double dy = _curve_points[idx].y - location.y;
+            double distance = dx * dx + dy * dy;
+            if (distance < closest) {
+                closest = distance;
+                best = idx;
+            }
+        }
+
+        const PowerBasis basis(_control_points);
+        const double t0 = _parameters[best > 0 ? best - 1 : 0];
+        const double t1 = _parameters[best < last ? best + 1 : last];
+        double t = _parameters[best];
+        for (unsigned i = 0; i < kClosestRefinements; i++) {
+            Point p = basis.Evaluate(t);
+            Point d1 = basis.EvaluateDerivative(t);
+            Point d2 = basis.EvaluateSecondDerivative(t);
+            double dx = p.x - location.x;
+            double dy = p.y - location.y;
+            double slope = dx * d1.x + dy * d1.y;
+            double change = d1.x * d1.x + d1.y * d1.y + dx * d2.x + dy * d2.y;
+            if (change <= 0.0)
+                break;
+            t = std::min(t1, std::max(t0, t - slope / change));
+        }
+        return t;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the point of the curve closest to a location
+    //-----------------------------------------------------------------------------------
+    Point BezierCurve::GetClosestPoint(const Point &location) {
+        return Evaluate(GetClosestParameter(location));
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Checks whether the curve must be recalculated before it is rendered
+    //-----------------------------------------------------------------------------------
+    bool BezierCurve::IsModified() const {
+        return _control_point_modified || _resolution_modified || _parallels_modified;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Recalculates the curve if the control points, resolution or rail distance
+    //!        have changed
+    //!
+    //! All point buffers are sized when the resolution changes and reused afterwards,
+    //! so recalculating after a control point change does not allocate.
+    //-----------------------------------------------------------------------------------
+    void BezierCurve::Update() {
         if (_resolution_modified) {
             ResizeCurve();
             RecalculateCurve();
@@ -116,34 +697,154 @@ namespace ByteTrail {
         else if (_control_point_modified) {
             RecalculateCurve();
         }
+        else if (_parallels_modified) {
+            RecalculateParallels(_parallels_distance);
+            ++_revision;
+        }
         _control_point_modified = false;
         _resolution_modified = false;
+        _parallels_modified = false;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets one of the cached point buffers of the curve
+    //!
+    //! \param idx the CurveLine to return: 0 for the centerline, 1 for the left rail
+    //!        and 2 for the right rail
+    //! \return the points, owned by the curve and valid until the resolution changes
+    //-----------------------------------------------------------------------------------
+    const std::vector<Point> &BezierCurve::GetCurve(unsigned idx) {
+        Update();
 
-        std::vector<Point> &points = _curve_points;
         switch (idx) {
-            case 0:
-                // curve points already assigned
-                break;
-            case 1:
-                points = _top_left_points;
-                break;
-            case 2:
-                points = _bottom_right_points;
-                break;
+            case CURVE_LEFT_RAIL:
+                return _top_left_points;
+            case CURVE_RIGHT_RAIL:
+                return _bottom_right_points;
+            default:
+                return _curve_points;
+        }
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the revision of the cached curve points
+    //!
+    //! The revision is incremented every time the curve is recalculated, so callers
+    //! that derive data from the curve points can tell whether that data is stale by
+    //! comparing the revision after calling Update().
+    //-----------------------------------------------------------------------------------
+    unsigned long BezierCurve::GetRevision() const {
+        return _revision;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets a view of the curve centerline without copying it
+    //-----------------------------------------------------------------------------------
+    PointView BezierCurve::GetCenterline() {
+        Update();
+        return PointView(_curve_points);
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets a view of the left rail without copying it
+    //!
+    //! The left rail is offset from the centerline by the parallels distance to the
+    //! left of the direction of travel from control point 0 to control point 3.
+    //-----------------------------------------------------------------------------------
+    PointView BezierCurve::GetLeftRail() {
+        Update();
+        return PointView(_top_left_points);
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets a view of the right rail without copying it
+    //-----------------------------------------------------------------------------------
+    PointView BezierCurve::GetRightRail() {
+        Update();
+        return PointView(_bottom_right_points);
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets a view of the unit normal at each curve point
+    //!
+    //! The normals point to the left rail. Lines parallel to the centerline are the
+    //! curve points plus a multiple of them.
+    //-----------------------------------------------------------------------------------
+    PointView BezierCurve::GetNormals() {
+        Update();
+        return PointView(_normal_points);
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets a line parallel to the centerline
+    //!
+    //! Built from the cached normals with one multiply-add per coordinate, so any
+    //! number of lines, the roadbed edges or the centerline of a second track, cost
+    //! no more than copying the points.
+    //!
+    //! \param offset the distance from the centerline, positive to the left
+    //! \param points receives one point per curve point. Its storage is reused.
+    //-----------------------------------------------------------------------------------
+    void BezierCurve::GetOffsetLine(double offset, std::vector<Point> &points) {
+        Update();
+        const size_t size = _curve_points.size();
+        points.resize(size);
+        for (size_t idx = 0; idx < size; ++idx) {
+            points[idx].x = _curve_points[idx].x + _normal_points[idx].x * offset;
+            points[idx].y = _curve_points[idx].y + _normal_points[idx].y * offset;
         }
-        return points;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the tangent points
+    //!
+    //! \return the first derivative of the curve at each curve point. The buffer is
+    //!         owned by the curve and remains valid until the resolution changes.
+    //-----------------------------------------------------------------------------------
+    const std::vector<Point> &BezierCurve::GetTangentPoints() {
+        Update();
+        return _tangent_points;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the curve parameter of each curve point
+    //-----------------------------------------------------------------------------------
+    const std::vector<double> &BezierCurve::GetParameters() {
+        Update();
+        return _parameters;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the distance along the curve of each curve point
+    //!
+    //! \return the cumulative length of the line segments up to each curve point
+    //-----------------------------------------------------------------------------------
+    const std::vector<double> &BezierCurve::GetArcLengths() {
+        Update();
+        return _arc_lengths;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the number of samples on the grid defined by the resolution
+    //-----------------------------------------------------------------------------------
+    unsigned BezierCurve::GetUniformSize() const {
+        return (unsigned) (1.0F / _resolution + 1);
     }
 
     void BezierCurve::ResizeCurve() {
-        int size = (int) (1.0F / _resolution + 1);
+        unsigned size = GetUniformSize();
         _curve_points.resize(size);
+        _tangent_points.resize(size);
+        _normal_points.resize(size);
+        _parameters.resize(size);
+        _arc_lengths.resize(size);
+        _arc_table.resize((size - 1) * kArcLengthOversampling + 1);
         _top_left_points.resize(size);
         _bottom_right_points.resize(size);
     }
 
     void BezierCurve::RecalculateCurve() {
-        int idx = 0;
-        double t;
+        ScopedTimer timer(STAT_TIMER_RECALCULATE_CURVE);
 
         // recalculate the derived control points
         for (int i = 0; i < kDerivativeControlPoints; i++) {
@@ -151,90 +852,351 @@ namespace ByteTrail {
             m_derivative_ctrl_pts[i].y = (3.0F * (_control_points[i + 1].y - _control_points[i].y));
         }
 
+        // adaptive sampling changes the buffer sizes, restore them for the grids
+        if (_sampling_mode != SAMPLE_ADAPTIVE && _curve_points.size() != GetUniformSize()) {
+            ResizeCurve();
+        }
+
+        if (_sampling_mode == SAMPLE_ADAPTIVE) {
+            RecalculateAdaptiveParameters();
+            EvaluateParameters();
+        } else if (_sampling_mode == SAMPLE_ARC_LENGTH) {
+            ResampleByArcLength();
+        } else {
+            if (_evaluation_mode == EVAL_REFERENCE) {
+                EvaluateReference();
+                RecalculateTangentPoints();
+            } else {
+                EvaluateForwardDifference();
+            }
+            RecalculateUniformParameters();
+        }
+        RecalculateArcLengths();
+
+        // recalculate the normals and from them the parallel lines
+        RecalculateNormals();
+        RecalculateParallels(_parallels_distance);
+        ++_revision;
+        FT_TRACE2(TRACE_GEOMETRY, "recalculate curve", _curve_points.size(), _curve_length);
+        Stats::GetInstance().Add(STAT_CURVES_RECALCULATED, 1);
+        Stats::GetInstance().Add(STAT_POINTS_EMITTED, 3 * _curve_points.size());
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Evaluates curve points and tangents by forward differencing
+    //!
+    //! The cubic is converted to power basis, B(t) = a*t^3 + b*t^2 + c*t + d, and
+    //! stepped across the uniform grid with constant third differences. The
+    //! derivative, B'(t) = 3a*t^2 + 2b*t + c, is stepped alongside it so both are
+    //! produced in a single pass with three additions per value and no calls to
+    //! std::pow. The end points are assigned exactly from the control points.
+    //-----------------------------------------------------------------------------------
+    void BezierCurve::EvaluateForwardDifference() {
+        const Point &p0 = _control_points[0];
+        const Point &p3 = _control_points[3];
+        const double h = _resolution;
+        const double h2 = h * h;
+        const double h3 = h2 * h;
+
+        // power basis coefficients
+        const PowerBasis basis(_control_points);
+        const double ax = basis.a.x, ay = basis.a.y;
+        const double bx = basis.b.x, by = basis.b.y;
+        const double cx = basis.c.x, cy = basis.c.y;
+
+        // position and its forward differences
+        double x = p0.x, y = p0.y;
+        double dx1 = ax * h3 + bx * h2 + cx * h;
+        double dy1 = ay * h3 + by * h2 + cy * h;
+        double dx2 = 6.0 * ax * h3 + 2.0 * bx * h2;
+        double dy2 = 6.0 * ay * h3 + 2.0 * by * h2;
+        const double dx3 = 6.0 * ax * h3;
+        const double dy3 = 6.0 * ay * h3;
+
+        // derivative and its forward differences
+        double tx = cx, ty = cy;
+        double tx1 = 3.0 * ax * h2 + 2.0 * bx * h;
+        double ty1 = 3.0 * ay * h2 + 2.0 * by * h;
+        const double tx2 = 6.0 * ax * h2;
+        const double ty2 = 6.0 * ay * h2;
+
+        const size_t last = _curve_points.size() - 1;
+        for (size_t idx = 0; idx < last; ++idx) {
+            _curve_points[idx].x = x;
+            _curve_points[idx].y = y;
+            _tangent_points[idx].x = tx;
+            _tangent_points[idx].y = ty;
+
+            x += dx1;
+            y += dy1;
+            dx1 += dx2;
+            dy1 += dy2;
+            dx2 += dx3;
+            dy2 += dy3;
+
+            tx += tx1;
+            ty += ty1;
+            tx1 += tx2;
+            ty1 += ty2;
+        }
+
+        _curve_points[last].x = p3.x;
+        _curve_points[last].y = p3.y;
+        _tangent_points[last].x = m_derivative_ctrl_pts[kDerivativeControlPoints - 1].x;
+        _tangent_points[last].y = m_derivative_ctrl_pts[kDerivativeControlPoints - 1].y;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Evaluates curve points directly from the Bernstein polynomials
+    //!
+    //! Reference implementation used to validate EvaluateForwardDifference().
+    //-----------------------------------------------------------------------------------
+    void BezierCurve::EvaluateReference() {
+        int idx = 1;
+        double t;
+
         _curve_points[0].x = _control_points[0].x;
         _curve_points[0].y = _control_points[0].y;
 
         // recalculate the primary curve points
         for (auto itr = _curve_points.begin() + 1; itr != _curve_points.end() - 1; itr++) {
-            t = _resolution * idx++;
-
-            double x =
-                    _control_points[0].x * std::pow((1 - t), 3)
-                    + _control_points[1].x * 3 * std::pow((1 - t), 2) * t
-                    + _control_points[2].x * 3 * (1 - t) * t * t
-                    + _control_points[3].x * std::pow(t, 3);
-            double y =
-                    _control_points[0].y * std::pow((1 - t), 3)
-                    + _control_points[1].y * 3 * std::pow((1 - t), 2) * t
-                    + _control_points[2].y * 3 * (1 - t) * t * t
-                    + _control_points[3].y * std::pow(t, 3);
-            (*itr).x = x;
-            (*itr).y = y;
+            t = static_cast<double>(_resolution) * idx++;
+            BernsteinBasis<kControlPoints - 1>::Evaluate(_control_points, t, itr->x, itr->y);
         }
 
         _curve_points.back().x = _control_points[3].x;
         _curve_points.back().y = _control_points[3].y;
-
-        // get the tangent points
-        std::unique_ptr<std::vector<Point>> tangent_points = RecalculateTangentPoints();
-        // recalculate the parallel lines
-        RecalculateParallels(tangent_points, _parallels_distance);
     }
 
-    std::unique_ptr<std::vector<Point>> BezierCurve::RecalculateTangentPoints() const {
-        std::unique_ptr<std::vector<Point>> tangent_points =
-                std::unique_ptr<std::vector<Point>>(new std::vector<Point>);
-        int size = (int) (1.0F / _resolution + 1);
+    void BezierCurve::RecalculateTangentPoints() {
+        const size_t size = _tangent_points.size();
 
         // start point = initial control point
-        Point p;
-        p.x = m_derivative_ctrl_pts[0].x;
-        p.y = m_derivative_ctrl_pts[0].y;
-        tangent_points->push_back(p);
+        _tangent_points[0].x = m_derivative_ctrl_pts[0].x;
+        _tangent_points[0].y = m_derivative_ctrl_pts[0].y;
         // calculate the points between 1st and last
         double t = 0.0;
-        for (int idx = 1; idx < size - 1; ++idx) {
-            t = _resolution * idx;
-            Point p;
-            p.x = m_derivative_ctrl_pts[0].x * std::pow((1 - t), 2)
-                  + m_derivative_ctrl_pts[1].x * 2 * (1 - t) * t
-                  + m_derivative_ctrl_pts[2].x * std::pow(t, 2);
-            p.y = m_derivative_ctrl_pts[0].y * std::pow((1 - t), 2)
-                  + m_derivative_ctrl_pts[1].y * 2 * (1 - t) * t
-                  + m_derivative_ctrl_pts[2].y * std::pow(t, 2);
-            tangent_points->push_back(p);
+        for (size_t idx = 1; idx < size - 1; ++idx) {
+            t = static_cast<double>(_resolution) * idx;
+            Point &p = _tangent_points[idx];
+            BernsteinBasis<kDerivativeControlPoints - 1>::Evaluate(m_derivative_ctrl_pts, t, p.x, p.y);
         }
         // end point = last control point
-        Point p2;
-        p2.x = m_derivative_ctrl_pts[kDerivativeControlPoints - 1].x;
-        p2.y = m_derivative_ctrl_pts[kDerivativeControlPoints - 1].y;
-        tangent_points->push_back(p2);
+        _tangent_points[size - 1].x = m_derivative_ctrl_pts[kDerivativeControlPoints - 1].x;
+        _tangent_points[size - 1].y = m_derivative_ctrl_pts[kDerivativeControlPoints - 1].y;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Normalizes each tangent and turns it into the normal to the left
+    //!
+    //! The only square root and division per sample. A zero tangent, at a cusp or
+    //! where a handle coincides with its end, takes the limit direction instead.
+    //-----------------------------------------------------------------------------------
+    void BezierCurve::RecalculateNormals() {
+        const size_t size = _tangent_points.size();
+        for (size_t idx = 0; idx < size; ++idx) {
+            const Point &tangent = _tangent_points[idx];
+            double dist = std::sqrt(tangent.x * tangent.x + tangent.y * tangent.y);
+            if (dist > 0.0) {
+                double inverse = 1.0 / dist;
+                _normal_points[idx].x = tangent.y * inverse;
+                _normal_points[idx].y = -tangent.x * inverse;
+            } else {
+                _normal_points[idx] = GetLimitNormal(_control_points, _parameters[idx]);
+            }
+        }
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the unit normal where the derivative of a cubic vanishes
+    //!
+    //! Next to such a parameter the curve heads along the second derivative, away
+    //! from it for t < 1 and into it at t = 1. Where that vanishes as well the chord
+    //! is used, so only a curve of zero extent gets a zero normal.
+    //!
+    //! \param points the 4 control points
+    //! \param t the parameter at which the derivative is zero
+    //-----------------------------------------------------------------------------------
+    Point BezierCurve::GetLimitNormal(const Point *points, double t) {
+        const PowerBasis basis(points);
+        Point direction = basis.EvaluateSecondDerivative(t);
+        if (t >= 1.0) {
+            direction.x = -direction.x;
+            direction.y = -direction.y;
+        }
+        if (direction.x == 0.0 && direction.y == 0.0) {
+            direction.x = points[3].x - points[0].x;
+            direction.y = points[3].y - points[0].y;
+        }
+        double dist = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+        if (dist == 0.0)
+            return Point(0.0, 0.0);
+        return Point(direction.y / dist, -direction.x / dist);
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Offsets the rails from the centerline along the cached normals
+    //!
+    //! A change of the rail distance alone only repeats this pass.
+    //-----------------------------------------------------------------------------------
+    void BezierCurve::RecalculateParallels(double distance) {
+        ScopedTimer timer(STAT_TIMER_RECALCULATE_PARALLELS);
+        const size_t size = _curve_points.size();
+        for (size_t idx = 0; idx < size; ++idx) {
+            const Point &center = _curve_points[idx];
+            const Point &normal = _normal_points[idx];
+            _top_left_points[idx].x = center.x + normal.x * distance;
+            _top_left_points[idx].y = center.y + normal.y * distance;
+            _bottom_right_points[idx].x = center.x - normal.x * distance;
+            _bottom_right_points[idx].y = center.y - normal.y * distance;
+        }
+    }
 
-        return tangent_points;
+    //-----------------------------------------------------------------------------------
+    //! \brief Assigns the uniform grid parameter to each curve point
+    //-----------------------------------------------------------------------------------
+    void BezierCurve::RecalculateUniformParameters() {
+        const size_t last = _parameters.size() - 1;
+        for (size_t idx = 0; idx < last; ++idx) {
+            _parameters[idx] = static_cast<double>(_resolution) * idx;
+        }
+        _parameters[last] = 1.0;
     }
 
-    void BezierCurve::RecalculateParallels(
-            const std::unique_ptr<std::vector<Point>> &tangent_points,
-            double distance) {
-        double tan_x = 0.0,
-                tan_y = 0.0;
+    //-----------------------------------------------------------------------------------
+    //! \brief Builds the arc length table from the current curve points
+    //!
+    //! Each entry is the length of the polyline from the first curve point, the last
+    //! entry being the cached curve length.
+    //-----------------------------------------------------------------------------------
+    void BezierCurve::RecalculateArcLengths() {
+        double len = 0.0;
+        _arc_lengths[0] = 0.0;
+        for (size_t idx = 1; idx < _curve_points.size(); ++idx) {
+            len += _curve_points[idx - 1].Distance(_curve_points[idx]);
+            _arc_lengths[idx] = len;
+        }
+        _curve_length = len;
+    }
 
-        int idx = 0;
+    //-----------------------------------------------------------------------------------
+    //! \brief Places the samples at equal distances along the curve
+    //!
+    //! A cumulative length table is built over a grid kArcLengthOversampling times
+    //! finer than the sample grid. The parameter for each target distance is found
+    //! by walking that table, then the points and tangents are evaluated at the new
+    //! parameters.
+    //-----------------------------------------------------------------------------------
+    void BezierCurve::ResampleByArcLength() {
+        const PowerBasis basis(_control_points);
+        const size_t segments = _arc_table.size() - 1;
+        const double step = 1.0 / segments;
 
-        for (auto itr = tangent_points->begin(); itr != tangent_points->end(); ++itr) {
-            tan_x = (*itr).x;
-            tan_y = (*itr).y;
-            double dist = std::sqrt(tan_x * tan_x + tan_y * tan_y);
-            tan_x /= dist;
-            tan_y /= dist;
+        double len = 0.0;
+        Point prev = _control_points[0];
+        _arc_table[0] = 0.0;
+        for (size_t idx = 1; idx <= segments; ++idx) {
+            Point p = idx == segments ? _control_points[3] : basis.Evaluate(step * idx);
+            len += prev.Distance(p);
+            _arc_table[idx] = len;
+            prev = p;
+        }
 
-            _top_left_points[idx].x = _curve_points[idx].x + tan_y * distance;
-            _top_left_points[idx].y = _curve_points[idx].y - tan_x * distance;
+        const size_t last = _parameters.size() - 1;
+        const double spacing = len / last;
+        size_t segment = 1;
+        _parameters[0] = 0.0;
+        for (size_t idx = 1; idx < last; ++idx) {
+            double distance = spacing * idx;
+            while (segment < segments && _arc_table[segment] < distance)
+                ++segment;
+            double s0 = _arc_table[segment - 1];
+            double s1 = _arc_table[segment];
+            double fraction = s1 > s0 ? (distance - s0) / (s1 - s0) : 0.0;
+            _parameters[idx] = step * (segment - 1 + fraction);
+        }
+        _parameters[last] = 1.0;
 
-            _bottom_right_points[idx].x = _curve_points[idx].x - tan_y * distance;
-            _bottom_right_points[idx].y = _curve_points[idx].y + tan_x * distance;
+        EvaluateParameters();
+    }
 
-            ++idx;
+    //-----------------------------------------------------------------------------------
+    //! \brief Evaluates the curve points and tangents at the stored parameters
+    //-----------------------------------------------------------------------------------
+    void BezierCurve::EvaluateParameters() {
+        const PowerBasis basis(_control_points);
+        const size_t last = _parameters.size() - 1;
+        for (size_t idx = 1; idx < last; ++idx) {
+            _curve_points[idx] = basis.Evaluate(_parameters[idx]);
+            _tangent_points[idx] = basis.EvaluateDerivative(_parameters[idx]);
         }
+
+        // end points are exact
+        _curve_points[0] = _control_points[0];
+        _curve_points[last] = _control_points[3];
+        _tangent_points[0] = m_derivative_ctrl_pts[0];
+        _tangent_points[last] = m_derivative_ctrl_pts[kDerivativeControlPoints - 1];
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Builds the parameters of the samples by adaptive subdivision
+    //!
+    //! The point buffers are resized to the resulting sample count. They keep their
+    //! capacity, so once a curve has reached its largest sample count recalculation
+    //! does not allocate.
+    //-----------------------------------------------------------------------------------
+    void BezierCurve::RecalculateAdaptiveParameters() {
+        _parameters.clear();
+        _parameters.push_back(0.0);
+        SubdivideCurve(_control_points, 0.0, 1.0, 0);
+
+        const size_t size = _parameters.size();
+        _curve_points.resize(size);
+        _tangent_points.resize(size);
+        _normal_points.resize(size);
+        _top_left_points.resize(size);
+        _bottom_right_points.resize(size);
+        _arc_lengths.resize(size);
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Subdivides a section of the curve until it is flat within the tolerance
+    //!
+    //! The flatness test bounds the distance between the section and its chord: for
+    //! u = 3*P1 - 2*P0 - P3 and v = 3*P2 - P0 - 2*P3 the squared distance is at most
+    //! (max(ux^2, vx^2) + max(uy^2, vy^2)) / 16. Sections that are not flat are split
+    //! in half with de Casteljau's algorithm. The end parameter of each flat section
+    //! is appended to the parameters.
+    //!
+    //! \param points the four control points of the section
+    //! \param t0 the curve parameter at the start of the section
+    //! \param t1 the curve parameter at the end of the section
+    //! \param depth the number of subdivisions that produced the section
+    //-----------------------------------------------------------------------------------
+    void BezierCurve::SubdivideCurve(const Point *points, double t0, double t1, unsigned depth) {
+        double ux = 3.0 * points[1].x - 2.0 * points[0].x - points[3].x;
+        double uy = 3.0 * points[1].y - 2.0 * points[0].y - points[3].y;
+        double vx = 3.0 * points[2].x - points[0].x - 2.0 * points[3].x;
+        double vy = 3.0 * points[2].y - points[0].y - 2.0 * points[3].y;
+        double flatness = std::max(ux * ux, vx * vx) + std::max(uy * uy, vy * vy);
+
+        if (depth >= kMaxSubdivisionDepth || flatness <= 16.0 * _tolerance * _tolerance) {
+            _parameters.push_back(t1);
+            return;
+        }
+
+        // de Casteljau split at the middle of the section
+        Point ab((points[0].x + points[1].x) * 0.5, (points[0].y + points[1].y) * 0.5);
+        Point bc((points[1].x + points[2].x) * 0.5, (points[1].y + points[2].y) * 0.5);
+        Point cd((points[2].x + points[3].x) * 0.5, (points[2].y + points[3].y) * 0.5);
+        Point abc((ab.x + bc.x) * 0.5, (ab.y + bc.y) * 0.5);
+        Point bcd((bc.x + cd.x) * 0.5, (bc.y + cd.y) * 0.5);
+        Point middle((abc.x + bcd.x) * 0.5, (abc.y + bcd.y) * 0.5);
+
+        const Point first[kControlPoints] = {points[0], ab, abc, middle};
+        const Point second[kControlPoints] = {middle, bcd, cd, points[3]};
+        const double t = (t0 + t1) * 0.5;
+        SubdivideCurve(first, t0, t, depth + 1);
+        SubdivideCurve(second, t, t1, depth + 1);
     }
 }
@@ -0,0 +1,419 @@
+#include "ClearanceChecker.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "Stats.h"
+#include "Trace.h"
+
+namespace ByteTrail {
+
+    constexpr double ClearanceChecker::kFlatness;
+    constexpr unsigned ClearanceChecker::kMaxDepth;
+
+    // cells about the size of a segment with its clearance
+    static const double kCellSize = 4.0 * SpatialGrid::kDefaultCellSize;
+
+    static const std::vector<ClearanceChecker::Conflict> kNoConflicts;
+
+    namespace {
+
+        //! \brief Control points of part of a curve
+        struct Piece {
+            Point p[4];
+            Rect bounds;
+        };
+
+        //! \brief State of the narrow phase of one pair of curves
+        struct Search {
+            const std::vector<Point> *joints;
+            double joint_radius;
+            // distance of the closest pair found, starts at the clearance
+            double best;
+            bool found;
+            bool crossing;
+            Point location;
+        };
+
+    }
+
+    static void SetBounds(Piece &piece) {
+        double min_x = piece.p[0].x;
+        double max_x = min_x;
+        double min_y = piece.p[0].y;
+        double max_y = min_y;
+        for (unsigned i = 1; i < 4; i++) {
+            min_x = std::min(min_x, piece.p[i].x);
+            max_x = std::max(max_x, piece.p[i].x);
+            min_y = std::min(min_y, piece.p[i].y);
+            max_y = std::max(max_y, piece.p[i].y);
+        }
+        piece.bounds = Rect {min_x, min_y, max_x - min_x, max_y - min_y};
+    }
+
+    //! \brief Splits a piece in halves at its middle parameter, de Casteljau
+    static void Split(const Piece &piece, Piece &left, Piece &right) {
+        const Point *p = piece.p;
+        const Point p01((p[0].x + p[1].x) / 2.0, (p[0].y + p[1].y) / 2.0);
+        const Point p12((p[1].x + p[2].x) / 2.0, (p[1].y + p[2].y) / 2.0);
+        const Point p23((p[2].x + p[3].x) / 2.0, (p[2].y + p[3].y) / 2.0);
+        const Point p012((p01.x + p12.x) / 2.0, (p01.y + p12.y) / 2.0);
+        const Point p123((p12.x + p23.x) / 2.0, (p12.y + p23.y) / 2.0);
+        const Point middle((p012.x + p123.x) / 2.0, (p012.y + p123.y) / 2.0);
+
+        left.p[0] = p[0];
+        left.p[1] = p01;
+        left.p[2] = p012;
+        left.p[3] = middle;
+        right.p[0] = middle;
+        right.p[1] = p123;
+        right.p[2] = p23;
+        right.p[3] = p[3];
+        SetBounds(left);
+        SetBounds(right);
+    }
+
+    //! \brief Tells if the inner control points are within kFlatness of the chord
+    static bool IsFlat(const Piece &piece) {
+        const double flatness = ClearanceChecker::kFlatness;
+        const double dx = piece.p[3].x - piece.p[0].x;
+        const double dy = piece.p[3].y - piece.p[0].y;
+        const double chord2 = dx * dx + dy * dy;
+        for (unsigned i = 1; i <= 2; i++) {
+            const double ex = piece.p[i].x - piece.p[0].x;
+            const double ey = piece.p[i].y - piece.p[0].y;
+            if (chord2 > 0.0) {
+                const double cross = dx * ey - dy * ex;
+                if (cross * cross > flatness * flatness * chord2)
+                    return false;
+            } else if (ex * ex + ey * ey > flatness * flatness) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //! \brief Gets the squared distance between two boxes, 0 if they overlap
+    static double GetGap2(const Rect &a, const Rect &b) {
+        const double dx = std::max(0.0, std::max(a.x - (b.x + b.width), b.x - (a.x + a.width)));
+        const double dy = std::max(0.0, std::max(a.y - (b.y + b.height), b.y - (a.y + a.height)));
+        return dx * dx + dy * dy;
+    }
+
+    static bool IsNearJoint(const Point &point, const Search &search) {
+        for (const Point &joint : *search.joints) {
+            const double dx = point.x - joint.x;
+            const double dy = point.y - joint.y;
+            if (dx * dx + dy * dy < search.joint_radius * search.joint_radius)
+                return true;
+        }
+        return false;
+    }
+
+    //! \brief Tells if a whole piece is near a joint, its hull being inside the circle
+    static bool IsInJoint(const Piece &piece, const Search &search) {
+        for (const Point &joint : *search.joints) {
+            bool inside = true;
+            for (unsigned i = 0; i < 4 && inside; i++) {
+                const double dx = piece.p[i].x - joint.x;
+                const double dy = piece.p[i].y - joint.y;
+                inside = dx * dx + dy * dy < search.joint_radius * search.joint_radius;
+            }
+            if (inside)
+                return true;
+        }
+        return false;
+    }
+
+    static double Cross(const Point &o, const Point &a, const Point &b) {
+        return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+    }
+
+    //! \brief Gets the point of segment a0 a1 closest to p
+    static Point GetClosest(const Point &a0, const Point &a1, const Point &p) {
+        const double dx = a1.x - a0.x;
+        const double dy = a1.y - a0.y;
+        const double length2 = dx * dx + dy * dy;
+        if (length2 <= 0.0)
+            return a0;
+        const double t = std::min(1.0, std::max(0.0, ((p.x - a0.x) * dx + (p.y - a0.y) * dy) / length2));
+        return Point(a0.x + t * dx, a0.y + t * dy);
+    }
+
+    //! \brief Measures two flat pieces as the line segments between their end points
+    static void Measure(const Piece &a, const Piece &b, Search &search) {
+        const Point &a0 = a.p[0];
+        const Point &a1 = a.p[3];
+        const Point &b0 = b.p[0];
+        const Point &b1 = b.p[3];
+
+        const double d1 = Cross(b0, b1, a0);
+        const double d2 = Cross(b0, b1, a1);
+        const double d3 = Cross(a0, a1, b0);
+        const double d4 = Cross(a0, a1, b1);
+        if (((d1 > 0.0 && d2 < 0.0) || (d1 < 0.0 && d2 > 0.0)) &&
+            ((d3 > 0.0 && d4 < 0.0) || (d3 < 0.0 && d4 > 0.0))) {
+            const double t = d1 / (d1 - d2);
+            const Point crossing(a0.x + t * (a1.x - a0.x), a0.y + t * (a1.y - a0.y));
+            if (!IsNearJoint(crossing, search)) {
+                search.best = 0.0;
+                search.found = true;
+                search.crossing = true;
+                search.location = crossing;
+            }
+            return;
+        }
+
+        // otherwise the closest pair has an end point of one of the segments
+        const Point candidates[4][2] = {
+                {a0, GetClosest(b0, b1, a0)},
+                {a1, GetClosest(b0, b1, a1)},
+                {GetClosest(a0, a1, b0), b0},
+                {GetClosest(a0, a1, b1), b1}
+        };
+        for (const auto &pair : candidates) {
+            const double distance = pair[0].Distance(pair[1]);
+            if (distance < search.best && !IsNearJoint(pair[0], search) && !IsNearJoint(pair[1], search)) {
+                search.best = distance;
+                search.found = true;
+                search.location = Point((pair[0].x + pair[1].x) / 2.0, (pair[0].y + pair[1].y) / 2.0);
+            }
+        }
+    }
+
+    static double GetSize(const Piece &piece) {
+        return piece.bounds.width + piece.bounds.height;
+    }
+
+    //! \brief Narrow phase, splits the larger piece that is not flat yet
+    static void Find(const Piece &a, unsigned depth_a, const Piece &b, unsigned depth_b, Search &search) {
+        if (search.crossing || GetGap2(a.bounds, b.bounds) >= search.best * search.best)
+            return;
+        if (!search.joints->empty() && (IsInJoint(a, search) || IsInJoint(b, search)))
+            return;
+
+        const bool split_a = depth_a < ClearanceChecker::kMaxDepth && !IsFlat(a);
+        const bool split_b = depth_b < ClearanceChecker::kMaxDepth && !IsFlat(b);
+        if (!split_a && !split_b) {
+            Measure(a, b, search);
+            return;
+        }
+
+        Piece halves[2];
+        if (split_a && (!split_b || GetSize(a) >= GetSize(b))) {
+            Split(a, halves[0], halves[1]);
+            // the nearer half first, so the farther one is more likely pruned
+            const unsigned first = GetGap2(halves[0].bounds, b.bounds) <= GetGap2(halves[1].bounds, b.bounds) ? 0 : 1;
+            Find(halves[first], depth_a + 1, b, depth_b, search);
+            Find(halves[1 - first], depth_a + 1, b, depth_b, search);
+        } else {
+            Split(b, halves[0], halves[1]);
+            const unsigned first = GetGap2(a.bounds, halves[0].bounds) <= GetGap2(a.bounds, halves[1].bounds) ? 0 : 1;
+            Find(a, depth_a, halves[first], depth_b + 1, search);
+            Find(a, depth_a, halves[1 - first], depth_b + 1, search);
+        }
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Creates a checker with no segments
+    //!
+    //! \param clearance the smallest distance allowed between the centerlines of two
+    //!        segments
+    //-----------------------------------------------------------------------------------
+    ClearanceChecker::ClearanceChecker(double clearance) :
+            _clearance(clearance),
+            _index(kCellSize),
+            _count(0) {
+        assert(clearance > 0.0);
+    }
+
+    ClearanceChecker::~ClearanceChecker() {
+    }
+
+    double ClearanceChecker::GetClearance() const {
+        return _clearance;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Sets the smallest distance allowed between centerlines
+    //!
+    //! Applies to the segments updated afterwards, Update() the whole graph to check
+    //! the layout again.
+    //-----------------------------------------------------------------------------------
+    void ClearanceChecker::SetClearance(double clearance) {
+        assert(clearance > 0.0);
+        _clearance = clearance;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Forgets every segment and conflict
+    //-----------------------------------------------------------------------------------
+    void ClearanceChecker::Clear() {
+        _index.Clear();
+        _conflicts.clear();
+        _count = 0;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Checks a segment again against the segments near it
+    //!
+    //! Must be called for every segment whose control points changed, such as the
+    //! segments TrackGraph::GetTouched() reports after an edit.
+    //!
+    //! \param graph the graph holding the segment, its joints are not conflicts
+    //! \param segment the index of the segment in the graph
+    //-----------------------------------------------------------------------------------
+    void ClearanceChecker::Update(const TrackGraph &graph, unsigned segment) {
+        if (segment >= _conflicts.size())
+            _conflicts.resize(segment + 1);
+        Unlink(segment);
+
+        const BezierCurve &curve = *graph.GetCurve(segment);
+        const Rect bounds = GetCheckBounds(curve, _clearance);
+        _index.Insert(segment, bounds);
+        _hits.clear();
+        _index.Query(bounds, _hits);
+
+        for (unsigned other : _hits) {
+            if (other == segment || other >= graph.GetSegmentCount())
+                continue;
+
+            _joints.clear();
+            for (unsigned end = TrackGraph::END_START; end <= TrackGraph::END_FINISH; end++) {
+                unsigned neighbor;
+                TrackGraph::End neighbor_end;
+                if (graph.GetNeighbor(segment, static_cast<TrackGraph::End>(end), neighbor, neighbor_end) &&
+                    neighbor == other)
+                    _joints.push_back(curve.GetControlPoint(end == TrackGraph::END_START ? 0 : 3));
+            }
+
+            Conflict conflict;
+            if (Check(curve, *graph.GetCurve(other), _clearance, _joints, conflict)) {
+                conflict.first = std::min(segment, other);
+                conflict.second = std::max(segment, other);
+                _conflicts[segment].push_back(conflict);
+                _conflicts[other].push_back(conflict);
+                ++_count;
+            }
+        }
+        FT_TRACE2(TRACE_GEOMETRY, "clearance check", segment, _hits.size());
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Checks every segment of a graph, dropping the segments it no longer has
+    //!
+    //! Each pair of segments is compared once.
+    //-----------------------------------------------------------------------------------
+    void ClearanceChecker::Update(const TrackGraph &graph) {
+        Clear();
+        for (unsigned segment = 0; segment < graph.GetSegmentCount(); segment++)
+            Update(graph, segment);
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Removes a segment and its conflicts
+    //-----------------------------------------------------------------------------------
+    void ClearanceChecker::Remove(unsigned segment) {
+        if (segment >= _conflicts.size())
+            return;
+        Unlink(segment);
+        _index.Remove(segment);
+        while (!_conflicts.empty() && !_index.Contains(_conflicts.size() - 1))
+            _conflicts.pop_back();
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the conflicts of a segment with any other
+    //-----------------------------------------------------------------------------------
+    const std::vector<ClearanceChecker::Conflict> &ClearanceChecker::GetConflicts(unsigned segment) const {
+        return segment < _conflicts.size() ? _conflicts[segment] : kNoConflicts;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets every conflict of the layout once, ordered by their first segment
+    //-----------------------------------------------------------------------------------
+    void ClearanceChecker::GetConflicts(std::vector<Conflict> &conflicts) const {
+        conflicts.clear();
+        for (unsigned segment = 0; segment < _conflicts.size(); segment++) {
+            for (const Conflict &conflict : _conflicts[segment]) {
+                if (conflict.first == segment)
+                    conflicts.push_back(conflict);
+            }
+        }
+    }
+
+    unsigned ClearanceChecker::GetConflictCount() const {
+        return _count;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Finds the closest approach of two curves
+    //!
+    //! \param a the first curve
+    //! \param b the second curve
+    //! \param clearance the smallest distance allowed between the centerlines
+    //! \param joints the points where the curves are joined. Pairs of points either of
+    //!        which is closer than the clearance to a joint are ignored.
+    //! \param conflict receives the kind, distance and location of the conflict
+    //! \return true if the curves cross or come closer than the clearance
+    //-----------------------------------------------------------------------------------
+    bool ClearanceChecker::Check(const BezierCurve &a, const BezierCurve &b, double clearance,
+                                 const std::vector<Point> &joints, Conflict &conflict) {
+        Stats::GetInstance().Add(STAT_CLEARANCE_PAIRS_CHECKED, 1);
+        Piece pieces[2];
+        for (unsigned i = 0; i < 4; i++) {
+            pieces[0].p[i] = a.GetControlPoint(i);
+            pieces[1].p[i] = b.GetControlPoint(i);
+        }
+        SetBounds(pieces[0]);
+        SetBounds(pieces[1]);
+
+        Search search;
+        search.joints = &joints;
+        search.joint_radius = clearance;
+        search.best = clearance;
+        search.found = false;
+        search.crossing = false;
+        search.location = Point(0.0, 0.0);
+        Find(pieces[0], 0, pieces[1], 0, search);
+
+        if (!search.found)
+            return false;
+        conflict.kind = search.crossing ? CONFLICT_CROSSING : CONFLICT_CLEARANCE;
+        conflict.distance = search.best;
+        conflict.location = search.location;
+        return true;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the control point bounds of a curve grown by half the clearance
+    //!
+    //! Two curves can only conflict if their boxes overlap.
+    //-----------------------------------------------------------------------------------
+    Rect ClearanceChecker::GetCheckBounds(const BezierCurve &curve, double clearance) {
+        Piece piece;
+        for (unsigned i = 0; i < 4; i++)
+            piece.p[i] = curve.GetControlPoint(i);
+        SetBounds(piece);
+        const double margin = clearance / 2.0;
+        return Rect {piece.bounds.x - margin, piece.bounds.y - margin,
+                     piece.bounds.width + clearance, piece.bounds.height + clearance};
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Drops the conflicts of a segment from its lists and those of the others
+    //-----------------------------------------------------------------------------------
+    void ClearanceChecker::Unlink(unsigned segment) {
+        for (const Conflict &conflict : _conflicts[segment]) {
+            const unsigned other = conflict.first == segment ? conflict.second : conflict.first;
+            std::vector<Conflict> &list = _conflicts[other];
+            list.erase(std::remove_if(list.begin(), list.end(), [segment](const Conflict &c) {
+                return c.first == segment || c.second == segment;
+            }), list.end());
+            --_count;
+        }
+        _conflicts[segment].clear();
+    }
+
+}
@@ -4,7 +4,7 @@ namespace ByteTrail
 {
 
 
-Connector::Connector()
+Connector::Connector() : _location(0, 0), _angle(0.0)
 {
     //ctor
 }
@@ -33,9 +33,27 @@ void Connector::Disconnect()
     _connected_to = nullptr;
 }
 
+//-----------------------------------------------------------------------------
+//! \brief Gets the direction the track leaves the end in, in radians
+//-----------------------------------------------------------------------------
 double Connector::GetAngle() const
 {
     return _angle;
 }
 
+void Connector::SetAngle(double angle)
+{
+    _angle = angle;
+}
+
+const Point & Connector::GetLocation() const
+{
+    return _location;
+}
+
+void Connector::SetLocation(const Point & location)
+{
+    _location = location;
+}
+
 }
@@ -1,6 +1,10 @@
-#include <iostream>
+#include <algorithm>
 #include <cmath>
+#include <iomanip>
+#include <sstream>
 #include "CurveView.h"
+#include "LayoutGLArea.h"
+#include "Trace.h"
 
 namespace ByteTrail {
 
@@ -8,14 +12,27 @@ namespace ByteTrail {
 
   static Polygon polygon;
 
+  // room around a curve for the rails and the control handles, in pixels at a
+  // scale of 1. Both are drawn in curve units, so it grows when zoomed in.
+  static const double kRedrawMargin = 8.0;
+  // half the size of the square around a control point that picks it
+  static const double kHandleRadius = 5.0;
+  // largest distance from a centerline that still picks the curve
+  static const double kPickDistance = 8.0;
+  // area in the top left corner covered by the statistics overlay, in pixels
+  static const int kOverlayWidth = 260;
+  static const int kOverlayHeight = 110;
+
   void SetDashPattern(){
     dashes[0] = 4.0;
     dashes[1] = 4.0;
   }
 
 
-  CurveView::CurveView() : _scale(1.0F), _resolution(0.025F),
-        _edit_mode(false), _dragging(false), _sections(3) {
+  CurveView::CurveView() : _scale(1.0F), _resolution(0.025F), _tolerance(0.0),
+        _edit_mode(false), _dragging(false), _active_idx(0), _attached_idx(0), _sections(3),
+        _recalculator(_pool), _tile_scale(1.0F), _gl_area(nullptr), _stats_overlay(false), _frame_stats(),
+        _coalesce_motion(false), _motion_pending(false), _tick_id(0) {
 
     SetDashPattern();
 
@@ -31,7 +48,7 @@ namespace ByteTrail {
     int x, y;
 
     for(int i=0; i<3; i++) {
-      std::shared_ptr<BezierCurve> curve = std::make_shared<BezierCurve>(BezierCurve());
+      std::shared_ptr<BezierCurve> curve = std::make_shared<BezierCurve>();
 
       if(i == 0 ) {
         x = std::rand() % 250;
@@ -55,7 +72,10 @@ namespace ByteTrail {
         y = std::rand() % 250;
         curve->SetControlPoint(x, y, 3);
 
+        ConfigureCurve(*curve);
         _curves.push_back(std::move(curve));
+        AddToGraph(_curves.size() - 1);
+        UpdateIndex(_curves.size() - 1);
     }
 
 
@@ -66,6 +86,7 @@ namespace ByteTrail {
     signal_button_press_event().connect(sigc::mem_fun(this, &CurveView::on_button_press));
     signal_button_release_event().connect(sigc::mem_fun(this, &CurveView::on_button_release));
     signal_motion_notify_event().connect(sigc::mem_fun(this, &CurveView::on_button_motion));
+    _snapshot_published.connect(sigc::mem_fun(this, &CurveView::OnSnapshotPublished));
 }
 
 CurveView::~CurveView()
@@ -78,13 +99,90 @@ void CurveView::SetEditMode(bool edit_mode)
     if(edit_mode != _edit_mode)
     {
         _edit_mode = edit_mode;
+        InvalidateTiles();
+        queue_draw();
+    }
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Sets the tessellation tolerance
+//!
+//! \param pixels the maximum on screen distance between a curve and the drawn
+//!        polyline. Curves are sampled adaptively to this tolerance at the
+//!        current scale, so straight runs are drawn with only a few points. A
+//!        value of 0 selects the uniform sample grid of the curve resolution.
+//-----------------------------------------------------------------------------
+void CurveView::SetTessellationTolerance(double pixels)
+{
+    if(pixels != _tolerance)
+    {
+        _tolerance = pixels;
+        for(size_t idx = 0; idx < _curves.size(); ++idx)
+        {
+            ConfigureCurve(*_curves[idx]);
+            PostCurve(idx);
+        }
+        InvalidateTiles();
         queue_draw();
     }
 }
 
+//-----------------------------------------------------------------------------
+//! \brief Sets the zoom
+//!
+//! \param scale pixels per layout unit. The level of detail of each curve is
+//!        chosen from it and the length of the curve on screen on every draw.
+//-----------------------------------------------------------------------------
+void CurveView::SetScale(float scale)
+{
+    if(scale > 0.0F && scale != _scale)
+    {
+        _scale = scale;
+        // the adaptive tolerance is kept in pixels
+        if(_tolerance > 0.0)
+        {
+            for(size_t idx = 0; idx < _curves.size(); ++idx)
+            {
+                ConfigureCurve(*_curves[idx]);
+                PostCurve(idx);
+            }
+        }
+        queue_draw();
+    }
+}
+
+float CurveView::GetScale() const
+{
+    return _scale;
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Applies the view tessellation settings to a curve
+//-----------------------------------------------------------------------------
+void CurveView::ConfigureCurve(BezierCurve & curve) const
+{
+    if(_tolerance > 0.0)
+    {
+        curve.SetSamplingMode(SAMPLE_ADAPTIVE);
+        curve.SetTolerance(_tolerance / _scale);
+    }
+    else
+    {
+        curve.SetSamplingMode(SAMPLE_UNIFORM);
+    }
+}
+
 void CurveView::AddSegement()
 {
+    // only control point edits are journaled
+    _journal.Clear();
     _curves.push_back(CreateCurve());
+    AddToGraph(_curves.size() - 1);
+    UpdateIndex(_curves.size() - 1);
+    if(_worker)
+        _worker->Resize(_curves.size());
+    PostCurve(_curves.size() - 1);
+    InvalidateTiles(_curves.back()->GetBounds());
     queue_draw();
 }
 
@@ -92,216 +190,963 @@ void CurveView::RemoveSegment()
 {
     // undefined behavior if empty
     if(!_curves.empty())
+    {
+        _journal.Clear();
+        RemoveIndex(_curves.size() - 1);
+        InvalidateTiles(_curves.back()->GetBounds());
+        if(_selected_curve == _curves.back())
+            _selected_curve = nullptr;
+        if(_active_curve == _curves.back() || _attached_active_curve == _curves.back())
+        {
+            _dragging = false;
+            _active_curve = nullptr;
+            _attached_active_curve = nullptr;
+            InvalidateTiles();
+        }
         _curves.pop_back();
+        _graph.PopSegment();
+        if(_worker)
+            _worker->Resize(_curves.size());
+    }
+    // drop the cached rails so a new curve is never matched against them
+    if(_rail_paths.size() > _curves.size())
+        _rail_paths.resize(_curves.size());
 
     queue_draw();
 }
 
 bool CurveView::on_draw(const Cairo::RefPtr<Cairo::Context>& cr)
+{
+    {
+        ScopedTimer timer(STAT_TIMER_DRAW);
+        cr->save();
+        DrawFrame(cr);
+        cr->restore();
+    }
+
+    Stats & stats = Stats::GetInstance();
+    if(stats.IsEnabled())
+    {
+        stats.EndFrame(_frame_stats);
+        _signal_frame_stats.emit(_frame_stats);
+        if(_stats_overlay)
+            DrawText(cr);
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Sets whether the statistics of the last frame are shown
+//!
+//! Showing the overlay enables the collection of statistics.
+//-----------------------------------------------------------------------------
+void CurveView::SetStatsOverlay(bool overlay)
+{
+    if(overlay != _stats_overlay)
+    {
+        _stats_overlay = overlay;
+        if(overlay)
+            Stats::GetInstance().SetEnabled(true);
+        queue_draw_area(0, 0, kOverlayWidth, kOverlayHeight);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Sets whether curves are recalculated on a background thread
+//!
+//! In the background mode input handlers only edit control points and post the
+//! edited curves; the geometry worker recalculates them and the view redraws
+//! once the new snapshot is published. The first snapshot of the whole layout
+//! is built before returning.
+//-----------------------------------------------------------------------------
+void CurveView::SetBackgroundGeometry(bool background)
+{
+    if(background == (_worker != nullptr))
+        return;
+
+    if(background)
+    {
+        _worker.reset(new GeometryWorker(_pool, [this]() { _snapshot_published.emit(); }));
+        _worker->Resize(_curves.size());
+        for(size_t idx = 0; idx < _curves.size(); ++idx)
+            PostCurve(idx);
+        _worker->Wait();
+        _snapshot = _worker->GetSnapshot();
+    }
+    else
+    {
+        _worker.reset();
+        _snapshot.reset();
+    }
+    InvalidateTiles();
+    queue_draw();
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Sets whether drag motion is applied once per frame
+//!
+//! Pointers can report motion many times per frame. When coalescing, each
+//! event only records the position and a frame clock tick applies the latest
+//! one, so the curves are edited and redrawn at most once per frame.
+//-----------------------------------------------------------------------------
+void CurveView::SetMotionCoalescing(bool coalesce)
+{
+    if(coalesce == _coalesce_motion)
+        return;
+    FlushMotion();
+    _coalesce_motion = coalesce;
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Sets the GL area under the view that draws the rails and ties
+//!
+//! The view is expected to be the overlay of the area in a Gtk::Overlay. While
+//! the area has no OpenGL context the view keeps drawing everything with
+//! Cairo.
+//!
+//! \param area the area, nullptr to draw with Cairo only
+//-----------------------------------------------------------------------------
+void CurveView::SetGLArea(LayoutGLArea * area)
+{
+    if(area == _gl_area)
+        return;
+    if(_gl_area)
+        _gl_area->SetEnabled(false);
+    _gl_area = area;
+    if(_gl_area)
+        _gl_area->SetEnabled(true);
+    InvalidateTiles();
+    queue_draw();
+}
+
+bool CurveView::UseGL() const
+{
+    return _gl_area != nullptr && _gl_area->IsAvailable();
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Applies the latest drag position of the frame
+//!
+//! \return false once no motion is pending, which removes the tick callback
+//!         until the next motion event
+//-----------------------------------------------------------------------------
+bool CurveView::OnTick(const Glib::RefPtr<Gdk::FrameClock> & clock)
+{
+    if(!_motion_pending)
+    {
+        _tick_id = 0;
+        return false;
+    }
+    _motion_pending = false;
+    ApplyDrag(_motion_point.x, _motion_point.y);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Applies a drag position still waiting for a tick right away
+//-----------------------------------------------------------------------------
+void CurveView::FlushMotion()
+{
+    if(_tick_id != 0)
+    {
+        remove_tick_callback(_tick_id);
+        _tick_id = 0;
+    }
+    if(_motion_pending)
+    {
+        _motion_pending = false;
+        ApplyDrag(_motion_point.x, _motion_point.y);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Posts a curve to the geometry worker, if there is one
+//-----------------------------------------------------------------------------
+void CurveView::PostCurve(size_t idx)
+{
+    if(_worker)
+        _worker->Post(idx, *_curves[idx]);
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Redraws the curves that changed between the drawn and the latest
+//!        snapshot
+//!
+//! Runs on the GUI thread through the dispatcher the worker emits.
+//-----------------------------------------------------------------------------
+void CurveView::OnSnapshotPublished()
+{
+    if(!_worker)
+        return;
+
+    std::shared_ptr<const GeometryWorker::Snapshot> snapshot = _worker->GetSnapshot();
+    if(snapshot == _snapshot)
+        return;
+
+    const std::vector<std::shared_ptr<BezierCurve>> & drawn = _snapshot->curves;
+    const std::vector<std::shared_ptr<BezierCurve>> & latest = snapshot->curves;
+    for(size_t idx = 0; idx < std::max(drawn.size(), latest.size()); ++idx)
+    {
+        if(idx < drawn.size() && idx < latest.size() && drawn[idx] == latest[idx])
+            continue;
+        if(idx < drawn.size())
+        {
+            InvalidateTiles(drawn[idx]->GetBounds());
+            InvalidateBounds(drawn[idx]->GetBounds());
+        }
+        if(idx < latest.size())
+        {
+            InvalidateTiles(latest[idx]->GetBounds());
+            InvalidateBounds(latest[idx]->GetBounds());
+        }
+    }
+    _snapshot = snapshot;
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Gets the curves to draw, the latest snapshot in the background mode
+//-----------------------------------------------------------------------------
+const std::vector<std::shared_ptr<BezierCurve>> & CurveView::GetDrawnCurves() const
+{
+    return _worker ? _snapshot->curves : _curves;
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Gets the statistics of the last frame drawn while collection was on
+//-----------------------------------------------------------------------------
+const FrameStats & CurveView::GetFrameStats() const
+{
+    return _frame_stats;
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Signal emitted after each frame with its statistics
+//!
+//! Only emitted while Stats collection is enabled.
+//-----------------------------------------------------------------------------
+sigc::signal<void, const FrameStats &> CurveView::signal_frame_stats()
+{
+    return _signal_frame_stats;
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Draws the statistics overlay in widget pixels
+//-----------------------------------------------------------------------------
+void CurveView::DrawText(const Cairo::RefPtr<Cairo::Context> &cr)
+{
+    const FrameStats & stats = _frame_stats;
+    std::ostringstream lines[5];
+    for(auto & line : lines)
+        line << std::fixed << std::setprecision(3);
+    lines[0] << "frame " << stats.frame;
+    lines[1] << "draw " << stats.time[STAT_TIMER_DRAW] << " ms";
+    lines[2] << "recalculate " << stats.time[STAT_TIMER_RECALCULATE_CURVE] << " ms, "
+             << stats.counters[STAT_CURVES_RECALCULATED] << " curves";
+    lines[3] << "ties " << stats.time[STAT_TIMER_GET_TIES] << " ms, "
+             << stats.counters[STAT_TIES_GENERATED] << " generated";
+    lines[4] << stats.counters[STAT_POINTS_EMITTED] << " points, "
+             << stats.counters[STAT_STROKES_ISSUED] << " strokes";
+
+    cr->save();
+    cr->set_source_rgba(1.0, 1.0, 1.0, 0.8);
+    cr->rectangle(0, 0, kOverlayWidth, kOverlayHeight);
+    cr->fill();
+    cr->set_source_rgb(0.1, 0.1, 0.1);
+    cr->set_font_size(12);
+    for(unsigned i = 0; i < 5; ++i)
+    {
+        cr->move_to(8, 20 + i * 18);
+        cr->show_text(lines[i].str());
+    }
+    cr->restore();
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Draws the tiles, the demo polygon and the live curves
+//-----------------------------------------------------------------------------
+void CurveView::DrawFrame(const Cairo::RefPtr<Cairo::Context>& cr)
 {
     //Gtk::Allocation allocation = get_allocation();
 //    const int width = allocation.get_width();
 //    const int height = allocation.get_height();
 
+    // bring every modified curve up to date before drawing, the few curves of an
+    // edit in batches on this thread and larger changes in parallel. Snapshots
+    // of the geometry worker are up to date already.
+    if(!_worker)
+    {
+        if (LayoutRecalculator::GetModifiedCount(_curves) > LayoutRecalculator::kGrainSize)
+            _recalculator.Recalculate(_curves);
+        else
+            _batch.Recalculate(_curves);
+    }
+
+    // static curves come from the tile cache, drawn in widget pixels, unless the
+    // GL area draws the whole layout
+    if(UseGL())
+        _gl_area->Sync(GetDrawnCurves(), _scale);
+    else
+        DrawTiles(cr);
+
     // coordinates for the center of the window
 
-    cr->scale(_scale, _scale);
-
+    cr->scale(_scale, _scale);
+
     cr->set_source_rgb(0.0, 0.75, 0.0);
-    cr->set_line_width(2);
-    std::cout << "POLYGON" << std::endl;
-    for(auto & seg : polygon.GetPath()) {
-      std::cout << "SEGMENT: ";
-      switch(seg->type) {
-      case SEG_MOVE_TO:
-        cr->move_to(seg->point->x, seg->point->y);
+    cr->set_line_width(2);
+    FT_TRACE1(TRACE_RENDER, "polygon", polygon.GetSize());
+    for(auto seg : polygon.GetPath()) {
+      switch(seg.type) {
+      case SEG_MOVE_TO:
+        cr->move_to(seg.point->x, seg.point->y);
         break;
-      case SEG_LINE_TO:
-        std::cout << "LINE_TO: " << (seg->point->x) << ',' << seg->point->y << std::endl;
-        cr->line_to(seg->point->x, seg->point->y);
+      case SEG_LINE_TO:
+        FT_TRACE2(TRACE_RENDER, "polygon line_to", seg.point->x, seg.point->y);
+        cr->line_to(seg.point->x, seg.point->y);
         break;
-      case SEG_CLOSE:
-        break;
-      }
-    }
-
+      case SEG_CLOSE:
+        cr->close_path();
+        break;
+      }
+    }
+
     cr->stroke();
+    Stats::GetInstance().Add(STAT_STROKES_ISSUED, 1);
+
+    // the curves being dragged are drawn live on top of the tiles
+    if(UseGL())
+        DrawCurves(cr, false);
+    DrawCurves(cr, true);
+    DrawConflicts(cr);
+}
 
-    if(_edit_mode)
+//-----------------------------------------------------------------------------
+//! \brief Circles every crossing and every place two curves are too close
+//-----------------------------------------------------------------------------
+void CurveView::DrawConflicts(const Cairo::RefPtr<Cairo::Context> &cr)
+{
+    _clearance.GetConflicts(_conflicts);
+    if(_conflicts.empty())
+        return;
+
+    cr->set_source_rgba(0.9, 0.0, 0.0, 0.7);
+    cr->set_line_width(2.0 / _scale);
+    for(const ClearanceChecker::Conflict & conflict : _conflicts)
     {
-        for(auto & curve : _curves)
+        const double radius = _clearance.GetClearance() / 2.0;
+        cr->move_to(conflict.location.x + radius, conflict.location.y);
+        cr->arc(conflict.location.x, conflict.location.y, radius, 0.0, 2.0 * 3.14159);
+    }
+    cr->stroke();
+    Stats::GetInstance().Add(STAT_STROKES_ISSUED, 1);
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Draws the control handles of a curve
+//-----------------------------------------------------------------------------
+void CurveView::DrawHandles(const Cairo::RefPtr<Cairo::Context> &cr,
+        const BezierCurve & curve) const
+{
+    for(int i=0; i<4; i++)
+    {
+        cr->set_source_rgb(0.8, 0.0, 0.0);
+        cr->set_line_width(2);
+        const Point & current_point = curve.GetControlPoint(i);
+        cr->arc(current_point.x, current_point.y, 5, 0.0, 2.0 * 3.14159);
+        if( i == 0 || i == 3 )
+            cr->fill();
+        else
         {
-            for(int i=0; i<4; i++)
+            cr->stroke();
+            cr->set_line_width(2);
+            cr->set_source_rgba(1.0, 0.4, 0.0, 0.5);
+            cr->set_dash(dashes, 1.0);
+            cr->set_line_width(2);
+            cr->move_to(current_point.x, current_point.y);
+            Point next_point;
+            if( i == 1)
             {
-                cr->set_source_rgb(0.8, 0.0, 0.0);
-                cr->set_line_width(2);
-                const Point & current_point = curve->GetControlPoint(i);
-                cr->arc(current_point.x, current_point.y, 5, 0.0, 2.0 * 3.14159);
-                if( i == 0 || i == 3 )
-                    cr->fill();
-                else
-                {
-                    cr->stroke();
-                    cr->set_line_width(2);
-                    cr->set_source_rgba(1.0, 0.4, 0.0, 0.5);
-                    cr->set_dash(dashes, 1.0);
-                    cr->set_line_width(2);
-                    cr->move_to(current_point.x, current_point.y);
-                    Point next_point;
-                    if( i == 1)
-                    {
-                        next_point = curve->GetControlPoint(0);
-                    }
-                    else
-                    {
-                        next_point = curve->GetControlPoint(3);
-                    }
-                    cr->line_to(next_point.x, next_point.y);
-                    cr->stroke();
-                    cr->unset_dash();
-                }
+                next_point = curve.GetControlPoint(0);
             }
+            else
+            {
+                next_point = curve.GetControlPoint(3);
+            }
+            cr->line_to(next_point.x, next_point.y);
+            cr->stroke();
+            cr->unset_dash();
         }
     }
-    DrawCurves(cr);
+    // a fill for each end point and two strokes for each center point
+    Stats::GetInstance().Add(STAT_STROKES_ISSUED, 6);
+}
 
-  return true;
+//-----------------------------------------------------------------------------
+//! \brief Tells whether a curve is drawn live rather than from the tile cache
+//!
+//! \param idx the index of the curve, the drawn curves may lag behind _curves
+//-----------------------------------------------------------------------------
+bool CurveView::IsLive(size_t idx) const
+{
+    return _dragging && idx < _curves.size() &&
+           (_curves[idx] == _active_curve || _curves[idx] == _attached_active_curve);
 }
 
-void CurveView::DrawCurves(const Cairo::RefPtr<Cairo::Context> &cr)
+bool CurveView::IsSelected(size_t idx) const
 {
-     for(auto & curve : _curves)
+    return _selected_curve != nullptr && idx < _curves.size() && _curves[idx] == _selected_curve;
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Draws the handles and rails of either the live or the static curves
+//!
+//! Only curves whose bounds overlap the clip extents of the context are drawn.
+//!
+//! \param live true to draw the curves being dragged, false for all others
+//-----------------------------------------------------------------------------
+void CurveView::DrawCurves(const Cairo::RefPtr<Cairo::Context> &cr, bool live)
+{
+     const std::vector<std::shared_ptr<BezierCurve>> & curves = GetDrawnCurves();
+     Rect clip = GetClipRect(cr);
+     _rail_paths.resize(curves.size());
+
+     if(_edit_mode)
+     {
+         for(size_t idx = 0; idx < curves.size(); ++idx)
+         {
+             if(IsLive(idx) == live && clip.Intersects(curves[idx]->GetBounds()))
+                 DrawHandles(cr, *curves[idx]);
+         }
+     }
+
+     // every rail shares one style, so the visible rails are gathered into a
+     // single path and stroked once, over the ties filled the same way. Stale
+     // paths are recorded first since recording uses the current path of the
+     // context. The GL area draws all rails but the selection.
+     const bool rails = !UseGL();
+     for(size_t idx = 0; idx < curves.size(); ++idx)
+     {
+         if(IsLive(idx) == live && (rails || IsSelected(idx)) && clip.Intersects(curves[idx]->GetBounds()))
+             UpdateRailPath(cr, idx);
+     }
+     if(rails)
      {
-         DrawCurve(cr, curve);
+         bool ties = false;
+         cr->begin_new_path();
+         for(size_t idx = 0; idx < curves.size(); ++idx)
+         {
+             if(IsLive(idx) == live && _rail_paths[idx].ties && clip.Intersects(curves[idx]->GetBounds()))
+             {
+                 cr->append_path(*_rail_paths[idx].ties);
+                 ties = true;
+             }
+         }
+         if(ties)
+         {
+             cr->set_source_rgb(0.55, 0.35, 0.15);
+             cr->fill();
+             Stats::GetInstance().Add(STAT_STROKES_ISSUED, 1);
+         }
+
+         cr->begin_new_path();
+         for(size_t idx = 0; idx < curves.size(); ++idx)
+         {
+             if(IsLive(idx) == live && clip.Intersects(curves[idx]->GetBounds()))
+                 cr->append_path(*_rail_paths[idx].path);
+         }
+         // rails are kept one pixel wide at any zoom
+         cr->set_source_rgb(0, 0, 0);
+         cr->set_line_width(1.0 / _scale);
+         cr->stroke();
+         Stats::GetInstance().Add(STAT_STROKES_ISSUED, 1);
+     }
+
+     for(size_t idx = 0; idx < curves.size(); ++idx)
+     {
+         if(IsSelected(idx) && IsLive(idx) == live && clip.Intersects(curves[idx]->GetBounds()))
+         {
+             cr->append_path(*_rail_paths[idx].path);
+             cr->set_source_rgb(0.0, 0.3, 0.9);
+             cr->set_line_width(2.0 / _scale);
+             cr->stroke();
+             Stats::GetInstance().Add(STAT_STROKES_ISSUED, 1);
+         }
      }
 }
 
-void CurveView::DrawCurve(const Cairo::RefPtr<Cairo::Context>& cr,
-        std::shared_ptr<BezierCurve> & curve) const
+//-----------------------------------------------------------------------------
+//! \brief Composites the cached tiles of the static curves
+//!
+//! Tiles cover kTileSize widget pixels and are rendered at the current scale,
+//! so a change of scale discards all of them. Tiles overlapping the clip
+//! extents are rendered first if they are missing or were invalidated.
+//-----------------------------------------------------------------------------
+void CurveView::DrawTiles(const Cairo::RefPtr<Cairo::Context> &cr)
 {
-    cr->set_source_rgb(0, 0, 0);
-    cr->set_line_width(1);
+    if(_tile_scale != _scale)
+    {
+        _tiles.clear();
+        _tile_scale = _scale;
+    }
 
-    std::vector<Point> points = curve->GetCurve(1);
-    Point & p = points.front();
-    for(auto itr = points.begin()+1; itr != points.end(); ++itr)
+    double x1, y1, x2, y2;
+    cr->get_clip_extents(x1, y1, x2, y2);
+    int min_x = static_cast<int>(std::floor(x1 / kTileSize));
+    int min_y = static_cast<int>(std::floor(y1 / kTileSize));
+    int max_x = static_cast<int>(std::floor(x2 / kTileSize));
+    int max_y = static_cast<int>(std::floor(y2 / kTileSize));
+    for(int y = min_y; y <= max_y; ++y)
     {
-        cr->move_to(p.x, p.y);
-        p = *itr;
-        cr->line_to(p.x, p.y);
-        cr->stroke();
+        for(int x = min_x; x <= max_x; ++x)
+        {
+            Tile & tile = _tiles[GetTileKey(x, y)];
+            if(!tile.valid)
+                RenderTile(tile, x, y);
+            cr->set_source(tile.surface, x * kTileSize, y * kTileSize);
+            cr->rectangle(x * kTileSize, y * kTileSize, kTileSize, kTileSize);
+            cr->fill();
+            Stats::GetInstance().Add(STAT_STROKES_ISSUED, 1);
+        }
     }
+}
 
-    points = curve->GetCurve(2);
-    p = points.front();
-    for(auto itr = points.begin()+1; itr != points.end(); ++itr)
+//-----------------------------------------------------------------------------
+//! \brief Renders the static curves overlapping a tile into its surface
+//!
+//! \param tile the tile, its surface is created on first use and reused after
+//! \param x the horizontal tile index
+//! \param y the vertical tile index
+//-----------------------------------------------------------------------------
+void CurveView::RenderTile(Tile & tile, int x, int y)
+{
+    if(!tile.surface)
+        tile.surface = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, kTileSize, kTileSize);
+
+    Cairo::RefPtr<Cairo::Context> tile_cr = Cairo::Context::create(tile.surface);
+    tile_cr->set_operator(Cairo::OPERATOR_CLEAR);
+    tile_cr->paint();
+    tile_cr->set_operator(Cairo::OPERATOR_OVER);
+    tile_cr->translate(-x * kTileSize, -y * kTileSize);
+    tile_cr->scale(_scale, _scale);
+    DrawCurves(tile_cr, false);
+    tile.valid = true;
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Marks the tiles overlapping a box for rendering on the next draw
+//!
+//! \param bounds the box in curve coordinates
+//-----------------------------------------------------------------------------
+void CurveView::InvalidateTiles(const Rect & bounds)
+{
+    const double margin = kRedrawMargin * std::max(1.0F, _scale);
+    int min_x = static_cast<int>(std::floor((bounds.x * _scale - margin) / kTileSize));
+    int min_y = static_cast<int>(std::floor((bounds.y * _scale - margin) / kTileSize));
+    int max_x = static_cast<int>(std::floor(((bounds.x + bounds.width) * _scale + margin) / kTileSize));
+    int max_y = static_cast<int>(std::floor(((bounds.y + bounds.height) * _scale + margin) / kTileSize));
+    for(int y = min_y; y <= max_y; ++y)
     {
-        cr->move_to(p.x, p.y);
-        p = *itr;
-        cr->line_to(p.x, p.y);
-        cr->stroke();
+        for(int x = min_x; x <= max_x; ++x)
+        {
+            auto tile = _tiles.find(GetTileKey(x, y));
+            if(tile != _tiles.end())
+                tile->second.valid = false;
+        }
     }
 }
 
-bool CurveView::on_button_press(GdkEventButton * event)
+//-----------------------------------------------------------------------------
+//! \brief Marks every tile for rendering on the next draw
+//-----------------------------------------------------------------------------
+void CurveView::InvalidateTiles()
 {
-    bool hit = false;
-    if(_edit_mode)
+    for(auto & tile : _tiles)
+        tile.second.valid = false;
+}
+
+std::uint64_t CurveView::GetTileKey(int x, int y)
+{
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32) |
+           static_cast<std::uint32_t>(y);
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Records the rail and tie paths of a curve unless the cached ones are
+//!        current
+//!
+//! The level of detail is chosen on every call from the scale and the length
+//! of the curve on screen. The paths are recorded the first time the curve is
+//! drawn and again only after the curve revision or the detail changes, or
+//! the scale for a decimated centerline. Recording replaces the current path
+//! of the context.
+//!
+//! \param idx the index of the curve
+//-----------------------------------------------------------------------------
+void CurveView::UpdateRailPath(const Cairo::RefPtr<Cairo::Context>& cr, size_t idx)
+{
+    const std::shared_ptr<BezierCurve> & curve = GetDrawnCurves()[idx];
+    RailPath & cached = _rail_paths[idx];
+    unsigned long revision = curve->GetRevision();
+    DetailLevel detail = LevelOfDetail::Select(_scale, curve->GetParallelsDistance(), curve->GetLength());
+    if(cached.path == nullptr || cached.curve != curve.get() || cached.revision != revision ||
+       cached.detail != detail || (detail == DETAIL_CENTERLINE && cached.scale != _scale))
     {
-        for(auto itr = _curves.begin(); itr != _curves.end(); ++itr)
+        _detail.Build(*curve, detail, _scale);
+        cr->begin_new_path();
+        DrawCurve(cr);
+        cached.path.reset(cr->copy_path());
+        cached.ties.reset();
+        if(!_detail.GetTies().empty())
         {
-            auto & curve = *itr;
-            for(int i=0; i<4; i++)
-            {
-                const Point & p = curve->GetControlPoint(i);
-                Rect r {p.x-5, p.y-5, 10, 10};
-                if(r.Contains(event->x, event->y))
-                {
-                    _attached_active_curve = nullptr;
-                    _dragging = true;
-                    _drag_idx = i;
-                    if(i == 0 || i == 3)
-                        _drag_mode = DragMode::END_POINT;
-                    else
-                        _drag_mode = DragMode::CENTER_POINT;
-                    if( i <= 1&& itr != _curves.begin())
-                        _attached_active_curve = *(itr - 1);
-                    else if (i >= 2 && itr != _curves.end() - 1)
-                        _attached_active_curve = *(itr + 1);
-                    _active_curve = curve;
-                    hit = true;
-                    break;
-                }
-                if(hit)
-                    break;
-            }
+            cr->begin_new_path();
+            DrawTies(cr);
+            cached.ties.reset(cr->copy_path());
         }
+        cached.curve = curve.get();
+        cached.revision = revision;
+        cached.scale = _scale;
+        cached.detail = detail;
     }
-    return false;
 }
 
-bool CurveView::on_button_motion(GdkEventMotion * event)
+//-----------------------------------------------------------------------------
+//! \brief Gets the area being redrawn in curve coordinates
+//-----------------------------------------------------------------------------
+Rect CurveView::GetClipRect(const Cairo::RefPtr<Cairo::Context> &cr) const
 {
-    if(_dragging && _drag_mode == DragMode::END_POINT)
+    double x1, y1, x2, y2;
+    cr->get_clip_extents(x1, y1, x2, y2);
+    return Rect {x1, y1, x2 - x1, y2 - y1};
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Queues a redraw of the widget area covered by a curve bounding box
+//!
+//! \param bounds the box in curve coordinates, grown by the handle size before
+//!        it is converted to widget pixels
+//-----------------------------------------------------------------------------
+void CurveView::InvalidateBounds(const Rect & bounds)
+{
+    const double margin = kRedrawMargin * std::max(1.0F, _scale);
+    int x = static_cast<int>(std::floor(bounds.x * _scale - margin));
+    int y = static_cast<int>(std::floor(bounds.y * _scale - margin));
+    int width = static_cast<int>(std::ceil(bounds.width * _scale + 2.0 * margin)) + 1;
+    int height = static_cast<int>(std::ceil(bounds.height * _scale + 2.0 * margin)) + 1;
+    queue_draw_area(x, y, width, height);
+    // keep the overlay in the redrawn area so it shows the latest frame
+    if(_stats_overlay)
+        queue_draw_area(0, 0, kOverlayWidth, kOverlayHeight);
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Adds a curve to the track graph, joined to the end of the one before
+//-----------------------------------------------------------------------------
+void CurveView::AddToGraph(size_t idx)
+{
+    unsigned segment = _graph.AddSegment(_curves[idx]);
+    if(segment > 0)
+        _graph.Connect(segment - 1, TrackGraph::END_FINISH, segment, TrackGraph::END_START);
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Adds the rails, or the centerline, last built by _detail to the
+//!        current path
+//!
+//! Each polyline is one continuous sub path; stroking is left to the caller.
+//-----------------------------------------------------------------------------
+void CurveView::DrawCurve(const Cairo::RefPtr<Cairo::Context>& cr) const
+{
+    const std::vector<Point> & points = _detail.GetPoints();
+    const std::vector<unsigned> & starts = _detail.GetStarts();
+    for(size_t line = 0; line < starts.size(); ++line)
     {
-        const Point & p = _active_curve->GetControlPoint(_drag_idx);
-        double cx = event->x - p.x;
-        double cy = event->y - p.y;
-        _active_curve->SetControlPoint(event->x, event->y, _drag_idx);
-        Point attached_point;
-        if(_attached_active_curve != nullptr)
+        const size_t end = line + 1 < starts.size() ? starts[line + 1] : points.size();
+        cr->move_to(points[starts[line]].x, points[starts[line]].y);
+        for(size_t idx = starts[line] + 1; idx < end; ++idx)
+            cr->line_to(points[idx].x, points[idx].y);
+    }
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Adds the tie outlines last built by _detail to the current path
+//-----------------------------------------------------------------------------
+void CurveView::DrawTies(const Cairo::RefPtr<Cairo::Context>& cr) const
+{
+    for(const Quad & tie : _detail.GetTies())
+    {
+        cr->move_to(tie.corners[0].x, tie.corners[0].y);
+        for(unsigned i = 1; i < 4; ++i)
+            cr->line_to(tie.corners[i].x, tie.corners[i].y);
+        cr->close_path();
+    }
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Brings the spatial index entries of a curve up to date
+//!
+//! Must be called whenever the control points of the curve change, after the
+//! curve was added to the graph. Also checks the clearance of the curve again.
+//!
+//! \param idx the index of the curve
+//-----------------------------------------------------------------------------
+void CurveView::UpdateIndex(size_t idx)
+{
+    const BezierCurve & curve = *_curves[idx];
+    _curve_index.Insert(idx, curve.GetBounds());
+    _clearance.Update(_graph, idx);
+    for(unsigned i = 0; i < 4; i++)
+    {
+        const Point & p = curve.GetControlPoint(i);
+        _handle_index.Insert(idx * 4 + i, Rect {p.x - kHandleRadius, p.y - kHandleRadius,
+                                                2 * kHandleRadius, 2 * kHandleRadius});
+    }
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Removes the spatial index entries of a curve
+//-----------------------------------------------------------------------------
+void CurveView::RemoveIndex(size_t idx)
+{
+    _curve_index.Remove(idx);
+    _clearance.Remove(idx);
+    for(unsigned i = 0; i < 4; i++)
+        _handle_index.Remove(idx * 4 + i);
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Finds the control handle under a point
+//!
+//! \param x the horizontal position in curve coordinates
+//! \param y the vertical position in curve coordinates
+//! \param curve receives the index of the curve owning the handle
+//! \param handle receives the control point index of the handle
+//! \return true if a handle was hit, the one closest to the point if several are
+//-----------------------------------------------------------------------------
+bool CurveView::PickHandle(double x, double y, unsigned & curve, unsigned & handle)
+{
+    const Point position(x, y);
+    double closest = 0.0;
+    bool hit = false;
+
+    _hits.clear();
+    _handle_index.Query(x, y, _hits);
+    for(unsigned id : _hits)
+    {
+        double distance = _curves[id / 4]->GetControlPoint(id % 4).Distance(position);
+        if(!hit || distance < closest)
         {
-            if(_drag_idx == 0)
-            {
-                _attached_active_curve->SetControlPoint(event->x, event->y, 3);
-                attached_point = _attached_active_curve->GetControlPoint(2);
-                _attached_active_curve->SetControlPoint(attached_point.x + cx, attached_point.y + cy, 2);
-                attached_point = _active_curve->GetControlPoint(1);
-                _active_curve->SetControlPoint(attached_point.x + cx, attached_point.y + cy, 1);
-            }
-            else
-            {
-                _attached_active_curve->SetControlPoint(event->x, event->y, 0);
-                attached_point = _attached_active_curve->GetControlPoint(1);
-                _attached_active_curve->SetControlPoint(attached_point.x + cx, attached_point.y + cy, 1);
-                attached_point = _active_curve->GetControlPoint(2);
-                _active_curve->SetControlPoint(attached_point.x + cx, attached_point.y + cy, 2);
-            }
+            curve = id / 4;
+            handle = id % 4;
+            closest = distance;
+            hit = true;
         }
-       this->queue_draw();
     }
-    else if(_dragging && _drag_mode == DragMode::CENTER_POINT)
+    return hit;
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Finds the curve closest to a point
+//!
+//! \param x the horizontal position in curve coordinates
+//! \param y the vertical position in curve coordinates
+//! \param curve receives the index of the closest curve
+//! \return true if the centerline of a curve lies within kPickDistance pixels
+//!         of the point
+//-----------------------------------------------------------------------------
+bool CurveView::PickCurve(double x, double y, unsigned & curve)
+{
+    const std::vector<std::shared_ptr<BezierCurve>> & curves = GetDrawnCurves();
+    const Point position(x, y);
+    const double pick_distance = kPickDistance / _scale;
+    double closest = pick_distance;
+    bool hit = false;
+
+    _hits.clear();
+    _curve_index.Query(Rect {x - pick_distance, y - pick_distance,
+                             2 * pick_distance, 2 * pick_distance}, _hits);
+    for(unsigned id : _hits)
     {
-        const Point & p = _active_curve->GetControlPoint(_drag_idx);
-        double cx = event->x - p.x;
-        double cy = event->y - p.y;
-        _active_curve->SetControlPoint(event->x, event->y, _drag_idx);
-        unsigned attached_index = 0;
-        if(_drag_idx == 1)
+        if(id >= curves.size())
+            continue;
+        double distance = curves[id]->GetClosestPoint(position).Distance(position);
+        if(distance <= closest)
         {
-            if(_attached_active_curve !=nullptr)
-                attached_index = 2;
+            curve = id;
+            closest = distance;
+            hit = true;
         }
+    }
+    return hit;
+}
+
+bool CurveView::on_button_press(GdkEventButton * event)
+{
+    unsigned curve_idx;
+    unsigned handle_idx;
+    const double x = event->x / _scale;
+    const double y = event->y / _scale;
+    if(_edit_mode && PickHandle(x, y, curve_idx, handle_idx))
+    {
+        _attached_active_curve = nullptr;
+        _dragging = true;
+        _journal.BeginStep();
+        _drag_idx = handle_idx;
+        if(handle_idx == 0 || handle_idx == 3)
+            _drag_mode = DragMode::END_POINT;
         else
+            _drag_mode = DragMode::CENTER_POINT;
+        // the neighbor at the dragged end is edited along and drawn live as well
+        unsigned neighbor;
+        TrackGraph::End neighbor_end;
+        _attached_idx = curve_idx;
+        if(_graph.GetNeighbor(curve_idx, handle_idx <= 1 ? TrackGraph::END_START : TrackGraph::END_FINISH,
+                              neighbor, neighbor_end))
         {
-            if(_attached_active_curve !=nullptr)
-                attached_index = 1;
+            _attached_idx = neighbor;
+            _attached_active_curve = _curves[_attached_idx];
         }
-        if( attached_index != 0 )
+        _active_idx = curve_idx;
+        _active_curve = _curves[curve_idx];
+
+        // the dragged curves move from the tiles to the live layer
+        InvalidateTiles(_active_curve->GetBounds());
+        if(_attached_active_curve != nullptr)
+            InvalidateTiles(_attached_active_curve->GetBounds());
+        return false;
+    }
+
+    std::shared_ptr<BezierCurve> selected;
+    if(PickCurve(x, y, curve_idx))
+        selected = _curves[curve_idx];
+    if(selected != _selected_curve)
+    {
+        if(_selected_curve != nullptr)
         {
-            const Point & attached_point = _attached_active_curve->GetControlPoint(attached_index);
-            _attached_active_curve->SetControlPoint(attached_point.x - cx,
-                                                    attached_point.y - cy,
-                                                    attached_index);
+            InvalidateTiles(_selected_curve->GetBounds());
+            InvalidateBounds(_selected_curve->GetBounds());
         }
-        this->queue_draw();
+        if(selected != nullptr)
+        {
+            InvalidateTiles(selected->GetBounds());
+            InvalidateBounds(selected->GetBounds());
+        }
+        _selected_curve = selected;
     }
     return false;
 }
 
+bool CurveView::on_button_motion(GdkEventMotion * event)
+{
+    if(!_dragging)
+        return false;
+
+    if(_coalesce_motion)
+    {
+        _motion_point = Point(event->x / _scale, event->y / _scale);
+        _motion_pending = true;
+        if(_tick_id == 0)
+            _tick_id = add_tick_callback(sigc::mem_fun(*this, &CurveView::OnTick));
+    }
+    else
+        ApplyDrag(event->x / _scale, event->y / _scale);
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Moves the control points of the last drag back
+//!
+//! \return false if there is nothing to undo or a drag is in progress
+//-----------------------------------------------------------------------------
+bool CurveView::Undo()
+{
+    return Replay(true);
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Applies the last drag undone again
+//!
+//! \return false if there is nothing to redo or a drag is in progress
+//-----------------------------------------------------------------------------
+bool CurveView::Redo()
+{
+    return Replay(false);
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Undoes or redoes a step, redrawing only the curves it changed
+//-----------------------------------------------------------------------------
+bool CurveView::Replay(bool undo)
+{
+    if(_dragging || !(undo ? _journal.Undo(_graph) : _journal.Redo(_graph)))
+        return false;
+
+    for(const TrackGraph::Touch & touch : _journal.GetReplayed())
+    {
+        const Rect & bounds = _curves[touch.segment]->GetBounds();
+        UpdateIndex(touch.segment);
+        InvalidateTiles(touch.bounds);
+        InvalidateTiles(bounds);
+        if(_worker)
+            PostCurve(touch.segment);
+        else
+        {
+            InvalidateBounds(touch.bounds);
+            InvalidateBounds(bounds);
+        }
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Moves the dragged control point, and the points tied to it, to a
+//!        position
+//-----------------------------------------------------------------------------
+void CurveView::ApplyDrag(double x, double y)
+{
+    if(!_dragging)
+        return;
+
+    // the graph keeps the joints continuous and reports every curve it changed
+    _graph.MoveControlPoint(_active_idx, _drag_idx, Point(x, y));
+    _journal.Record(_graph);
+    for(const TrackGraph::Touch & touch : _graph.GetTouched())
+    {
+        const Rect & bounds = _curves[touch.segment]->GetBounds();
+        UpdateIndex(touch.segment);
+        // curves moved along besides the dragged ones are drawn from the tiles
+        if(!IsLive(touch.segment))
+        {
+            InvalidateTiles(touch.bounds);
+            InvalidateTiles(bounds);
+        }
+        // in the background mode the redraw follows the snapshot
+        if(_worker)
+            PostCurve(touch.segment);
+        else
+        {
+            InvalidateBounds(touch.bounds);
+            InvalidateBounds(bounds);
+        }
+    }
+}
+
 bool CurveView::on_button_release(GdkEventButton * event)
 {
-    _dragging = false;
+    // the curves end up at the release position, not one frame behind it
+    FlushMotion();
+    if(_dragging)
+    {
+        // the dragged curves are static again and go back into the tiles
+        _dragging = false;
+        _journal.EndStep(_graph);
+        InvalidateTiles(_active_curve->GetBounds());
+        InvalidateBounds(_active_curve->GetBounds());
+        if(_attached_active_curve != nullptr)
+        {
+            InvalidateTiles(_attached_active_curve->GetBounds());
+            InvalidateBounds(_attached_active_curve->GetBounds());
+        }
+    }
     return false;
 }
 //-----------------------------------------------------------------------------
@@ -334,6 +1179,7 @@ std::unique_ptr<BezierCurve> CurveView::CreateCurve() const
     x = std::rand() % 250;
     y = std::rand() % 250;
     curve->SetControlPoint(x, y, 3);
+    ConfigureCurve(*curve);
 
     return curve;
 }
@@ -0,0 +1,226 @@
+#include "EditJournal.h"
+
+#include <cassert>
+
+namespace ByteTrail {
+
+    constexpr unsigned EditJournal::kDefaultCapacity;
+
+    static TrackGraph::Touch GetTouch(unsigned segment, const BezierCurve &curve) {
+        TrackGraph::Touch touch;
+        touch.segment = segment;
+        touch.bounds = curve.GetBounds();
+        for (unsigned i = 0; i < 4; i++)
+            touch.points[i] = curve.GetControlPoint(i);
+        return touch;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Creates an empty journal
+    //!
+    //! \param capacity the number of control point changes kept over all steps
+    //-----------------------------------------------------------------------------------
+    EditJournal::EditJournal(unsigned capacity) :
+            _changes(capacity),
+            _steps(capacity),
+            _first(0),
+            _count(0),
+            _current(0),
+            _used(0),
+            _recording(false) {
+        assert(capacity > 0);
+    }
+
+    EditJournal::~EditJournal() {
+    }
+
+    unsigned EditJournal::GetCapacity() const {
+        return _changes.size();
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Drops every step, and the step being recorded
+    //-----------------------------------------------------------------------------------
+    void EditJournal::Clear() {
+        _first = 0;
+        _count = 0;
+        _current = 0;
+        _used = 0;
+        _recording = false;
+        _pending.clear();
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Opens a step, the edits recorded until EndStep() are undone together
+    //-----------------------------------------------------------------------------------
+    void EditJournal::BeginStep() {
+        _recording = true;
+        _pending.clear();
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Notes the segments changed by the last edit of a graph
+    //!
+    //! Must be called after every TrackGraph::MoveControlPoint() of the open step.
+    //! Segments touched before in the step keep the control points they had when it
+    //! was opened.
+    //-----------------------------------------------------------------------------------
+    void EditJournal::Record(const TrackGraph &graph) {
+        if (!_recording)
+            return;
+        for (const TrackGraph::Touch &touch : graph.GetTouched()) {
+            bool known = false;
+            for (const TrackGraph::Touch &pending : _pending)
+                known = known || pending.segment == touch.segment;
+            if (!known)
+                _pending.push_back(touch);
+        }
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Closes the open step, discarding the steps undone before it
+    //!
+    //! \param graph the graph edited, read for the control points after the step
+    //! \return true if any control point moved and the step was kept
+    //-----------------------------------------------------------------------------------
+    bool EditJournal::EndStep(const TrackGraph &graph) {
+        if (!_recording)
+            return false;
+        _recording = false;
+
+        unsigned size = 0;
+        for (const TrackGraph::Touch &touch : _pending) {
+            if (touch.segment >= graph.GetSegmentCount())
+                continue;
+            const BezierCurve &curve = *graph.GetCurve(touch.segment);
+            for (unsigned i = 0; i < 4; i++) {
+                if (!(curve.GetControlPoint(i) == touch.points[i]))
+                    ++size;
+            }
+        }
+        if (size == 0) {
+            _pending.clear();
+            return false;
+        }
+
+        const unsigned capacity = _changes.size();
+        while (_count > _current) {
+            --_count;
+            _used -= _steps[(_first + _count) % capacity].count;
+        }
+        if (size > capacity) {
+            // too large to keep, nothing before it can be undone either
+            Clear();
+            return false;
+        }
+        while (_count > 0 && _used + size > capacity) {
+            _used -= _steps[_first].count;
+            _first = (_first + 1) % capacity;
+            --_count;
+        }
+
+        const unsigned first = _count > 0 ? (_steps[_first].first + _used) % capacity : 0;
+        unsigned position = first;
+        for (const TrackGraph::Touch &touch : _pending) {
+            if (touch.segment >= graph.GetSegmentCount())
+                continue;
+            const BezierCurve &curve = *graph.GetCurve(touch.segment);
+            for (unsigned i = 0; i < 4; i++) {
+                const Point &after = curve.GetControlPoint(i);
+                if (!(after == touch.points[i])) {
+                    _changes[position] = Change {touch.segment, i, touch.points[i], after};
+                    position = (position + 1) % capacity;
+                }
+            }
+        }
+        if (_count == 0)
+            _first = 0;
+        _steps[(_first + _count) % capacity] = Step {first, size};
+        ++_count;
+        _current = _count;
+        _used += size;
+        _pending.clear();
+        return true;
+    }
+
+    bool EditJournal::IsRecording() const {
+        return _recording;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the number of steps kept, undone or not
+    //-----------------------------------------------------------------------------------
+    unsigned EditJournal::GetStepCount() const {
+        return _count;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the number of control point changes held by the steps kept
+    //-----------------------------------------------------------------------------------
+    unsigned EditJournal::GetChangeCount() const {
+        return _used;
+    }
+
+    bool EditJournal::CanUndo() const {
+        return !_recording && _current > 0;
+    }
+
+    bool EditJournal::CanRedo() const {
+        return !_recording && _current < _count;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Moves the control points of the last step applied back
+    //!
+    //! \return false if there is nothing to undo or a step is being recorded
+    //-----------------------------------------------------------------------------------
+    bool EditJournal::Undo(TrackGraph &graph) {
+        if (!CanUndo())
+            return false;
+        --_current;
+        Replay(graph, _steps[(_first + _current) % _steps.size()], true);
+        return true;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Applies the last step undone again
+    //!
+    //! \return false if there is nothing to redo or a step is being recorded
+    //-----------------------------------------------------------------------------------
+    bool EditJournal::Redo(TrackGraph &graph) {
+        if (!CanRedo())
+            return false;
+        Replay(graph, _steps[(_first + _current) % _steps.size()], false);
+        ++_current;
+        return true;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the segments changed by the last Undo() or Redo(), with their
+    //!        bounds and control points before it
+    //-----------------------------------------------------------------------------------
+    const std::vector<TrackGraph::Touch> &EditJournal::GetReplayed() const {
+        return _replayed;
+    }
+
+    void EditJournal::Replay(TrackGraph &graph, const Step &step, bool undo) {
+        _replayed.clear();
+        const unsigned capacity = _changes.size();
+        for (unsigned i = 0; i < step.count; i++) {
+            // undoing goes backwards, so the positions before are restored in order
+            const unsigned offset = undo ? step.count - 1 - i : i;
+            const Change &change = _changes[(step.first + offset) % capacity];
+            if (change.segment >= graph.GetSegmentCount())
+                continue;
+
+            BezierCurve &curve = *graph.GetCurve(change.segment);
+            bool known = false;
+            for (const TrackGraph::Touch &touch : _replayed)
+                known = known || touch.segment == change.segment;
+            if (!known)
+                _replayed.push_back(GetTouch(change.segment, curve));
+            curve.SetControlPoint(undo ? change.before : change.after, change.index);
+        }
+    }
+
+}
@@ -2,20 +2,21 @@
 
 #include "FlexTrackSegment.h"
 #include "NScale.h"
+#include "Stats.h"
 
 namespace ByteTrail
 {
 
   //-----------------------------------------------------------------------------
   //-----------------------------------------------------------------------------
-  FlexTrackSegment::FlexTrackSegment() {
+  FlexTrackSegment::FlexTrackSegment() : _ties_revision(0) {
       _curve = std::make_shared<BezierCurve>();
 
       _curve->SetControlPoint(0, 0, 0);
       _curve->SetControlPoint(kFlexTrackLength * 0.25, 0,  1);
       _curve->SetControlPoint(kFlexTrackLength * 0.75, 0, 2);
       _curve->SetControlPoint(kFlexTrackLength, 0, 3);
-      _curve->SetResolution(kFlexTrackLength / kAverageTieSpacing);
+      _curve->SetSamplingMode(SAMPLE_ARC_LENGTH);
   }
 
   FlexTrackSegment::~FlexTrackSegment() {
@@ -27,53 +28,97 @@ namespace ByteTrail
   }
 
 
-  //---------------------------------------------------------------------------
-  //! \brief Gets the points for each tie in a flex track segment
-  //---------------------------------------------------------------------------
-  void FlexTrackSegment::GetTies() {
-    const std::vector<Point> & tangent_points = _curve->GetTangentPoints();
+  //---------------------------------------------------------------------------
+  //! \brief Gets the tie outlines of a flex track segment
+  //!
+  //! The ties are regenerated when the curve has changed since they were last
+  //! generated.
+  //!
+  //! \return one quad per tie, stored contiguously
+  //---------------------------------------------------------------------------
+  const std::vector<Quad> & FlexTrackSegment::GetTies() {
+    ScopedTimer timer(STAT_TIMER_GET_TIES);
+    _curve->Update();
+    if(_curve->GetRevision() != _ties_revision) {
+      RegenerateTies();
+      _ties_revision = _curve->GetRevision();
+    }
+    return _ties;
+  }
+
+  //---------------------------------------------------------------------------
+  //! \brief Gets the tie outlines as a packed array
+  //!
+  //! \return GetTieCount() quads of 4 corners each, suitable for uploading to a
+  //!         renderer as a single buffer
+  //---------------------------------------------------------------------------
+  const Quad * FlexTrackSegment::GetTieData() {
+    return GetTies().data();
+  }
+
+  std::size_t FlexTrackSegment::GetTieCount() {
+    return GetTies().size();
+  }
+
+  //---------------------------------------------------------------------------
+  //! \brief Generates the outline of each tie in a flex track segment
+  //---------------------------------------------------------------------------
+  void FlexTrackSegment::RegenerateTies() {
+    GenerateTies(*_curve, _ties);
+  }
+
+  //---------------------------------------------------------------------------
+  //! \brief Generates the outline of each tie along a curve
+  //!
+  //! Ties are placed every kAverageTieSpacing along the curve using the arc
+  //! length table of the curve. The first and last ties are half a spacing from
+  //! the ends so that the spacing is kept across joined segments. Their
+  //! direction comes from the normals the curve already holds for its rails.
+  //!
+  //! All quads share one buffer that is reset, not freed, on regeneration, so
+  //! rebuilding the ties takes at most one allocation.
+  //!
+  //! \param curve the centerline of the track
+  //! \param ties receives one quad per tie
+  //---------------------------------------------------------------------------
+  void FlexTrackSegment::GenerateTies(BezierCurve & curve, std::vector<Quad> & ties) {
+    double length = curve.GetLength();
+    unsigned count = static_cast<unsigned>(length / kAverageTieSpacing + 0.5);
+
+    ties.clear();
+    ties.reserve(count);
 
-    // the tangent point is the midpoint of the tie
-    // need the +/- tie edges
-    const std::vector<Point> & points = _curve->GetCurve(0);
-    int idx = 0;
     double tieLength = kAverageTieLength / 2.0;
-    for(auto&& tan_pt : tangent_points) {
-      double tan_x = tan_pt.x;
-      double tan_y = tan_pt.y;
-
-      double dist = std::sqrt(tan_x * tan_x + tan_y * tan_y);
-      tan_x /= dist;
-      tan_y /= dist;
+    for(unsigned idx = 0; idx < count; idx++) {
+      // the curve point is the midpoint of the tie
+      // need the +/- tie edges
+      double distance = kAverageTieSpacing * (idx + 0.5);
+      Point center = curve.Evaluate(curve.GetParameterAtDistance(distance));
+      Point normal = curve.GetNormalAtDistance(distance);
+      // the normal turned back to the direction of travel
+      double tan_x = -normal.y;
+      double tan_y = normal.x;
       // offset from the midpoint along the tangent line
       Point pos;
-      pos.x = points[idx].x + kAverageTieWidth / 2.0 * tan_x;
-      pos.y = points[idx].y + kAverageTieWidth / 2.0 * tan_y;
-      // get the normal points for the tangent line offset
-      Point norm;
+      pos.x = center.x + kAverageTieWidth / 2.0 * tan_x;
+      pos.y = center.y + kAverageTieWidth / 2.0 * tan_y;
 
-      std::shared_ptr<Polygon> tie = std::make_shared<Polygon>();
-      // point 1
-      norm.x = pos.x + tan_y * tieLength;
-      norm.y = pos.y - tan_x * tieLength;
-      tie->Add(norm);
-      // point 2
-      norm.x = pos.x - tan_y * tieLength;
-      norm.y = pos.y + tan_x * tieLength;
-      tie->Add(norm);
+      ties.push_back(Quad());
+      Quad & tie = ties.back();
+      // corners 0 and 1 on the leading edge
+      tie.corners[0].x = pos.x + tan_y * tieLength;
+      tie.corners[0].y = pos.y - tan_x * tieLength;
+      tie.corners[1].x = pos.x - tan_y * tieLength;
+      tie.corners[1].y = pos.y + tan_x * tieLength;
 
-      pos.x = points[idx].x - kAverageTieWidth / 2.0 * tan_x;
-      pos.y = points[idx].y - kAverageTieWidth / 2.0 * tan_y;
-      // point 3
-      norm.x = pos.x + tan_y * tieLength;
-      norm.y = pos.y - tan_x * tieLength;
-      tie->Add(norm);
-      // point 4
-      norm.x = pos.x - tan_y * tieLength;
-      norm.y = pos.y + tan_x * tieLength;
-      tie->Add(norm);
-
-      idx++;
+      pos.x = center.x - kAverageTieWidth / 2.0 * tan_x;
+      pos.y = center.y - kAverageTieWidth / 2.0 * tan_y;
+      // corners 2 and 3 on the trailing edge, in perimeter order
+      tie.corners[2].x = pos.x - tan_y * tieLength;
+      tie.corners[2].y = pos.y + tan_x * tieLength;
+      tie.corners[3].x = pos.x + tan_y * tieLength;
+      tie.corners[3].y = pos.y - tan_x * tieLength;
     }
-  }
-} // namespace ByteTrail
+    Stats::GetInstance().Add(STAT_TIES_GENERATED, ties.size());
+  }
+} // namespace ByteTrail
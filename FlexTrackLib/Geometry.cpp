@@ -50,9 +50,98 @@ namespace ByteTrail {
     bool Rect::Contains(double x, double y) const {
         return ((x >= this->x) && (x <= (this->x + width)) && (y >= this->y) && (y <= (this->y+height)));
     }
+
+    bool Rect::Intersects(const Rect & other) const {
+        return ((other.x <= (x + width)) && (x <= (other.x + other.width)) &&
+                (other.y <= (y + height)) && (y <= (other.y + other.height)));
+    }
 
-  //---------------------------------------------------------------------------
-  //---------------------------------------------------------------------------
+  //---------------------------------------------------------------------------
+  //---------------------------------------------------------------------------
+  FlatPath::FlatPath() : _subpath_start(0) {
+  }
+
+  //---------------------------------------------------------------------------
+  //---------------------------------------------------------------------------
+  FlatPath::~FlatPath() {
+  }
+
+  //---------------------------------------------------------------------------
+  //! \brief Reserves storage for a number of path elements
+  //---------------------------------------------------------------------------
+  void FlatPath::Reserve(std::size_t elements) {
+    _types.reserve(elements);
+    _points.reserve(elements);
+  }
+
+  //---------------------------------------------------------------------------
+  //! \brief Removes all elements, keeping the allocated storage
+  //---------------------------------------------------------------------------
+  void FlatPath::Clear() {
+    _types.clear();
+    _points.clear();
+    _subpath_start = 0;
+  }
+
+  //---------------------------------------------------------------------------
+  //! \brief Starts a new sub path
+  //---------------------------------------------------------------------------
+  void FlatPath::MoveTo(const Point & point) {
+    _subpath_start = _types.size();
+    _types.push_back(SEG_MOVE_TO);
+    _points.push_back(point);
+  }
+
+  void FlatPath::MoveTo(double x, double y) {
+    MoveTo(Point(x, y));
+  }
+
+  //---------------------------------------------------------------------------
+  //! \brief Adds a line from the previous point to the current sub path
+  //---------------------------------------------------------------------------
+  void FlatPath::LineTo(const Point & point) {
+    _types.push_back(SEG_LINE_TO);
+    _points.push_back(point);
+  }
+
+  void FlatPath::LineTo(double x, double y) {
+    LineTo(Point(x, y));
+  }
+
+  //---------------------------------------------------------------------------
+  //! \brief Closes the current sub path
+  //---------------------------------------------------------------------------
+  void FlatPath::Close() {
+    if(_types.empty())
+      return;
+    Point start = _points[_subpath_start];
+    _types.push_back(SEG_CLOSE);
+    _points.push_back(start);
+  }
+
+  //---------------------------------------------------------------------------
+  //! \brief Removes the last element
+  //---------------------------------------------------------------------------
+  void FlatPath::PopBack() {
+    if(!_types.empty()) {
+      _types.pop_back();
+      _points.pop_back();
+    }
+  }
+
+  //---------------------------------------------------------------------------
+  //! \brief Gets the number of elements, including SEG_CLOSE elements
+  //---------------------------------------------------------------------------
+  std::size_t FlatPath::GetSize() const {
+    return _types.size();
+  }
+
+  bool FlatPath::IsEmpty() const {
+    return _types.empty();
+  }
+
+  //---------------------------------------------------------------------------
+  //---------------------------------------------------------------------------
   Polygon::Polygon() {
   }
 
@@ -62,30 +151,48 @@ namespace ByteTrail {
   }
 
   //---------------------------------------------------------------------------
-  //! \brief Adds a point to the polygon
-  //---------------------------------------------------------------------------
-  Polygon::Add(const Point & point) {
-    std::shared_ptr<PathSegment> segment = std::make_shared<PathSegment>();
-    if(_path.empty()) {
-      _path.push_back(std::make_shared<PathSegment>(PATH_SEGMENT_CLOSE));
-      segment->type = SEG_MOVE_TO;
+  //! \brief Adds a point to the polygon
+  //!
+  //! The path is kept closed: the first point is a SEG_MOVE_TO, the following
+  //! points are SEG_LINE_TO and the last element is always SEG_CLOSE.
+  //!
+  //! \return the index of the point in the polygon
+  //---------------------------------------------------------------------------
+  int Polygon::Add(const Point & point) {
+    if(_path.IsEmpty()) {
+      _path.MoveTo(point);
     } else {
-        segment->type = SEG_LINE_TO;
+      _path.PopBack();
+      _path.LineTo(point);
     }
-    std::shared_ptr<Point> pt = std::make_shared<Point>(point);
-    segment->point = std::move(pt);
-    _path.insert(_path.end(), segment);
+    _path.Close();
+    return GetSize() - 1;
   }
 
-  //---------------------------------------------------------------------------
-  //---------------------------------------------------------------------------
-  const std::list<std::shared_ptr<PathSegment>> & Polygon::GetPath() {
+  //---------------------------------------------------------------------------
+  //---------------------------------------------------------------------------
+  const FlatPath & Polygon::GetPath() {
       return _path;
   }
 
-  //---------------------------------------------------------------------------
-  //---------------------------------------------------------------------------
+  //---------------------------------------------------------------------------
+  //! \brief Gets the number of points in the polygon
+  //---------------------------------------------------------------------------
   int Polygon::GetSize() const {
-    return _path.size();
+    return _path.IsEmpty() ? 0 : _path.GetSize() - 1;
+  }
+
+  //---------------------------------------------------------------------------
+  //! \brief Reserves storage for a number of points
+  //---------------------------------------------------------------------------
+  void Polygon::Reserve(std::size_t points) {
+    _path.Reserve(points + 1);
+  }
+
+  //---------------------------------------------------------------------------
+  //! \brief Removes all points, keeping the allocated storage
+  //---------------------------------------------------------------------------
+  void Polygon::Clear() {
+    _path.Clear();
   }
 }
@@ -0,0 +1,134 @@
+#include "GeometryWorker.h"
+
+#include "Trace.h"
+
+namespace ByteTrail {
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Starts the worker with an empty snapshot
+    //!
+    //! \param pool spreads edits touching many curves over more threads; nothing else
+    //!        may run loops on it while the worker exists
+    //! \param published called on the worker thread after each new snapshot
+    //-----------------------------------------------------------------------------------
+    GeometryWorker::GeometryWorker(TaskPool &pool, std::function<void()> published) :
+            _recalculator(pool),
+            _published(published),
+            _count(0),
+            _busy(false),
+            _stop(false),
+            _snapshot(std::make_shared<Snapshot>(Snapshot{0, Curves()})) {
+        _thread = std::thread(&GeometryWorker::Run, this);
+    }
+
+    GeometryWorker::~GeometryWorker() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _wake.notify_all();
+        _thread.join();
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Posts the new state of a curve
+    //!
+    //! The curve is copied, so posting is cheap when its geometry was never
+    //! calculated. An edit replaces any edit of the same curve not yet picked up.
+    //!
+    //! \param idx the index of the curve, below the count given to Resize()
+    //! \param curve the control points and settings to recalculate
+    //-----------------------------------------------------------------------------------
+    void GeometryWorker::Post(std::size_t idx, const BezierCurve &curve) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto itr = _pending.find(idx);
+            if (itr != _pending.end())
+                itr->second = curve;
+            else
+                _pending.insert(std::make_pair(idx, curve));
+        }
+        _wake.notify_one();
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Sets the number of curves of the layout
+    //!
+    //! Curves past the end are dropped from the next snapshot, new curves are empty
+    //! until posted.
+    //-----------------------------------------------------------------------------------
+    void GeometryWorker::Resize(std::size_t count) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _count = count;
+            _pending.erase(_pending.lower_bound(count), _pending.end());
+        }
+        _wake.notify_one();
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Blocks until everything posted so far is in the published snapshot
+    //-----------------------------------------------------------------------------------
+    void GeometryWorker::Wait() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _idle.wait(lock, [this]() {
+            return !_busy && _pending.empty() && _count == std::atomic_load(&_snapshot)->curves.size();
+        });
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the latest snapshot, from any thread
+    //-----------------------------------------------------------------------------------
+    std::shared_ptr<const GeometryWorker::Snapshot> GeometryWorker::GetSnapshot() const {
+        return std::atomic_load(&_snapshot);
+    }
+
+    void GeometryWorker::Run() {
+        std::map<std::size_t, BezierCurve> edits;
+        for (;;) {
+            std::size_t count;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _busy = false;
+                _idle.notify_all();
+                _wake.wait(lock, [this]() {
+                    return _stop || !_pending.empty() ||
+                           _count != std::atomic_load(&_snapshot)->curves.size();
+                });
+                if (_stop)
+                    return;
+                edits.swap(_pending);
+                count = _count;
+                _busy = true;
+            }
+
+            // the back buffer starts out sharing every curve of the front one
+            std::shared_ptr<const Snapshot> front = std::atomic_load(&_snapshot);
+            std::shared_ptr<Snapshot> back = std::make_shared<Snapshot>(*front);
+            back->generation = front->generation + 1;
+            back->curves.resize(count);
+            _changed.clear();
+            for (std::size_t idx = front->curves.size(); idx < count; idx++) {
+                if (edits.find(idx) == edits.end()) {
+                    back->curves[idx] = std::make_shared<BezierCurve>();
+                    _changed.push_back(back->curves[idx]);
+                }
+            }
+            for (auto &edit : edits) {
+                if (edit.first >= count)
+                    continue;
+                std::shared_ptr<BezierCurve> curve = std::make_shared<BezierCurve>(edit.second);
+                back->curves[edit.first] = curve;
+                _changed.push_back(curve);
+            }
+            edits.clear();
+            FT_TRACE1(TRACE_GEOMETRY, "worker recalculate", _changed.size());
+            _recalculator.Recalculate(_changed);
+
+            std::atomic_store(&_snapshot, std::shared_ptr<const Snapshot>(std::move(back)));
+            if (_published)
+                _published();
+        }
+    }
+
+}
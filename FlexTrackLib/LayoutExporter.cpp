@@ -0,0 +1,281 @@
+#include "LayoutExporter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "Trace.h"
+
+namespace ByteTrail {
+
+    constexpr std::size_t BufferedSink::kBufferSize;
+    constexpr unsigned BufferedSink::kDecimals;
+
+    // longest number written by WriteNumber()
+    static const std::size_t kMaximumNumber = 32;
+
+    BufferedSink::BufferedSink(std::ostream &out) :
+            _out(out),
+            _buffer(kBufferSize),
+            _used(0),
+            _bytes_written(0),
+            _chunk_count(0) {
+    }
+
+    BufferedSink::~BufferedSink() {
+        Flush();
+    }
+
+    void BufferedSink::Write(const char *text) {
+        Write(text, std::strlen(text));
+    }
+
+    void BufferedSink::Write(const char *text, std::size_t size) {
+        if (_used + size > _buffer.size()) {
+            Flush();
+            if (size > _buffer.size()) {
+                _out.write(text, size);
+                _bytes_written += size;
+                ++_chunk_count;
+                return;
+            }
+        }
+        std::memcpy(_buffer.data() + _used, text, size);
+        _used += size;
+    }
+
+    void BufferedSink::Write(char c) {
+        if (_used == _buffer.size())
+            Flush();
+        _buffer[_used++] = c;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Writes a number with kDecimals decimal places, trailing zeros removed
+    //!
+    //! The digits are produced directly into the buffer, independent of the locale,
+    //! since both formats need a '.' decimal separator.
+    //-----------------------------------------------------------------------------------
+    void BufferedSink::WriteNumber(double value) {
+        if (_used + kMaximumNumber > _buffer.size())
+            Flush();
+
+        static const double kScale = std::pow(10.0, kDecimals);
+        double scaled = std::round(std::abs(value) * kScale);
+        if (!(scaled < 1.0e18))
+            scaled = 0.0;
+        unsigned long long digits = static_cast<unsigned long long>(scaled);
+
+        char text[kMaximumNumber];
+        char *end = text + kMaximumNumber;
+        char *p = end;
+        unsigned places = kDecimals;
+        // drop trailing zeros of the fraction
+        while (places > 0 && digits % 10 == 0) {
+            digits /= 10;
+            --places;
+        }
+        for (; places > 0; --places) {
+            *--p = static_cast<char>('0' + digits % 10);
+            digits /= 10;
+        }
+        if (p != end)
+            *--p = '.';
+        do {
+            *--p = static_cast<char>('0' + digits % 10);
+            digits /= 10;
+        } while (digits > 0);
+        if (value < 0.0 && scaled != 0.0)
+            *--p = '-';
+
+        std::memcpy(_buffer.data() + _used, p, end - p);
+        _used += end - p;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Hands the buffered output to the stream
+    //-----------------------------------------------------------------------------------
+    void BufferedSink::Flush() {
+        if (_used > 0) {
+            _out.write(_buffer.data(), _used);
+            _bytes_written += _used;
+            ++_chunk_count;
+            _used = 0;
+        }
+    }
+
+    bool BufferedSink::IsGood() const {
+        return static_cast<bool>(_out);
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the number of bytes handed to the stream so far
+    //-----------------------------------------------------------------------------------
+    std::size_t BufferedSink::GetBytesWritten() const {
+        return _bytes_written;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the number of writes made to the stream so far
+    //-----------------------------------------------------------------------------------
+    std::size_t BufferedSink::GetChunkCount() const {
+        return _chunk_count;
+    }
+
+    LayoutExporter::LayoutExporter(std::ostream &out, ExportFormat format) :
+            _sink(out),
+            _format(format) {
+    }
+
+    LayoutExporter::~LayoutExporter() {
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Writes the start of a document
+    //!
+    //! \param bounds the area covered by the layout, used as the SVG view box and the
+    //!        DXF extents
+    //-----------------------------------------------------------------------------------
+    void LayoutExporter::Begin(const Rect &bounds) {
+        if (_format == EXPORT_SVG) {
+            _sink.Write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                        "<svg xmlns=\"http://www.w3.org/2000/svg\" viewBox=\"");
+            _sink.WriteNumber(bounds.x);
+            _sink.Write(' ');
+            _sink.WriteNumber(bounds.y);
+            _sink.Write(' ');
+            _sink.WriteNumber(bounds.width);
+            _sink.Write(' ');
+            _sink.WriteNumber(bounds.height);
+            _sink.Write("\">\n"
+                        "<style>.rail{fill:none;stroke:#000;stroke-width:0.2}"
+                        ".tie{fill:none;stroke:#804000;stroke-width:0.1}</style>\n");
+        } else {
+            _sink.Write("0\nSECTION\n2\nHEADER\n9\n$EXTMIN\n");
+            WriteCoordinate(bounds.x, bounds.y + bounds.height);
+            _sink.Write("9\n$EXTMAX\n");
+            WriteCoordinate(bounds.x + bounds.width, bounds.y);
+            _sink.Write("0\nENDSEC\n0\nSECTION\n2\nENTITIES\n");
+        }
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Writes both rails of a curve
+    //-----------------------------------------------------------------------------------
+    void LayoutExporter::WriteCurve(BezierCurve &curve) {
+        PointView left = curve.GetLeftRail();
+        WritePolyline(left.data(), left.size(), false, "RAILS");
+        PointView right = curve.GetRightRail();
+        WritePolyline(right.data(), right.size(), false, "RAILS");
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Writes both rails and the tie outlines of a flex track segment
+    //-----------------------------------------------------------------------------------
+    void LayoutExporter::WriteSegment(FlexTrackSegment &segment) {
+        WriteCurve(*segment.GetCurve());
+        const Quad *ties = segment.GetTieData();
+        const std::size_t count = segment.GetTieCount();
+        for (std::size_t idx = 0; idx < count; idx++)
+            WritePolyline(ties[idx].corners, 4, true, "TIES");
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Writes the end of the document and flushes the output
+    //!
+    //! \return false if writing to the stream failed
+    //-----------------------------------------------------------------------------------
+    bool LayoutExporter::End() {
+        if (_format == EXPORT_SVG)
+            _sink.Write("</svg>\n");
+        else
+            _sink.Write("0\nENDSEC\n0\nEOF\n");
+        _sink.Flush();
+        return _sink.IsGood();
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Writes a whole document from a layout file
+    //!
+    //! Each record is loaded into the same scratch segment, so its curve buffers and
+    //! tie buffer are sized once and reused for every segment.
+    //!
+    //! \return the number of segments written, or 0 if writing to the stream failed
+    //-----------------------------------------------------------------------------------
+    unsigned LayoutExporter::Export(const LayoutFile &file) {
+        const unsigned count = file.GetSegmentCount();
+        FT_TRACE1(TRACE_GEOMETRY, "export layout", count);
+        Rect bounds {0, 0, 0, 0};
+        for (unsigned segment = 0; segment < count; segment++) {
+            const Rect other = file.GetBounds(segment);
+            if (segment == 0) {
+                bounds = other;
+                continue;
+            }
+            const double right = std::max(bounds.x + bounds.width, other.x + other.width);
+            const double bottom = std::max(bounds.y + bounds.height, other.y + other.height);
+            bounds.x = std::min(bounds.x, other.x);
+            bounds.y = std::min(bounds.y, other.y);
+            bounds.width = right - bounds.x;
+            bounds.height = bottom - bounds.y;
+        }
+
+        Begin(bounds);
+        if (_scratch == nullptr)
+            _scratch.reset(new FlexTrackSegment());
+        BezierCurve &curve = *_scratch->GetCurve();
+        for (unsigned segment = 0; segment < count; segment++) {
+            for (unsigned i = 0; i < 4; i++)
+                curve.SetControlPoint(file.GetControlPoint(segment, i), i);
+            curve.SetResolution(file.GetResolution(segment));
+            curve.SetParallelsDistance(file.GetParallelsDistance(segment));
+            WriteSegment(*_scratch);
+        }
+        return End() ? count : 0;
+    }
+
+    const BufferedSink &LayoutExporter::GetSink() const {
+        return _sink;
+    }
+
+    void LayoutExporter::WritePolyline(const Point *points, std::size_t count, bool closed, const char *layer) {
+        if (count < 2)
+            return;
+        if (_format == EXPORT_SVG) {
+            _sink.Write(closed ? "<polygon class=\"tie\" points=\"" : "<polyline class=\"rail\" points=\"");
+            for (std::size_t idx = 0; idx < count; idx++) {
+                if (idx > 0)
+                    _sink.Write(' ');
+                _sink.WriteNumber(points[idx].x);
+                _sink.Write(',');
+                _sink.WriteNumber(points[idx].y);
+            }
+            _sink.Write("\"/>\n");
+        } else {
+            _sink.Write("0\nPOLYLINE\n8\n");
+            _sink.Write(layer);
+            _sink.Write(closed ? "\n66\n1\n70\n1\n" : "\n66\n1\n70\n0\n");
+            for (std::size_t idx = 0; idx < count; idx++) {
+                _sink.Write("0\nVERTEX\n8\n");
+                _sink.Write(layer);
+                _sink.Write('\n');
+                WriteCoordinate(points[idx].x, points[idx].y);
+            }
+            _sink.Write("0\nSEQEND\n8\n");
+            _sink.Write(layer);
+            _sink.Write('\n');
+        }
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Writes a DXF point, flipping y so the drawing is not mirrored
+    //-----------------------------------------------------------------------------------
+    void LayoutExporter::WriteCoordinate(double x, double y) {
+        _sink.Write("10\n");
+        _sink.WriteNumber(x);
+        _sink.Write("\n20\n");
+        _sink.WriteNumber(-y);
+        _sink.Write('\n');
+    }
+
+}
@@ -0,0 +1,370 @@
+#include "LayoutFile.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ByteTrail {
+
+    constexpr std::uint32_t LayoutFile::kVersion;
+    constexpr std::size_t LayoutFile::kHeaderSize;
+    constexpr std::size_t LayoutFile::kRecordSize;
+    constexpr std::uint32_t LayoutFile::kNoLink;
+    constexpr std::uint32_t LayoutFile::kFlagFixed;
+    constexpr float LayoutFile::kMinimumResolution;
+
+    static const char kMagic[4] = {'F', 'T', 'L', 'Y'};
+
+    // field offsets within a segment record
+    static const std::size_t kControlPointsField = 0;
+    static const std::size_t kBoundsField = 64;
+    static const std::size_t kResolutionField = 96;
+    static const std::size_t kDistanceField = 100;
+    static const std::size_t kLinksField = 104;
+    static const std::size_t kFlagsField = 112;
+
+    //-----------------------------------------------------------------------------------
+    // Little endian encoding, independent of the host byte order. On little endian
+    // hosts the compiler reduces the byte loops to plain loads and stores.
+    //-----------------------------------------------------------------------------------
+    static inline std::uint32_t ReadU32(const unsigned char *p) {
+        return static_cast<std::uint32_t>(p[0]) | static_cast<std::uint32_t>(p[1]) << 8 |
+               static_cast<std::uint32_t>(p[2]) << 16 | static_cast<std::uint32_t>(p[3]) << 24;
+    }
+
+    static inline std::uint64_t ReadU64(const unsigned char *p) {
+        return static_cast<std::uint64_t>(ReadU32(p)) | static_cast<std::uint64_t>(ReadU32(p + 4)) << 32;
+    }
+
+    static inline double ReadF64(const unsigned char *p) {
+        std::uint64_t bits = ReadU64(p);
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    static inline float ReadF32(const unsigned char *p) {
+        std::uint32_t bits = ReadU32(p);
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    static inline void WriteU32(unsigned char *p, std::uint32_t value) {
+        for (unsigned i = 0; i < 4; i++)
+            p[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+
+    static inline void WriteU64(unsigned char *p, std::uint64_t value) {
+        WriteU32(p, static_cast<std::uint32_t>(value));
+        WriteU32(p + 4, static_cast<std::uint32_t>(value >> 32));
+    }
+
+    static inline void WriteF64(unsigned char *p, double value) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        WriteU64(p, bits);
+    }
+
+    static inline void WriteF32(unsigned char *p, float value) {
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        WriteU32(p, bits);
+    }
+
+    LayoutFile::LayoutFile() :
+            _data(nullptr),
+            _size(0),
+            _segment_count(0),
+            _record_size(0),
+            _records_offset(0),
+            _version(0),
+#ifdef _WIN32
+            _file(INVALID_HANDLE_VALUE),
+            _mapping(nullptr) {
+#else
+            _file(-1) {
+#endif
+    }
+
+    LayoutFile::~LayoutFile() {
+        Close();
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Writes the segments of a graph and their joints
+    //!
+    //! \return false if the file could not be written
+    //-----------------------------------------------------------------------------------
+    bool LayoutFile::Write(const std::string &path, const TrackGraph &graph) {
+        const unsigned count = graph.GetSegmentCount();
+        std::vector<unsigned char> data(kHeaderSize + count * kRecordSize, 0);
+
+        unsigned char *header = data.data();
+        std::memcpy(header, kMagic, sizeof(kMagic));
+        WriteU32(header + 4, kVersion);
+        WriteU32(header + 8, count);
+        WriteU32(header + 12, kRecordSize);
+        WriteU64(header + 16, kHeaderSize);
+
+        for (unsigned segment = 0; segment < count; segment++) {
+            unsigned char *record = data.data() + kHeaderSize + segment * kRecordSize;
+            const BezierCurve &curve = *graph.GetCurve(segment);
+            for (unsigned i = 0; i < 4; i++) {
+                const Point &p = curve.GetControlPoint(i);
+                WriteF64(record + kControlPointsField + i * 16, p.x);
+                WriteF64(record + kControlPointsField + i * 16 + 8, p.y);
+            }
+            const Rect &bounds = curve.GetBounds();
+            WriteF64(record + kBoundsField, bounds.x);
+            WriteF64(record + kBoundsField + 8, bounds.y);
+            WriteF64(record + kBoundsField + 16, bounds.width);
+            WriteF64(record + kBoundsField + 24, bounds.height);
+            WriteF32(record + kResolutionField, curve.GetResolution());
+            WriteF32(record + kDistanceField, curve.GetParallelsDistance());
+
+            for (unsigned end = 0; end < 2; end++) {
+                unsigned other;
+                TrackGraph::End other_end;
+                std::uint32_t link = kNoLink;
+                if (graph.GetNeighbor(segment, static_cast<TrackGraph::End>(end), other, other_end))
+                    link = other * 2 + other_end;
+                WriteU32(record + kLinksField + end * 4, link);
+            }
+            WriteU32(record + kFlagsField, graph.IsFixed(segment) ? kFlagFixed : 0);
+        }
+
+        std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(data.data()), data.size());
+        return static_cast<bool>(out);
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Maps a layout file
+    //!
+    //! \return false if the file cannot be mapped, is not a layout file, is of a
+    //!         later version or is truncated
+    //-----------------------------------------------------------------------------------
+    bool LayoutFile::Open(const std::string &path) {
+        Close();
+#ifdef _WIN32
+        _file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (_file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(_file, &size) || size.QuadPart < static_cast<LONGLONG>(kHeaderSize)) {
+            Close();
+            return false;
+        }
+        _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (_mapping == nullptr) {
+            Close();
+            return false;
+        }
+        _data = static_cast<const unsigned char *>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+        _size = static_cast<std::size_t>(size.QuadPart);
+#else
+        _file = open(path.c_str(), O_RDONLY);
+        if (_file < 0)
+            return false;
+        struct stat status;
+        if (fstat(_file, &status) != 0 || status.st_size < static_cast<off_t>(kHeaderSize)) {
+            Close();
+            return false;
+        }
+        void *data = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, _file, 0);
+        _data = data == MAP_FAILED ? nullptr : static_cast<const unsigned char *>(data);
+        _size = status.st_size;
+#endif
+        if (_data == nullptr || std::memcmp(_data, kMagic, sizeof(kMagic)) != 0) {
+            Close();
+            return false;
+        }
+
+        _version = ReadU32(_data + 4);
+        _segment_count = ReadU32(_data + 8);
+        _record_size = ReadU32(_data + 12);
+        const std::uint64_t records_offset = ReadU64(_data + 16);
+        if (_version == 0 || _version > kVersion || _record_size < kRecordSize || records_offset > _size ||
+            (_size - records_offset) / _record_size < _segment_count) {
+            Close();
+            return false;
+        }
+        _records_offset = static_cast<std::size_t>(records_offset);
+        return true;
+    }
+
+    void LayoutFile::Close() {
+#ifdef _WIN32
+        if (_data != nullptr)
+            UnmapViewOfFile(_data);
+        if (_mapping != nullptr)
+            CloseHandle(_mapping);
+        if (_file != INVALID_HANDLE_VALUE)
+            CloseHandle(_file);
+        _mapping = nullptr;
+        _file = INVALID_HANDLE_VALUE;
+#else
+        if (_data != nullptr)
+            munmap(const_cast<unsigned char *>(_data), _size);
+        if (_file >= 0)
+            close(_file);
+        _file = -1;
+#endif
+        _data = nullptr;
+        _size = 0;
+        _segment_count = 0;
+        _version = 0;
+    }
+
+    bool LayoutFile::IsOpen() const {
+        return _data != nullptr;
+    }
+
+    unsigned LayoutFile::GetVersion() const {
+        return _version;
+    }
+
+    unsigned LayoutFile::GetSegmentCount() const {
+        return _segment_count;
+    }
+
+    const unsigned char *LayoutFile::GetRecord(unsigned segment) const {
+        assert(segment < _segment_count);
+        return _data + _records_offset + segment * _record_size;
+    }
+
+    Point LayoutFile::GetControlPoint(unsigned segment, unsigned index) const {
+        assert(index < 4);
+        const unsigned char *field = GetRecord(segment) + kControlPointsField + index * 16;
+        return Point(ReadF64(field), ReadF64(field + 8));
+    }
+
+    Rect LayoutFile::GetBounds(unsigned segment) const {
+        const unsigned char *field = GetRecord(segment) + kBoundsField;
+        return Rect {ReadF64(field), ReadF64(field + 8), ReadF64(field + 16), ReadF64(field + 24)};
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the resolution of a segment, the default if the record holds one
+    //!        a curve cannot take
+    //-----------------------------------------------------------------------------------
+    float LayoutFile::GetResolution(unsigned segment) const {
+        const float resolution = ReadF32(GetRecord(segment) + kResolutionField);
+        // also false for NaN
+        if (resolution >= kMinimumResolution && resolution < 1.0F)
+            return resolution;
+        return BezierCurve::kDefaultResolution;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the rail distance of a segment, the default if the record holds
+    //!        one that is not finite
+    //-----------------------------------------------------------------------------------
+    float LayoutFile::GetParallelsDistance(unsigned segment) const {
+        const float distance = ReadF32(GetRecord(segment) + kDistanceField);
+        return std::isfinite(distance) ? distance : BezierCurve::kDefaultDistance;
+    }
+
+    bool LayoutFile::IsFixed(unsigned segment) const {
+        return (ReadU32(GetRecord(segment) + kFlagsField) & kFlagFixed) != 0;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the end slot joined to an end, kNoLink if it is open
+    //-----------------------------------------------------------------------------------
+    unsigned LayoutFile::GetLink(unsigned segment, TrackGraph::End end) const {
+        return ReadU32(GetRecord(segment) + kLinksField + end * 4);
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Finds the segments whose bounds overlap an area
+    //!
+    //! Scans the bounds in the records, which is a sequential read of the mapping.
+    //!
+    //! \param segments receives the segment indices in file order
+    //-----------------------------------------------------------------------------------
+    void LayoutFile::Query(const Rect &area, std::vector<unsigned> &segments) const {
+        segments.clear();
+        for (unsigned segment = 0; segment < _segment_count; segment++) {
+            if (area.Intersects(GetBounds(segment)))
+                segments.push_back(segment);
+        }
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Creates the curve of a segment, not yet tessellated
+    //-----------------------------------------------------------------------------------
+    std::shared_ptr<BezierCurve> LayoutFile::CreateCurve(unsigned segment) const {
+        std::shared_ptr<BezierCurve> curve = std::make_shared<BezierCurve>();
+        for (unsigned i = 0; i < 4; i++)
+            curve->SetControlPoint(GetControlPoint(segment, i), i);
+        curve->SetResolution(GetResolution(segment));
+        curve->SetParallelsDistance(GetParallelsDistance(segment));
+        return curve;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Creates and tessellates the curves of the segments in view
+    //!
+    //! Curves created by an earlier call are kept; segments out of view are left
+    //! null. The curves in view are recalculated together in a batch.
+    //!
+    //! \param viewport the area in view, in layout coordinates
+    //! \param curves one entry per segment, resized to the segment count
+    //! \param batch evaluates the curves in view
+    //! \return the number of curves created
+    //-----------------------------------------------------------------------------------
+    unsigned LayoutFile::LoadVisible(const Rect &viewport, std::vector<std::shared_ptr<BezierCurve>> &curves,
+                                     BezierBatch &batch) {
+        curves.resize(_segment_count);
+        Query(viewport, _visible);
+
+        unsigned created = 0;
+        _visible_curves.clear();
+        for (unsigned segment : _visible) {
+            if (curves[segment] == nullptr) {
+                curves[segment] = CreateCurve(segment);
+                ++created;
+            }
+            _visible_curves.push_back(curves[segment]);
+        }
+        batch.Recalculate(_visible_curves);
+        return created;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Adds every segment and joint of the file to a graph
+    //!
+    //! The curves are created but not tessellated.
+    //-----------------------------------------------------------------------------------
+    void LayoutFile::Load(TrackGraph &graph) const {
+        const unsigned first = graph.GetSegmentCount();
+        for (unsigned segment = 0; segment < _segment_count; segment++) {
+            graph.AddSegment(CreateCurve(segment));
+            graph.SetFixed(first + segment, IsFixed(segment));
+        }
+        for (unsigned segment = 0; segment < _segment_count; segment++) {
+            for (unsigned end = 0; end < 2; end++) {
+                const unsigned link = GetLink(segment, static_cast<TrackGraph::End>(end));
+                // each joint is stored at both ends, connect it once
+                if (link != kNoLink && link / 2 < _segment_count && link > segment * 2 + end) {
+                    graph.Connect(first + segment, static_cast<TrackGraph::End>(end),
+                                  first + link / 2, static_cast<TrackGraph::End>(link % 2));
+                }
+            }
+        }
+    }
+
+}
@@ -0,0 +1,378 @@
+#include <epoxy/gl.h>
+#include <iostream>
+#include <limits>
+#include "LayoutGLArea.h"
+#include "NScale.h"
+#include "Trace.h"
+
+namespace ByteTrail {
+
+  // centerline vertex with the offset to the left rail, side is 1 for the left
+  // rail, -1 for the right one and 0 for the centerline
+  static const char * kRailVertexShader =
+    "#version 330 core\n"
+    "layout(location = 0) in vec2 a_point;\n"
+    "layout(location = 1) in vec2 a_offset;\n"
+    "uniform vec2 u_viewport;\n"
+    "uniform float u_scale;\n"
+    "uniform float u_side;\n"
+    "void main()\n"
+    "{\n"
+    "  vec2 p = (a_point + u_side * a_offset) * u_scale;\n"
+    "  gl_Position = vec4(p.x / u_viewport.x * 2.0 - 1.0, 1.0 - p.y / u_viewport.y * 2.0, 0.0, 1.0);\n"
+    "}\n";
+
+  // corner of a unit quad expanded around the center of a tie instance
+  static const char * kTieVertexShader =
+    "#version 330 core\n"
+    "layout(location = 0) in vec2 a_corner;\n"
+    "layout(location = 1) in vec2 a_center;\n"
+    "layout(location = 2) in vec2 a_direction;\n"
+    "uniform vec2 u_viewport;\n"
+    "uniform float u_scale;\n"
+    "uniform vec2 u_tie_size;\n"
+    "void main()\n"
+    "{\n"
+    "  vec2 normal = vec2(-a_direction.y, a_direction.x);\n"
+    "  vec2 p = (a_center + a_direction * a_corner.x * u_tie_size.y\n"
+    "      + normal * a_corner.y * u_tie_size.x) * u_scale;\n"
+    "  gl_Position = vec4(p.x / u_viewport.x * 2.0 - 1.0, 1.0 - p.y / u_viewport.y * 2.0, 0.0, 1.0);\n"
+    "}\n";
+
+  static const char * kFragmentShader =
+    "#version 330 core\n"
+    "uniform vec4 u_color;\n"
+    "out vec4 color;\n"
+    "void main()\n"
+    "{\n"
+    "  color = u_color;\n"
+    "}\n";
+
+  // triangle strip of the quad a tie is expanded from
+  static const float kQuadCorners[] = { -1.0F, -1.0F, 1.0F, -1.0F, -1.0F, 1.0F, 1.0F, 1.0F };
+
+  //---------------------------------------------------------------------------
+  //! \brief Compiles a shader, logging the errors
+  //!
+  //! \return the shader or 0 if it did not compile
+  //---------------------------------------------------------------------------
+  static GLuint CompileShader(GLenum type, const char * source)
+  {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+
+    GLint status = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if(status != GL_TRUE)
+    {
+      char log[512];
+      glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+      std::cerr << "LayoutGLArea: shader compilation failed: " << log << std::endl;
+      glDeleteShader(shader);
+      return 0;
+    }
+    return shader;
+  }
+
+
+LayoutGLArea::LayoutGLArea() : _available(false), _enabled(false), _scale(1.0F),
+        _detail(DETAIL_RAILS), _rail_program(0), _tie_program(0), _rail_array(0),
+        _tie_array(0), _quad_buffer(0), _layout_revision(0)
+{
+    for(unsigned array = 0; array < LayoutVertexBuffer::ARRAY_COUNT; ++array)
+    {
+        _buffers[array] = 0;
+        _capacity[array] = 0;
+    }
+    set_required_version(3, 3);
+    set_has_depth_buffer(false);
+}
+
+LayoutGLArea::~LayoutGLArea()
+{
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Checks if the buffers and shaders were created
+//!
+//! False until the widget is realized and whenever OpenGL 3.3 is missing.
+//-----------------------------------------------------------------------------
+bool LayoutGLArea::IsAvailable() const
+{
+    return _available;
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Turns drawing of the layout on or off
+//!
+//! When off the area only clears to the background, CurveView drawing the
+//! layout with Cairo on top.
+//-----------------------------------------------------------------------------
+void LayoutGLArea::SetEnabled(bool enabled)
+{
+    if(enabled != _enabled)
+    {
+        _enabled = enabled;
+        queue_render();
+    }
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Brings the vertex data up to date with the curves drawn
+//!
+//! Called by the view on each frame. Curves that did not change since the last
+//! call cost only a revision check, so a drag rewrites a single slot.
+//!
+//! \param curves the curves in their drawing order
+//! \param scale pixels per layout unit
+//-----------------------------------------------------------------------------
+void LayoutGLArea::Sync(const std::vector<std::shared_ptr<BezierCurve>> & curves, float scale)
+{
+    if(!_available || !_enabled)
+        return;
+    FT_TRACE1(TRACE_GEOMETRY, "LayoutGLArea::Sync", curves.size());
+
+    const double distance = curves.empty() ? 0.0 : curves.front()->GetParallelsDistance();
+    // the length is left out so whole layouts switch detail at once
+    const DetailLevel detail = LevelOfDetail::Select(scale, distance, std::numeric_limits<double>::max());
+    bool changed = scale != _scale || detail != _detail;
+
+    _vertices.Resize(curves.size());
+    for(size_t idx = 0; idx < curves.size(); ++idx)
+    {
+        if(_vertices.Update(idx, *curves[idx], detail == DETAIL_TIES))
+            changed = true;
+    }
+
+    _scale = scale;
+    _detail = detail;
+    if(changed)
+        queue_render();
+}
+
+void LayoutGLArea::on_realize()
+{
+    Gtk::GLArea::on_realize();
+    make_current();
+    try
+    {
+        throw_if_error();
+    }
+    catch(const Glib::Error & error)
+    {
+        std::cerr << "LayoutGLArea: no OpenGL context: " << error.what() << std::endl;
+        _available = false;
+        return;
+    }
+
+    if(!CreateProgram(_rail_program, _rail_uniforms, kRailVertexShader) ||
+       !CreateProgram(_tie_program, _tie_uniforms, kTieVertexShader))
+    {
+        Release();
+        return;
+    }
+
+    glGenBuffers(LayoutVertexBuffer::ARRAY_COUNT, _buffers);
+    glGenBuffers(1, &_quad_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, _quad_buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(kQuadCorners), kQuadCorners, GL_STATIC_DRAW);
+
+    const GLsizei stride = LayoutVertexBuffer::kRailStride * sizeof(float);
+
+    glGenVertexArrays(1, &_rail_array);
+    glBindVertexArray(_rail_array);
+    glBindBuffer(GL_ARRAY_BUFFER, _buffers[LayoutVertexBuffer::ARRAY_RAILS]);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void *>(0));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void *>(2 * sizeof(float)));
+
+    // the quad per vertex, the tie center and direction per instance
+    glGenVertexArrays(1, &_tie_array);
+    glBindVertexArray(_tie_array);
+    glBindBuffer(GL_ARRAY_BUFFER, _quad_buffer);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), reinterpret_cast<void *>(0));
+    glBindBuffer(GL_ARRAY_BUFFER, _buffers[LayoutVertexBuffer::ARRAY_TIES]);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void *>(0));
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void *>(2 * sizeof(float)));
+    glVertexAttribDivisor(2, 1);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // everything is uploaded again into the new buffers
+    _layout_revision = _vertices.GetLayoutRevision() + 1;
+    _available = true;
+}
+
+void LayoutGLArea::on_unrealize()
+{
+    make_current();
+    try
+    {
+        throw_if_error();
+        Release();
+    }
+    catch(const Glib::Error &)
+    {
+        // the objects went with the context
+    }
+    _available = false;
+    Gtk::GLArea::on_unrealize();
+}
+
+bool LayoutGLArea::on_render(const Glib::RefPtr<Gdk::GLContext> & /* context */)
+{
+    glClearColor(1.0F, 1.0F, 1.0F, 1.0F);
+    glClear(GL_COLOR_BUFFER_BIT);
+    if(!_available || !_enabled)
+        return true;
+    FT_TRACE1(TRACE_GEOMETRY, "LayoutGLArea::on_render", _vertices.GetSize());
+
+    const bool whole = _vertices.GetLayoutRevision() != _layout_revision;
+    _layout_revision = _vertices.GetLayoutRevision();
+    Upload(LayoutVertexBuffer::ARRAY_RAILS, whole);
+    Upload(LayoutVertexBuffer::ARRAY_TIES, whole);
+
+    const float width = get_width();
+    const float height = get_height();
+
+    if(_detail == DETAIL_TIES && _vertices.GetTieCount() > 0)
+    {
+        glUseProgram(_tie_program);
+        glUniform2f(_tie_uniforms.viewport, width, height);
+        glUniform1f(_tie_uniforms.scale, _scale);
+        glUniform2f(_tie_uniforms.tie_size, kAverageTieLength / 2.0F, kAverageTieWidth / 2.0F);
+        glUniform4f(_tie_uniforms.color, 0.55F, 0.35F, 0.15F, 1.0F);
+        glBindVertexArray(_tie_array);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, _vertices.GetTieCount());
+    }
+
+    _vertices.GetRailStrips(_firsts, _counts);
+    if(!_firsts.empty())
+    {
+        glUseProgram(_rail_program);
+        glUniform2f(_rail_uniforms.viewport, width, height);
+        glUniform1f(_rail_uniforms.scale, _scale);
+        glUniform4f(_rail_uniforms.color, 0.0F, 0.0F, 0.0F, 1.0F);
+        glBindVertexArray(_rail_array);
+        if(_detail == DETAIL_CENTERLINE)
+        {
+            glUniform1f(_rail_uniforms.side, 0.0F);
+            glMultiDrawArrays(GL_LINE_STRIP, _firsts.data(), _counts.data(), _firsts.size());
+        }
+        else
+        {
+            for(float side : { 1.0F, -1.0F })
+            {
+                glUniform1f(_rail_uniforms.side, side);
+                glMultiDrawArrays(GL_LINE_STRIP, _firsts.data(), _counts.data(), _firsts.size());
+            }
+        }
+    }
+
+    glBindVertexArray(0);
+    glUseProgram(0);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Links a program from a vertex shader and the fragment shader
+//!
+//! \return false if it failed to compile or link
+//-----------------------------------------------------------------------------
+bool LayoutGLArea::CreateProgram(unsigned & program, Uniforms & uniforms, const char * vertex_source)
+{
+    GLuint vertex = CompileShader(GL_VERTEX_SHADER, vertex_source);
+    GLuint fragment = CompileShader(GL_FRAGMENT_SHADER, kFragmentShader);
+    if(vertex == 0 || fragment == 0)
+    {
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+        return false;
+    }
+
+    program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    glLinkProgram(program);
+    glDetachShader(program, vertex);
+    glDetachShader(program, fragment);
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if(status != GL_TRUE)
+    {
+        char log[512];
+        glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+        std::cerr << "LayoutGLArea: shader linking failed: " << log << std::endl;
+        glDeleteProgram(program);
+        program = 0;
+        return false;
+    }
+
+    uniforms.viewport = glGetUniformLocation(program, "u_viewport");
+    uniforms.scale = glGetUniformLocation(program, "u_scale");
+    uniforms.side = glGetUniformLocation(program, "u_side");
+    uniforms.tie_size = glGetUniformLocation(program, "u_tie_size");
+    uniforms.color = glGetUniformLocation(program, "u_color");
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Uploads what changed of an array since the last frame
+//!
+//! \param whole true if the slots moved and all of the array has to be uploaded
+//-----------------------------------------------------------------------------
+void LayoutGLArea::Upload(LayoutVertexBuffer::Array array, bool whole)
+{
+    const std::vector<float> & data = _vertices.GetData(array);
+    LayoutVertexBuffer::Range range;
+    const bool dirty = _vertices.TakeDirty(array, range);
+
+    glBindBuffer(GL_ARRAY_BUFFER, _buffers[array]);
+    if(data.size() > _capacity[array])
+    {
+        // grown with room, so curves appended do not reallocate every frame
+        _capacity[array] = data.size() + data.size() / 2;
+        glBufferData(GL_ARRAY_BUFFER, _capacity[array] * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
+        whole = true;
+    }
+    if(whole)
+        glBufferSubData(GL_ARRAY_BUFFER, 0, data.size() * sizeof(float), data.data());
+    else if(dirty)
+        glBufferSubData(GL_ARRAY_BUFFER, range.first * sizeof(float), range.count * sizeof(float),
+                        data.data() + range.first);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+//-----------------------------------------------------------------------------
+//! \brief Deletes the programs, buffers and vertex arrays
+//-----------------------------------------------------------------------------
+void LayoutGLArea::Release()
+{
+    glDeleteVertexArrays(1, &_rail_array);
+    glDeleteVertexArrays(1, &_tie_array);
+    glDeleteBuffers(LayoutVertexBuffer::ARRAY_COUNT, _buffers);
+    glDeleteBuffers(1, &_quad_buffer);
+    glDeleteProgram(_rail_program);
+    glDeleteProgram(_tie_program);
+
+    _rail_array = _tie_array = _quad_buffer = 0;
+    _rail_program = _tie_program = 0;
+    for(unsigned array = 0; array < LayoutVertexBuffer::ARRAY_COUNT; ++array)
+    {
+        _buffers[array] = 0;
+        _capacity[array] = 0;
+    }
+    _available = false;
+}
+
+}
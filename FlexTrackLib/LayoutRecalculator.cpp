@@ -0,0 +1,93 @@
+#include "LayoutRecalculator.h"
+
+namespace ByteTrail {
+
+    constexpr std::size_t LayoutRecalculator::kGrainSize;
+
+    LayoutRecalculator::LayoutRecalculator(TaskPool &pool) :
+            _pool(pool) {
+    }
+
+    LayoutRecalculator::~LayoutRecalculator() {
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Counts the curves that need to be recalculated
+    //-----------------------------------------------------------------------------------
+    std::size_t LayoutRecalculator::GetModifiedCount(const std::vector<std::shared_ptr<BezierCurve>> &curves) {
+        std::size_t count = 0;
+        for (const auto &curve : curves) {
+            if (curve->IsModified())
+                ++count;
+        }
+        return count;
+    }
+
+    std::size_t LayoutRecalculator::GetModifiedCount(const SegmentStore &curves) {
+        std::size_t count = 0;
+        for (const BezierCurve &curve : curves) {
+            if (curve.IsModified())
+                ++count;
+        }
+        return count;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Recalculates every modified curve
+    //!
+    //! Only the modified curves are dealt out so that every chunk carries the same
+    //! amount of work. Each curve is recalculated by its own engine, which measures
+    //! faster per curve than the batch evaluator once the work is spread over cores.
+    //!
+    //! \param curves the curves of the layout
+    //! \return the number of curves recalculated
+    //-----------------------------------------------------------------------------------
+    std::size_t LayoutRecalculator::Recalculate(std::vector<std::shared_ptr<BezierCurve>> &curves) {
+        _modified.clear();
+        for (auto &curve : curves) {
+            if (curve->IsModified())
+                _modified.push_back(curve.get());
+        }
+        return RecalculateModified();
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Recalculates every modified curve of a store
+    //!
+    //! \return the number of curves recalculated
+    //-----------------------------------------------------------------------------------
+    std::size_t LayoutRecalculator::Recalculate(SegmentStore &curves) {
+        _modified.clear();
+        for (BezierCurve &curve : curves) {
+            if (curve.IsModified())
+                _modified.push_back(&curve);
+        }
+        return RecalculateModified();
+    }
+
+    std::size_t LayoutRecalculator::RecalculateModified() {
+        BezierCurve **modified = _modified.data();
+        _pool.ParallelFor(_modified.size(), kGrainSize,
+                [modified](std::size_t begin, std::size_t end, unsigned) {
+                    for (std::size_t idx = begin; idx < end; idx++)
+                        modified[idx]->Update();
+                });
+        return _modified.size();
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Recalculates the curve and regenerates the ties of every segment that
+    //!        changed
+    //!
+    //! \param segments the segments of the layout, each with a curve of its own
+    //-----------------------------------------------------------------------------------
+    void LayoutRecalculator::Recalculate(std::vector<std::shared_ptr<FlexTrackSegment>> &segments) {
+        std::shared_ptr<FlexTrackSegment> *data = segments.data();
+        _pool.ParallelFor(segments.size(), kGrainSize,
+                [data](std::size_t begin, std::size_t end, unsigned) {
+                    for (std::size_t idx = begin; idx < end; idx++)
+                        data[idx]->GetTies();
+                });
+    }
+
+}
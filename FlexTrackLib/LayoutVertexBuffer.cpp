@@ -0,0 +1,241 @@
+#include "LayoutVertexBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "FlexTrackSegment.h"
+
+namespace ByteTrail {
+
+    constexpr unsigned LayoutVertexBuffer::kRailStride;
+    constexpr unsigned LayoutVertexBuffer::kTieStride;
+
+    // revision of an entry that has not been written
+    static const unsigned long kNoRevision = ~0UL;
+    // floats per vertex or instance, the same for every array
+    static const std::size_t kStride = 4;
+
+    static_assert(LayoutVertexBuffer::kRailStride == kStride && LayoutVertexBuffer::kTieStride == kStride,
+                  "slots are sized in units of kStride floats");
+
+    LayoutVertexBuffer::LayoutVertexBuffer() :
+            _layout_revision(0) {
+        for (unsigned array = 0; array < ARRAY_COUNT; array++) {
+            _unused[array] = 0;
+            _dirty[array] = Range {0, 0};
+        }
+    }
+
+    LayoutVertexBuffer::~LayoutVertexBuffer() {
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Sets the number of curves, releasing the slots of curves removed
+    //-----------------------------------------------------------------------------------
+    void LayoutVertexBuffer::Resize(unsigned curves) {
+        for (unsigned idx = curves; idx < _entries.size(); idx++) {
+            for (unsigned array = 0; array < ARRAY_COUNT; array++)
+                Allocate(idx, static_cast<Array>(array), 0);
+        }
+        Entry empty;
+        for (unsigned array = 0; array < ARRAY_COUNT; array++)
+            empty.slots[array] = Slot {0, 0, 0};
+        empty.rails_revision = kNoRevision;
+        empty.ties_revision = kNoRevision;
+        _entries.resize(curves, empty);
+        for (unsigned array = 0; array < ARRAY_COUNT; array++) {
+            if (_unused[array] * 2 > _data[array].size() / kStride)
+                Compact(static_cast<Array>(array));
+        }
+    }
+
+    unsigned LayoutVertexBuffer::GetSize() const {
+        return _entries.size();
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Rewrites the slots of a curve if it changed since it was last written
+    //!
+    //! \param idx the index of the curve
+    //! \param curve the curve, recalculated if it is modified
+    //! \param ties true to bring the tie instances up to date as well. Ties are only
+    //!        generated while they are drawn.
+    //! \return true if any data changed
+    //-----------------------------------------------------------------------------------
+    bool LayoutVertexBuffer::Update(unsigned idx, BezierCurve &curve, bool ties) {
+        curve.Update();
+        Entry &entry = _entries[idx];
+        const unsigned long revision = curve.GetRevision();
+        bool changed = false;
+
+        if (entry.rails_revision != revision) {
+            PointView center = curve.GetCenterline();
+            PointView left = curve.GetLeftRail();
+            const std::size_t count = std::min(center.size(), left.size());
+            float *out = Allocate(idx, ARRAY_RAILS, count);
+            for (std::size_t i = 0; i < count; i++, out += kStride) {
+                out[0] = static_cast<float>(center[i].x);
+                out[1] = static_cast<float>(center[i].y);
+                out[2] = static_cast<float>(left[i].x - center[i].x);
+                out[3] = static_cast<float>(left[i].y - center[i].y);
+            }
+            entry.rails_revision = revision;
+            changed = true;
+        }
+
+        if (ties && entry.ties_revision != revision) {
+            FlexTrackSegment::GenerateTies(curve, _ties);
+            float *out = Allocate(idx, ARRAY_TIES, _ties.size());
+            for (const Quad &tie : _ties) {
+                // corners 0 and 3 are offset from each other along the track only
+                const double dx = tie.corners[0].x - tie.corners[3].x;
+                const double dy = tie.corners[0].y - tie.corners[3].y;
+                const double length = std::sqrt(dx * dx + dy * dy);
+                out[0] = static_cast<float>((tie.corners[0].x + tie.corners[2].x) / 2.0);
+                out[1] = static_cast<float>((tie.corners[0].y + tie.corners[2].y) / 2.0);
+                out[2] = length > 0.0 ? static_cast<float>(dx / length) : 0.0F;
+                out[3] = length > 0.0 ? static_cast<float>(dy / length) : 0.0F;
+                out += kStride;
+            }
+            entry.ties_revision = revision;
+            changed = true;
+        }
+
+        for (unsigned array = 0; array < ARRAY_COUNT; array++) {
+            if (_unused[array] * 2 > _data[array].size() / kStride)
+                Compact(static_cast<Array>(array));
+        }
+        return changed;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the packed floats of an array, kRailStride or kTieStride per item
+    //-----------------------------------------------------------------------------------
+    const std::vector<float> &LayoutVertexBuffer::GetData(Array array) const {
+        return _data[array];
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets a number that changes whenever slots were moved
+    //!
+    //! Data already uploaded is invalid after a change and has to be uploaded again
+    //! as a whole.
+    //-----------------------------------------------------------------------------------
+    unsigned long LayoutVertexBuffer::GetLayoutRevision() const {
+        return _layout_revision;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets and clears the range of floats of an array changed since the last
+    //!        call
+    //!
+    //! \return false if nothing changed
+    //-----------------------------------------------------------------------------------
+    bool LayoutVertexBuffer::TakeDirty(Array array, Range &range) {
+        if (_dirty[array].count == 0)
+            return false;
+        range = _dirty[array];
+        _dirty[array] = Range {0, 0};
+        return true;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the first vertex and the number of vertices of every rail strip
+    //!
+    //! Suitable for drawing all rails with a single glMultiDrawArrays() call.
+    //-----------------------------------------------------------------------------------
+    void LayoutVertexBuffer::GetRailStrips(std::vector<int> &firsts, std::vector<int> &counts) const {
+        firsts.clear();
+        counts.clear();
+        for (const Entry &entry : _entries) {
+            const Slot &slot = entry.slots[ARRAY_RAILS];
+            if (slot.count >= 2) {
+                firsts.push_back(static_cast<int>(slot.first));
+                counts.push_back(static_cast<int>(slot.count));
+            }
+        }
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the number of tie instances to draw, including the unused ones
+    //!
+    //! Unused instances are zero and draw nothing, so the whole array is drawn with
+    //! one instanced call.
+    //-----------------------------------------------------------------------------------
+    std::size_t LayoutVertexBuffer::GetTieCount() const {
+        return _data[ARRAY_TIES].size() / kStride;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Sizes the slot of a curve in an array
+    //!
+    //! \param count the number of vertices or instances the curve needs
+    //! \return the first float of the slot, marked dirty for count items
+    //-----------------------------------------------------------------------------------
+    float *LayoutVertexBuffer::Allocate(unsigned idx, Array array, std::size_t count) {
+        Slot &slot = _entries[idx].slots[array];
+        std::vector<float> &data = _data[array];
+
+        if (count > slot.capacity || count == 0) {
+            // release the slot zeroed, so stale ties draw nothing
+            if (slot.capacity > 0) {
+                std::fill(data.begin() + slot.first * kStride,
+                          data.begin() + (slot.first + slot.capacity) * kStride, 0.0F);
+                MarkDirty(array, slot.first * kStride, slot.capacity * kStride);
+                _unused[array] += slot.capacity;
+            }
+            slot = Slot {data.size() / kStride, 0, 0};
+            if (count > 0) {
+                // room to grow, so small edits keep their slot
+                slot.capacity = count + count / 4 + 8;
+                data.resize((slot.first + slot.capacity) * kStride, 0.0F);
+            }
+        } else if (count < slot.count) {
+            std::fill(data.begin() + (slot.first + count) * kStride,
+                      data.begin() + (slot.first + slot.count) * kStride, 0.0F);
+            MarkDirty(array, (slot.first + count) * kStride, (slot.count - count) * kStride);
+        }
+
+        slot.count = count;
+        MarkDirty(array, slot.first * kStride, count * kStride);
+        return data.data() + slot.first * kStride;
+    }
+
+    void LayoutVertexBuffer::MarkDirty(Array array, std::size_t first, std::size_t count) {
+        if (count == 0)
+            return;
+        Range &dirty = _dirty[array];
+        if (dirty.count == 0) {
+            dirty = Range {first, count};
+        } else {
+            const std::size_t end = std::max(dirty.first + dirty.count, first + count);
+            dirty.first = std::min(dirty.first, first);
+            dirty.count = end - dirty.first;
+        }
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Packs the slots of an array in curve order, dropping the unused space
+    //-----------------------------------------------------------------------------------
+    void LayoutVertexBuffer::Compact(Array array) {
+        std::vector<float> &data = _data[array];
+        std::vector<float> packed;
+        std::size_t size = 0;
+        for (const Entry &entry : _entries)
+            size += entry.slots[array].capacity;
+        packed.reserve(size * kStride);
+
+        for (Entry &entry : _entries) {
+            Slot &slot = entry.slots[array];
+            const std::size_t first = packed.size() / kStride;
+            packed.insert(packed.end(), data.begin() + slot.first * kStride,
+                          data.begin() + (slot.first + slot.capacity) * kStride);
+            slot.first = first;
+        }
+        data.swap(packed);
+        _unused[array] = 0;
+        _dirty[array] = Range {0, data.size()};
+        ++_layout_revision;
+    }
+
+}
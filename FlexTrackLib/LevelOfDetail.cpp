@@ -0,0 +1,105 @@
+#include "LevelOfDetail.h"
+
+#include <algorithm>
+
+#include "FlexTrackSegment.h"
+#include "NScale.h"
+
+namespace ByteTrail {
+
+    constexpr double LevelOfDetail::kTiePixels;
+    constexpr double LevelOfDetail::kRailPixels;
+    constexpr double LevelOfDetail::kRailLengthPixels;
+    constexpr double LevelOfDetail::kCenterlinePixels;
+
+    LevelOfDetail::LevelOfDetail() {
+    }
+
+    LevelOfDetail::~LevelOfDetail() {
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Chooses the detail of a segment
+    //!
+    //! \param scale pixels per layout unit
+    //! \param parallels_distance distance from the centerline to each rail
+    //! \param length length of the segment in layout units
+    //-----------------------------------------------------------------------------------
+    DetailLevel LevelOfDetail::Select(double scale, double parallels_distance, double length) {
+        if (2.0 * parallels_distance * scale < kRailPixels || length * scale < kRailLengthPixels)
+            return DETAIL_CENTERLINE;
+        if (kAverageTieSpacing * scale < kTiePixels)
+            return DETAIL_RAILS;
+        return DETAIL_TIES;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the step through the points of a polyline that leaves them about
+    //!        kCenterlinePixels apart on screen
+    //!
+    //! \param points the number of points of the polyline
+    //! \param screen_length the length of the polyline in pixels
+    //! \return 1 to keep every point
+    //-----------------------------------------------------------------------------------
+    unsigned LevelOfDetail::GetStride(std::size_t points, double screen_length) {
+        if (points < 3)
+            return 1;
+        if (!(screen_length > 0.0))
+            return points - 1;
+        const double spacing = screen_length / (points - 1);
+        return std::max(1U, static_cast<unsigned>(kCenterlinePixels / spacing));
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Builds the polylines and ties of a segment at a detail level
+    //!
+    //! \param curve the centerline of the segment, recalculated if it is modified
+    //! \param level the detail to build, see Select()
+    //! \param scale pixels per layout unit, decimates the centerline
+    //-----------------------------------------------------------------------------------
+    void LevelOfDetail::Build(BezierCurve &curve, DetailLevel level, double scale) {
+        _points.clear();
+        _starts.clear();
+        _ties.clear();
+        if (level == DETAIL_CENTERLINE) {
+            PointView centerline = curve.GetCenterline();
+            AddPolyline(centerline, GetStride(centerline.size(), curve.GetLength() * scale));
+            return;
+        }
+        AddPolyline(curve.GetLeftRail(), 1);
+        AddPolyline(curve.GetRightRail(), 1);
+        if (level == DETAIL_TIES)
+            FlexTrackSegment::GenerateTies(curve, _ties);
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the points of every polyline, see GetStarts()
+    //-----------------------------------------------------------------------------------
+    const std::vector<Point> &LevelOfDetail::GetPoints() const {
+        return _points;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the index of the first point of each polyline
+    //-----------------------------------------------------------------------------------
+    const std::vector<unsigned> &LevelOfDetail::GetStarts() const {
+        return _starts;
+    }
+
+    const std::vector<Quad> &LevelOfDetail::GetTies() const {
+        return _ties;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Adds every stride-th point of a polyline, always keeping both ends
+    //-----------------------------------------------------------------------------------
+    void LevelOfDetail::AddPolyline(const PointView &points, unsigned stride) {
+        if (points.empty())
+            return;
+        _starts.push_back(_points.size());
+        for (std::size_t idx = 0; idx + 1 < points.size(); idx += stride)
+            _points.push_back(points[idx]);
+        _points.push_back(points.back());
+    }
+
+}
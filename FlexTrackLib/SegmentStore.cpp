@@ -0,0 +1,169 @@
+#include "SegmentStore.h"
+
+#include <cassert>
+#include <type_traits>
+#include <utility>
+
+namespace ByteTrail {
+
+    constexpr SegmentStore::Handle SegmentStore::kNoHandle;
+    constexpr unsigned SegmentStore::kNoIndex;
+
+    // growing the array and removing curves move them, which must neither copy the
+    // sample buffers nor throw half way
+    static_assert(std::is_nothrow_move_constructible<BezierCurve>::value &&
+                  std::is_nothrow_move_assignable<BezierCurve>::value,
+                  "curves are moved within the store");
+
+    SegmentStore::SegmentStore() {
+    }
+
+    SegmentStore::~SegmentStore() {
+    }
+
+    unsigned SegmentStore::GetSize() const {
+        return _curves.size();
+    }
+
+    bool SegmentStore::IsEmpty() const {
+        return _curves.empty();
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Allocates room for a number of curves, so adding them does not move any
+    //-----------------------------------------------------------------------------------
+    void SegmentStore::Reserve(unsigned size) {
+        _curves.reserve(size);
+        _owners.reserve(size);
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Removes every curve, invalidating every handle given out
+    //-----------------------------------------------------------------------------------
+    void SegmentStore::Clear() {
+        _curves.clear();
+        _owners.clear();
+        _free.clear();
+        for (std::uint32_t slot = 0; slot < _indices.size(); slot++) {
+            if (_indices[slot] != kNoIndex) {
+                _indices[slot] = kNoIndex;
+                ++_generations[slot];
+            }
+            _free.push_back(slot);
+        }
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Adds a copy of a curve
+    //!
+    //! \return the handle of the new curve
+    //-----------------------------------------------------------------------------------
+    SegmentStore::Handle SegmentStore::Add(const BezierCurve &curve) {
+        _curves.push_back(curve);
+        return Link();
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Adds a curve, taking over its point buffers
+    //!
+    //! \return the handle of the new curve
+    //-----------------------------------------------------------------------------------
+    SegmentStore::Handle SegmentStore::Add(BezierCurve &&curve) {
+        _curves.push_back(std::move(curve));
+        return Link();
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Removes a curve, moving the last curve into its place
+    //!
+    //! \return false if the handle names no curve
+    //-----------------------------------------------------------------------------------
+    bool SegmentStore::Remove(Handle handle) {
+        if (!Contains(handle))
+            return false;
+
+        const std::uint32_t idx = _indices[handle.slot];
+        const std::uint32_t last = _curves.size() - 1;
+        if (idx != last) {
+            _curves[idx] = std::move(_curves[last]);
+            _owners[idx] = _owners[last];
+            _indices[_owners[idx]] = idx;
+        }
+        _curves.pop_back();
+        _owners.pop_back();
+
+        _indices[handle.slot] = kNoIndex;
+        ++_generations[handle.slot];
+        _free.push_back(handle.slot);
+        return true;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Tells if a handle names a curve of the store
+    //-----------------------------------------------------------------------------------
+    bool SegmentStore::Contains(Handle handle) const {
+        return handle.slot < _indices.size() && _generations[handle.slot] == handle.generation &&
+               _indices[handle.slot] != kNoIndex;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the curve of a handle
+    //!
+    //! \return the curve, nullptr if the handle names no curve
+    //-----------------------------------------------------------------------------------
+    BezierCurve *SegmentStore::Find(Handle handle) {
+        return Contains(handle) ? &_curves[_indices[handle.slot]] : nullptr;
+    }
+
+    const BezierCurve *SegmentStore::Find(Handle handle) const {
+        return Contains(handle) ? &_curves[_indices[handle.slot]] : nullptr;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the curve of a handle that must name a curve of the store
+    //-----------------------------------------------------------------------------------
+    BezierCurve &SegmentStore::Get(Handle handle) {
+        assert(Contains(handle));
+        return _curves[_indices[handle.slot]];
+    }
+
+    const BezierCurve &SegmentStore::Get(Handle handle) const {
+        assert(Contains(handle));
+        return _curves[_indices[handle.slot]];
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the dense index of a curve, kNoIndex if the handle names no curve
+    //-----------------------------------------------------------------------------------
+    unsigned SegmentStore::GetIndex(Handle handle) const {
+        return Contains(handle) ? _indices[handle.slot] : kNoIndex;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the handle of the curve at a dense index
+    //-----------------------------------------------------------------------------------
+    SegmentStore::Handle SegmentStore::GetHandle(unsigned idx) const {
+        assert(idx < _owners.size());
+        const std::uint32_t slot = _owners[idx];
+        return Handle {slot, _generations[slot]};
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Names the curve just appended with a free slot, or a new one
+    //-----------------------------------------------------------------------------------
+    SegmentStore::Handle SegmentStore::Link() {
+        std::uint32_t slot;
+        if (_free.empty()) {
+            slot = _indices.size();
+            _indices.push_back(kNoIndex);
+            _generations.push_back(0);
+        } else {
+            slot = _free.back();
+            _free.pop_back();
+        }
+        _indices[slot] = _curves.size() - 1;
+        _owners.push_back(slot);
+        return Handle {slot, _generations[slot]};
+    }
+
+}
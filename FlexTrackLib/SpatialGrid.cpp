@@ -0,0 +1,183 @@
+#include "SpatialGrid.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "Stats.h"
+
+namespace ByteTrail {
+
+    constexpr double SpatialGrid::kDefaultCellSize;
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Creates an empty grid
+    //!
+    //! \param cell_size the width and height of a grid cell, ideally about the size of
+    //!        the entries and of typical query areas
+    //-----------------------------------------------------------------------------------
+    SpatialGrid::SpatialGrid(double cell_size) :
+            _cell_size(cell_size),
+            _size(0),
+            _query(0) {
+        assert(cell_size > 0.0);
+    }
+
+    SpatialGrid::~SpatialGrid() {
+    }
+
+    double SpatialGrid::GetCellSize() const {
+        return _cell_size;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the number of entries in the grid
+    //-----------------------------------------------------------------------------------
+    unsigned SpatialGrid::GetSize() const {
+        return _size;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Removes every entry
+    //-----------------------------------------------------------------------------------
+    void SpatialGrid::Clear() {
+        _entries.clear();
+        _cells.clear();
+        _stamps.clear();
+        _size = 0;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Adds an entry or moves an existing one
+    //!
+    //! An entry that stays within the same cells only has its bounds replaced.
+    //!
+    //! \param id the id of the entry
+    //! \param bounds the box of the entry
+    //-----------------------------------------------------------------------------------
+    void SpatialGrid::Insert(unsigned id, const Rect & bounds) {
+        if (id >= _entries.size()) {
+            _entries.resize(id + 1, Entry{Rect{0, 0, 0, 0}, 0, 0, 0, 0, false});
+            _stamps.resize(id + 1, 0);
+        }
+
+        Entry updated{bounds,
+                      GetCell(bounds.x), GetCell(bounds.y),
+                      GetCell(bounds.x + bounds.width), GetCell(bounds.y + bounds.height),
+                      true};
+        Entry & entry = _entries[id];
+        if (entry.used) {
+            if (entry.min_x == updated.min_x && entry.min_y == updated.min_y &&
+                entry.max_x == updated.max_x && entry.max_y == updated.max_y) {
+                entry.bounds = bounds;
+                return;
+            }
+            Unlink(id, entry);
+        } else {
+            ++_size;
+        }
+        entry = updated;
+        Link(id, entry);
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Removes an entry, ids that are not in the grid are ignored
+    //-----------------------------------------------------------------------------------
+    void SpatialGrid::Remove(unsigned id) {
+        if (Contains(id)) {
+            Unlink(id, _entries[id]);
+            _entries[id].used = false;
+            --_size;
+        }
+    }
+
+    bool SpatialGrid::Contains(unsigned id) const {
+        return id < _entries.size() && _entries[id].used;
+    }
+
+    const Rect & SpatialGrid::GetBounds(unsigned id) const {
+        assert(Contains(id));
+        return _entries[id].bounds;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Finds the entries whose bounds overlap an area
+    //!
+    //! \param area the area to search
+    //! \param ids receives the ids of the overlapping entries, each once, appended in
+    //!        no particular order
+    //-----------------------------------------------------------------------------------
+    void SpatialGrid::Query(const Rect & area, std::vector<unsigned> & ids) const {
+        if (++_query == 0) {
+            std::fill(_stamps.begin(), _stamps.end(), 0);
+            _query = 1;
+        }
+
+        int min_x = GetCell(area.x);
+        int min_y = GetCell(area.y);
+        int max_x = GetCell(area.x + area.width);
+        int max_y = GetCell(area.y + area.height);
+        Stats::GetInstance().Add(STAT_GRID_CELLS_VISITED, static_cast<std::uint64_t>(max_x - min_x + 1) *
+                                                          static_cast<std::uint64_t>(max_y - min_y + 1));
+        for (int y = min_y; y <= max_y; y++) {
+            for (int x = min_x; x <= max_x; x++) {
+                auto cell = _cells.find(GetKey(x, y));
+                if (cell == _cells.end())
+                    continue;
+                for (unsigned id : cell->second) {
+                    if (_stamps[id] != _query && _entries[id].bounds.Intersects(area)) {
+                        _stamps[id] = _query;
+                        ids.push_back(id);
+                    }
+                }
+            }
+        }
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Finds the entries whose bounds contain a point
+    //-----------------------------------------------------------------------------------
+    void SpatialGrid::Query(double x, double y, std::vector<unsigned> & ids) const {
+        Stats::GetInstance().Add(STAT_GRID_CELLS_VISITED, 1);
+        auto cell = _cells.find(GetKey(GetCell(x), GetCell(y)));
+        if (cell == _cells.end())
+            return;
+        for (unsigned id : cell->second) {
+            if (_entries[id].bounds.Contains(x, y))
+                ids.push_back(id);
+        }
+    }
+
+    int SpatialGrid::GetCell(double coordinate) const {
+        return static_cast<int>(std::floor(coordinate / _cell_size));
+    }
+
+    std::uint64_t SpatialGrid::GetKey(int x, int y) {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32) |
+               static_cast<std::uint32_t>(y);
+    }
+
+    void SpatialGrid::Link(unsigned id, const Entry & entry) {
+        for (int y = entry.min_y; y <= entry.max_y; y++) {
+            for (int x = entry.min_x; x <= entry.max_x; x++) {
+                _cells[GetKey(x, y)].push_back(id);
+            }
+        }
+    }
+
+    void SpatialGrid::Unlink(unsigned id, const Entry & entry) {
+        for (int y = entry.min_y; y <= entry.max_y; y++) {
+            for (int x = entry.min_x; x <= entry.max_x; x++) {
+                auto cell = _cells.find(GetKey(x, y));
+                assert(cell != _cells.end());
+                std::vector<unsigned> & ids = cell->second;
+                auto itr = std::find(ids.begin(), ids.end(), id);
+                assert(itr != ids.end());
+                // empty cells are kept so entries moving back do not allocate
+                *itr = ids.back();
+                ids.pop_back();
+            }
+        }
+    }
+
+}
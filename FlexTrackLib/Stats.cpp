@@ -0,0 +1,99 @@
+#include "Stats.h"
+
+namespace ByteTrail {
+
+    static const char * kCounterNames[STAT_COUNTER_COUNT] = {
+        "curves_recalculated",
+        "points_emitted",
+        "strokes_issued",
+        "ties_generated",
+        "clearance_pairs_checked",
+        "grid_cells_visited"
+    };
+
+    static const char * kTimerNames[STAT_TIMER_COUNT] = {
+        "recalculate_curve",
+        "recalculate_parallels",
+        "get_ties",
+        "draw"
+    };
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Writes the column names matching WriteCsv()
+    //-----------------------------------------------------------------------------------
+    void FrameStats::WriteCsvHeader(std::ostream & out) {
+        out << "frame";
+        for (unsigned i = 0; i < STAT_TIMER_COUNT; i++) {
+            out << ',' << kTimerNames[i] << "_ms," << kTimerNames[i] << "_calls";
+        }
+        for (unsigned i = 0; i < STAT_COUNTER_COUNT; i++) {
+            out << ',' << kCounterNames[i];
+        }
+        out << '\n';
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Writes the statistics as one comma separated line
+    //-----------------------------------------------------------------------------------
+    void FrameStats::WriteCsv(std::ostream & out) const {
+        out << frame;
+        for (unsigned i = 0; i < STAT_TIMER_COUNT; i++) {
+            out << ',' << time[i] << ',' << calls[i];
+        }
+        for (unsigned i = 0; i < STAT_COUNTER_COUNT; i++) {
+            out << ',' << counters[i];
+        }
+        out << '\n';
+    }
+
+    Stats::Stats() :
+            _enabled(false),
+            _frame(0) {
+        for (unsigned i = 0; i < STAT_COUNTER_COUNT; i++) {
+            _counters[i].store(0, std::memory_order_relaxed);
+        }
+        for (unsigned i = 0; i < STAT_TIMER_COUNT; i++) {
+            _time[i].store(0, std::memory_order_relaxed);
+            _calls[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the statistics the library reports into
+    //-----------------------------------------------------------------------------------
+    Stats & Stats::GetInstance() {
+        static Stats instance;
+        return instance;
+    }
+
+    const char * Stats::GetName(StatCounter counter) {
+        return kCounterNames[counter];
+    }
+
+    const char * Stats::GetName(StatTimer timer) {
+        return kTimerNames[timer];
+    }
+
+    void Stats::SetEnabled(bool enabled) {
+        _enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Collects the statistics of the frame that just ended
+    //!
+    //! Every counter and timer is reset for the next frame.
+    //!
+    //! \param stats receives the statistics of the frame
+    //-----------------------------------------------------------------------------------
+    void Stats::EndFrame(FrameStats & stats) {
+        stats.frame = _frame.fetch_add(1, std::memory_order_relaxed);
+        for (unsigned i = 0; i < STAT_TIMER_COUNT; i++) {
+            stats.time[i] = _time[i].exchange(0, std::memory_order_relaxed) / 1.0e6;
+            stats.calls[i] = _calls[i].exchange(0, std::memory_order_relaxed);
+        }
+        for (unsigned i = 0; i < STAT_COUNTER_COUNT; i++) {
+            stats.counters[i] = _counters[i].exchange(0, std::memory_order_relaxed);
+        }
+    }
+
+}
@@ -0,0 +1,179 @@
+#include "TaskPool.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace ByteTrail {
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Starts the worker threads
+    //!
+    //! \param workers the number of threads started besides the caller of
+    //!        ParallelFor(). With 0 workers every loop runs on the calling thread.
+    //-----------------------------------------------------------------------------------
+    TaskPool::TaskPool(unsigned workers) :
+            _generation(0),
+            _stop(false),
+            _task(nullptr),
+            _remaining(0),
+            _active(0) {
+        // one queue per worker and one for the calling thread
+        for (unsigned i = 0; i <= workers; i++) {
+            _queues.push_back(std::unique_ptr<Queue>(new Queue()));
+        }
+        for (unsigned i = 0; i < workers; i++) {
+            _workers.push_back(std::thread(&TaskPool::Run, this, i));
+        }
+    }
+
+    TaskPool::~TaskPool() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _wake.notify_all();
+        for (auto &worker : _workers) {
+            worker.join();
+        }
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the number of workers that leaves one core to the calling thread
+    //-----------------------------------------------------------------------------------
+    unsigned TaskPool::GetDefaultWorkers() {
+        unsigned cores = std::thread::hardware_concurrency();
+        return cores > 1 ? cores - 1 : 0;
+    }
+
+    unsigned TaskPool::GetWorkerCount() const {
+        return static_cast<unsigned>(_workers.size());
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the number of threads running a loop, the workers and the caller
+    //-----------------------------------------------------------------------------------
+    unsigned TaskPool::GetThreadCount() const {
+        return static_cast<unsigned>(_queues.size());
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Runs a task over a range, in parallel and in chunks
+    //!
+    //! \param count the size of the range [0, count)
+    //! \param grain the largest number of items in a chunk
+    //! \param task called once per chunk, possibly on several threads at once
+    //-----------------------------------------------------------------------------------
+    void TaskPool::ParallelFor(std::size_t count, std::size_t grain, const RangeTask &task) {
+        assert(grain > 0);
+        if (count == 0)
+            return;
+
+        const unsigned caller = GetThreadCount() - 1;
+        if (_workers.empty() || count <= grain) {
+            task(0, count, caller);
+            return;
+        }
+
+        // a worker still leaving the previous loop may pick up a chunk as soon as
+        // it is queued, so the task and count are published first
+        const std::size_t chunks = (count + grain - 1) / grain;
+        _task.store(&task, std::memory_order_release);
+        _remaining.store(chunks, std::memory_order_release);
+        for (std::size_t i = 0; i < chunks; i++) {
+            Queue &queue = *_queues[i % _queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.chunks.push_back(Chunk{i * grain, std::min(count, (i + 1) * grain)});
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            ++_generation;
+        }
+        _wake.notify_all();
+
+        while (RunChunk(caller)) {
+        }
+
+        // wait for chunks still running on the workers, and for the workers to leave
+        // the loop so the task is not referenced after returning
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done.wait(lock, [this]() {
+            return _remaining.load(std::memory_order_acquire) == 0 &&
+                   _active.load(std::memory_order_acquire) == 0;
+        });
+        _task.store(nullptr, std::memory_order_relaxed);
+    }
+
+    void TaskPool::Run(unsigned worker) {
+        unsigned long generation = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wake.wait(lock, [this, generation]() { return _stop || _generation != generation; });
+                if (_stop)
+                    return;
+                generation = _generation;
+                _active.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            while (RunChunk(worker)) {
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _active.fetch_sub(1, std::memory_order_release);
+            }
+            _done.notify_all();
+        }
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Runs one chunk from the thread's own queue or stolen from another
+    //!
+    //! \return false once no chunks are left to take
+    //-----------------------------------------------------------------------------------
+    bool TaskPool::RunChunk(unsigned thread) {
+        Chunk chunk;
+        if (!Pop(thread, chunk) && !Steal(thread, chunk))
+            return false;
+
+        (*_task.load(std::memory_order_acquire))(chunk.begin, chunk.end, thread);
+        if (_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _done.notify_all();
+        }
+        return true;
+    }
+
+    bool TaskPool::Pop(unsigned queue, Chunk &chunk) {
+        Queue &own = *_queues[queue];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.head == own.chunks.size())
+            return false;
+        chunk = own.chunks.back();
+        own.chunks.pop_back();
+        if (own.head == own.chunks.size()) {
+            own.chunks.clear();
+            own.head = 0;
+        }
+        return true;
+    }
+
+    bool TaskPool::Steal(unsigned thread, Chunk &chunk) {
+        const unsigned queues = GetThreadCount();
+        for (unsigned i = 1; i < queues; i++) {
+            Queue &victim = *_queues[(thread + i) % queues];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.head != victim.chunks.size()) {
+                chunk = victim.chunks[victim.head++];
+                if (victim.head == victim.chunks.size()) {
+                    victim.chunks.clear();
+                    victim.head = 0;
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+}
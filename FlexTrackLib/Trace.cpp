@@ -0,0 +1,121 @@
+#include "Trace.h"
+
+#include <chrono>
+
+namespace ByteTrail {
+
+    constexpr std::size_t TraceBuffer::kCapacity;
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Creates an empty buffer with every category enabled
+    //!
+    //! Each slot carries a sequence number telling whether it is free for the writer
+    //! of a given position or holds an event for the reader, so writers only contend
+    //! on the write position.
+    //-----------------------------------------------------------------------------------
+    TraceBuffer::TraceBuffer() :
+            _enabled((1U << TRACE_CATEGORY_COUNT) - 1),
+            _dropped(0),
+            _write(0),
+            _read(0),
+            _slots(kCapacity) {
+        for (std::size_t i = 0; i < kCapacity; i++) {
+            _slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    TraceBuffer::~TraceBuffer() {
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the buffer the FT_TRACE macros record into
+    //-----------------------------------------------------------------------------------
+    TraceBuffer & TraceBuffer::GetInstance() {
+        static TraceBuffer instance;
+        return instance;
+    }
+
+    bool TraceBuffer::IsEnabled(TraceCategory category) const {
+        return (_enabled.load(std::memory_order_relaxed) & (1U << category)) != 0;
+    }
+
+    void TraceBuffer::SetEnabled(TraceCategory category, bool enabled) {
+        if (enabled)
+            _enabled.fetch_or(1U << category, std::memory_order_relaxed);
+        else
+            _enabled.fetch_and(~(1U << category), std::memory_order_relaxed);
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Records an event
+    //!
+    //! \param category the category of the trace point
+    //! \param name a string literal naming the trace point
+    //! \param a the first value recorded with the event
+    //! \param b the second value recorded with the event
+    //! \return false if the category is disabled or the buffer is full
+    //-----------------------------------------------------------------------------------
+    bool TraceBuffer::Record(TraceCategory category, const char * name, double a, double b) {
+        if (!IsEnabled(category))
+            return false;
+
+        std::size_t position = _write.load(std::memory_order_relaxed);
+        Slot * slot;
+        for (;;) {
+            slot = &_slots[position & (kCapacity - 1)];
+            std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence - position);
+            if (difference == 0) {
+                if (_write.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    break;
+            } else if (difference < 0) {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                position = _write.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->event.timestamp = static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch()).count());
+        slot->event.category = category;
+        slot->event.name = name;
+        slot->event.values[0] = a;
+        slot->event.values[1] = b;
+        slot->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Moves the recorded events out of the buffer
+    //!
+    //! Only one thread may drain at a time.
+    //!
+    //! \param events receives the events in the order they were recorded
+    //! \return the number of events appended
+    //-----------------------------------------------------------------------------------
+    std::size_t TraceBuffer::Drain(std::vector<TraceEvent> & events) {
+        std::size_t count = 0;
+        std::size_t position = _read.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot & slot = _slots[position & (kCapacity - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != position + 1)
+                break;
+            events.push_back(slot.event);
+            slot.sequence.store(position + kCapacity, std::memory_order_release);
+            ++position;
+            ++count;
+        }
+        _read.store(position, std::memory_order_relaxed);
+        return count;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the number of events dropped because the buffer was full
+    //-----------------------------------------------------------------------------------
+    std::uint64_t TraceBuffer::GetDropped() const {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+}
@@ -0,0 +1,281 @@
+#include "TrackGraph.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace ByteTrail {
+
+    constexpr unsigned TrackGraph::kNoLink;
+    constexpr double TrackGraph::kEpsilon;
+
+    TrackGraph::TrackGraph() :
+            _stamp(0) {
+    }
+
+    TrackGraph::~TrackGraph() {
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Adds a flexible segment with both ends open
+    //!
+    //! \return the index of the segment
+    //-----------------------------------------------------------------------------------
+    unsigned TrackGraph::AddSegment(const std::shared_ptr<BezierCurve> &curve) {
+        _curves.push_back(curve);
+        _fixed.push_back(false);
+        _links.push_back(kNoLink);
+        _links.push_back(kNoLink);
+        _connectors.resize(_links.size());
+        _touch_stamps.push_back(0);
+        return _curves.size() - 1;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Removes the last segment and its joints
+    //-----------------------------------------------------------------------------------
+    void TrackGraph::PopSegment() {
+        assert(!_curves.empty());
+        const unsigned segment = _curves.size() - 1;
+        Disconnect(segment, END_START);
+        Disconnect(segment, END_FINISH);
+        _curves.pop_back();
+        _fixed.pop_back();
+        _links.resize(_links.size() - 2);
+        _connectors.resize(_links.size());
+        _touch_stamps.pop_back();
+    }
+
+    unsigned TrackGraph::GetSegmentCount() const {
+        return _curves.size();
+    }
+
+    const std::shared_ptr<BezierCurve> &TrackGraph::GetCurve(unsigned segment) const {
+        return _curves[segment];
+    }
+
+    bool TrackGraph::IsFixed(unsigned segment) const {
+        return _fixed[segment] != 0;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Sets whether a segment keeps its shape, like sectional track
+    //-----------------------------------------------------------------------------------
+    void TrackGraph::SetFixed(unsigned segment, bool fixed) {
+        _fixed[segment] = fixed;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Joins the ends of two segments
+    //!
+    //! The constraints are not enforced until a control point next to the joint is
+    //! moved.
+    //!
+    //! \return false if either end is joined already or both are the same end
+    //-----------------------------------------------------------------------------------
+    bool TrackGraph::Connect(unsigned segment, End end, unsigned other, End other_end) {
+        const unsigned slot = GetSlot(segment, end);
+        const unsigned other_slot = GetSlot(other, other_end);
+        if (slot == other_slot || _links[slot] != kNoLink || _links[other_slot] != kNoLink)
+            return false;
+        _links[slot] = other_slot;
+        _links[other_slot] = slot;
+        return true;
+    }
+
+    void TrackGraph::Disconnect(unsigned segment, End end) {
+        const unsigned slot = GetSlot(segment, end);
+        if (_links[slot] != kNoLink) {
+            _links[_links[slot]] = kNoLink;
+            _links[slot] = kNoLink;
+        }
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the end joined to an end
+    //!
+    //! \return false if the end is open
+    //-----------------------------------------------------------------------------------
+    bool TrackGraph::GetNeighbor(unsigned segment, End end, unsigned &other, End &other_end) const {
+        const unsigned link = _links[GetSlot(segment, end)];
+        if (link == kNoLink)
+            return false;
+        other = link / 2;
+        other_end = static_cast<End>(link % 2);
+        return true;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the location of an end and the angle the track leaves it in
+    //-----------------------------------------------------------------------------------
+    const Connector &TrackGraph::GetConnector(unsigned segment, End end) {
+        const unsigned slot = GetSlot(segment, end);
+        const BezierCurve &curve = *_curves[segment];
+        const Point &location = curve.GetControlPoint(GetEndPoint(slot));
+        const Point &handle = curve.GetControlPoint(GetHandle(slot));
+        Connector &connector = _connectors[slot];
+        connector.SetLocation(location);
+        connector.SetAngle(std::atan2(location.y - handle.y, location.x - handle.x));
+        return connector;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Moves a control point and restores the joints it affects
+    //!
+    //! Moving an end point drags the handle next to it along, so the tangent at the
+    //! end is kept. A handle next to a fixed segment is kept on the tangent of that
+    //! segment. Fixed segments ignore edits of single control points and move as a
+    //! whole when an end point is dragged.
+    //!
+    //! \param segment the segment of the control point
+    //! \param index the control point, 0 to 3
+    //! \param point the new location
+    //-----------------------------------------------------------------------------------
+    void TrackGraph::MoveControlPoint(unsigned segment, unsigned index, const Point &point) {
+        assert(index < 4);
+        _touched.clear();
+        _worklist.clear();
+        ++_stamp;
+
+        BezierCurve &curve = *_curves[segment];
+        if (index == 0 || index == 3) {
+            const unsigned slot = GetSlot(segment, index == 0 ? END_START : END_FINISH);
+            const Point &end_point = curve.GetControlPoint(index);
+            const double dx = point.x - end_point.x;
+            const double dy = point.y - end_point.y;
+            TouchSegment(segment);
+            if (IsFixed(segment)) {
+                curve.Move(dx, dy);
+                _worklist.push_back(slot ^ 1);
+            } else {
+                curve.SetControlPoint(point, index);
+                if (_links[slot] != kNoLink) {
+                    const Point &handle = curve.GetControlPoint(GetHandle(slot));
+                    curve.SetControlPoint(handle.x + dx, handle.y + dy, GetHandle(slot));
+                }
+            }
+            _worklist.push_back(slot);
+        } else {
+            if (IsFixed(segment))
+                return;
+            const unsigned slot = GetSlot(segment, index == 1 ? END_START : END_FINISH);
+            Point target = point;
+            const unsigned link = _links[slot];
+            if (link != kNoLink && IsFixed(link / 2)) {
+                // project onto the line the fixed neighbor leaves the joint along
+                const BezierCurve &fixed = *_curves[link / 2];
+                const Point &joint = fixed.GetControlPoint(GetEndPoint(link));
+                const Point &fixed_handle = fixed.GetControlPoint(GetHandle(link));
+                const double tx = joint.x - fixed_handle.x;
+                const double ty = joint.y - fixed_handle.y;
+                const double length = tx * tx + ty * ty;
+                if (length > 0.0) {
+                    const double s = std::max(0.0, ((point.x - joint.x) * tx + (point.y - joint.y) * ty) / length);
+                    target = Point(joint.x + s * tx, joint.y + s * ty);
+                }
+            }
+            TouchSegment(segment);
+            curve.SetControlPoint(target, index);
+            _worklist.push_back(slot);
+        }
+        Propagate();
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the segments changed by the last MoveControlPoint()
+    //-----------------------------------------------------------------------------------
+    const std::vector<TrackGraph::Touch> &TrackGraph::GetTouched() const {
+        return _touched;
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Recalculates the curves changed by the last edit together in a batch
+    //!
+    //! A drag usually touches only the two segments at a joint, which the batch leaves
+    //! to the curves themselves as being too few to fill a register.
+    //-----------------------------------------------------------------------------------
+    void TrackGraph::Recalculate(BezierBatch &batch) {
+        _touched_curves.clear();
+        for (const Touch &touch : _touched)
+            _touched_curves.push_back(_curves[touch.segment]);
+        batch.Recalculate(_touched_curves);
+    }
+
+    void TrackGraph::TouchSegment(unsigned segment) {
+        if (_touch_stamps[segment] != _stamp) {
+            _touch_stamps[segment] = _stamp;
+            const BezierCurve &curve = *_curves[segment];
+            Touch touch;
+            touch.segment = segment;
+            touch.bounds = curve.GetBounds();
+            for (unsigned i = 0; i < 4; i++)
+                touch.points[i] = curve.GetControlPoint(i);
+            _touched.push_back(touch);
+        }
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Restores the joints of the end slots on the worklist
+    //!
+    //! A fixed segment is moved at most once per edit, so a loop of fixed track
+    //! cannot cycle; whatever is left is absorbed by the flexible segments.
+    //-----------------------------------------------------------------------------------
+    void TrackGraph::Propagate() {
+        while (!_worklist.empty()) {
+            const unsigned slot = _worklist.back();
+            _worklist.pop_back();
+            const unsigned link = _links[slot];
+            if (link != kNoLink)
+                RestoreJoint(slot, link);
+        }
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Makes one end of a joint match the other
+    //!
+    //! \param from the end slot that changed
+    //! \param to the end slot joined to it, adjusted to match
+    //-----------------------------------------------------------------------------------
+    void TrackGraph::RestoreJoint(unsigned from, unsigned to) {
+        const BezierCurve &source = *_curves[from / 2];
+        const Point joint = source.GetControlPoint(GetEndPoint(from));
+        const Point handle = source.GetControlPoint(GetHandle(from));
+
+        const unsigned segment = to / 2;
+        BezierCurve &target = *_curves[segment];
+        const Point &end_point = target.GetControlPoint(GetEndPoint(to));
+        const double dx = joint.x - end_point.x;
+        const double dy = joint.y - end_point.y;
+        const bool moved = std::abs(dx) > kEpsilon || std::abs(dy) > kEpsilon;
+
+        if (IsFixed(segment)) {
+            if (moved && _touch_stamps[segment] != _stamp) {
+                TouchSegment(segment);
+                target.Move(dx, dy);
+                _worklist.push_back(to ^ 1);
+            }
+            return;
+        }
+
+        // the handle follows the joint, then turns to continue the tangent of the
+        // source with its own length
+        Point target_handle = target.GetControlPoint(GetHandle(to));
+        target_handle.x += dx;
+        target_handle.y += dy;
+        const double tx = joint.x - handle.x;
+        const double ty = joint.y - handle.y;
+        const double tangent = std::sqrt(tx * tx + ty * ty);
+        if (tangent > 0.0) {
+            const double length = joint.Distance(target_handle);
+            target_handle = Point(joint.x + tx / tangent * length, joint.y + ty / tangent * length);
+        }
+
+        const Point &current_handle = target.GetControlPoint(GetHandle(to));
+        if (moved || current_handle.Distance(target_handle) > kEpsilon) {
+            TouchSegment(segment);
+            target.SetControlPoint(joint, GetEndPoint(to));
+            target.SetControlPoint(target_handle, GetHandle(to));
+        }
+    }
+
+}
@@ -0,0 +1,142 @@
+#ifndef BYTETRAIL_BEZIERBATCH_H
+#define BYTETRAIL_BEZIERBATCH_H
+
+#include <memory>
+#include <vector>
+
+#include "BezierCurve.h"
+#include "Geometry.h"
+#include "SegmentStore.h"
+
+namespace ByteTrail {
+
+    //! \brief Vector kernels available to the batch evaluator
+    enum BatchKernel {
+        KERNEL_SCALAR,
+        KERNEL_SSE2,
+        KERNEL_AVX,
+        KERNEL_NEON
+    };
+
+    //! \brief Buffers a batch kernel writes the samples of one curve to
+    struct BatchLane {
+        Point *points;
+        Point *tangents;
+        Point *normals;
+        Point *left_rail;
+        Point *right_rail;
+        double *arc_lengths;
+        //! set by the kernel when a tangent of the curve vanishes
+        bool degenerate;
+    };
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Evaluates many cubic bezier curves at once
+    //!
+    //! Control points of the curves added to the batch are stored as structure of
+    //! arrays so that one vector lane holds one curve. Every curve in a batch shares
+    //! the same sample grid, so the Bernstein weights for a sample are broadcast and
+    //! the points, tangents and rail parallels of several curves are produced by a
+    //! single vector operation. The kernel is selected at runtime from the
+    //! instruction sets supported by the processor with a scalar fallback.
+    //!
+    //! Results are stored curve major, the samples of each curve contiguous, so
+    //! Store() copies them back sequentially. Recalculate() has the kernels write
+    //! straight into the buffers of the curves instead, arc lengths included, so
+    //! nothing is copied or recalculated per sample afterwards.
+    //-----------------------------------------------------------------------------------
+    class BezierBatch {
+    public:
+        BezierBatch();
+        virtual ~BezierBatch();
+
+        static BatchKernel DetectKernel();
+        static bool IsKernelSupported(BatchKernel kernel);
+
+        BatchKernel GetKernel() const;
+        void SetKernel(BatchKernel kernel);
+
+        float GetResolution() const;
+        void SetResolution(float resolution);
+
+        double GetParallelsDistance() const;
+        void SetParallelsDistance(double distance);
+
+        void Clear();
+        unsigned Add(const BezierCurve & curve);
+        unsigned GetSize() const;
+        unsigned GetSamples() const;
+        unsigned GetStride() const;
+
+        void Evaluate();
+
+        Point GetPoint(unsigned curve, unsigned sample) const;
+        Point GetTangent(unsigned curve, unsigned sample) const;
+        Point GetNormal(unsigned curve, unsigned sample) const;
+        Point GetLeftRail(unsigned curve, unsigned sample) const;
+        Point GetRightRail(unsigned curve, unsigned sample) const;
+
+        void Store(unsigned curve, BezierCurve & target) const;
+
+        void Recalculate(std::vector<std::shared_ptr<BezierCurve>> & curves);
+        void Recalculate(SegmentStore & curves);
+
+    protected:
+        //! number of doubles in the widest supported vector register
+        static constexpr unsigned kLaneWidth = 4;
+        //! batches smaller than this are left to BezierCurve's own engine, as a partly
+        //! filled register costs more than the padding lanes save
+        static constexpr unsigned kMinimumBatch = kLaneWidth;
+        //! larger groups are split so the results of a batch stay in cache
+        static constexpr unsigned kMaximumBatch = 64;
+
+    private:
+        void ResizeResults();
+        void RecalculateWeights();
+        void PadLanes();
+        void EvaluateLanes();
+        void RecalculateLimitNormals();
+        void Target(unsigned curve, BezierCurve & target);
+        void Finish(BezierCurve & target) const;
+        void Collect(BezierCurve & curve);
+        void RecalculatePending();
+
+        BatchKernel _kernel;
+        float _resolution;
+        double _parallels_distance;
+        unsigned _size;
+        unsigned _stride;
+        unsigned _samples;
+
+        // structure of arrays control points, one array per coordinate
+        std::vector<double> _control_x[4];
+        std::vector<double> _control_y[4];
+
+        // Bernstein weights for the position and the derivative, per sample
+        std::vector<double> _weights;
+
+        // curve major results of Evaluate()
+        std::vector<Point> _points;
+        std::vector<Point> _tangents;
+        std::vector<Point> _normals;
+        std::vector<Point> _left_rail;
+        std::vector<Point> _right_rail;
+        std::vector<double> _arc_lengths;
+
+        // parameters of the sample grid, shared by every curve
+        std::vector<double> _parameters;
+
+        // where each lane is written, the results above or the curves themselves
+        std::vector<BatchLane> _lanes;
+
+        // written by the lanes that only pad the last register
+        std::vector<Point> _padding;
+        std::vector<double> _padding_lengths;
+
+        // modified curves of the collection being recalculated, grouped in place
+        std::vector<BezierCurve *> _pending;
+    };
+
+}
+
+#endif // BYTETRAIL_BEZIERBATCH_H
@@ -5,18 +5,65 @@
 #include <vector>
 
 #include "Geometry.h"
+#include "NScale.h"
 
 
 namespace ByteTrail {
 
+    //! \brief Strategy used to evaluate the curve over the sample grid
+    enum EvaluationMode {
+        //! incremental forward differencing, position and derivative in one pass
+        EVAL_FORWARD_DIFFERENCE,
+        //! direct evaluation of the Bernstein form with BernsteinBasis, kept as reference
+        EVAL_REFERENCE
+    };
+
+    //! \brief Distribution of the curve samples
+    enum SamplingMode {
+        //! samples spaced uniformly in the curve parameter t
+        SAMPLE_UNIFORM,
+        //! samples spaced uniformly in distance along the curve
+        SAMPLE_ARC_LENGTH,
+        //! recursive subdivision until the polyline is within the tolerance
+        SAMPLE_ADAPTIVE
+    };
+
+    //! \brief Index of the point buffers returned by BezierCurve::GetCurve()
+    enum CurveLine {
+        CURVE_CENTERLINE = 0,
+        CURVE_LEFT_RAIL = 1,
+        CURVE_RIGHT_RAIL = 2
+    };
+
+    class BezierBatch;
+
     class BezierCurve {
     public:
         BezierCurve();
+        BezierCurve(const BezierCurve & other) = default;
+        BezierCurve(BezierCurve && other) = default;
         virtual ~BezierCurve();
 
+        BezierCurve & operator=(const BezierCurve & other) = default;
+        BezierCurve & operator=(BezierCurve && other) = default;
+
         float GetResolution() const;
         void SetResolution(float resolution);
 
+        float GetParallelsDistance() const;
+        void SetParallelsDistance(float distance);
+
+        EvaluationMode GetEvaluationMode() const;
+        void SetEvaluationMode(EvaluationMode mode);
+
+        SamplingMode GetSamplingMode() const;
+        void SetSamplingMode(SamplingMode mode);
+
+        double GetTolerance() const;
+        void SetTolerance(double tolerance);
+
+        unsigned GetPointCount();
+
         const double GetLength();
         void  SetLength(double length);
 
@@ -29,40 +76,119 @@ namespace ByteTrail {
 
         void Move(double cx, double cy);
 
+        const Rect & GetBounds() const;
+        const Rect & GetTightBounds();
+        double GetExactLength();
+        double GetMinimumRadius();
+        double GetClosestParameter(const Point & location);
+        Point GetClosestPoint(const Point & location);
+
+        Point Evaluate(double t) const;
+        Point EvaluateDerivative(double t) const;
+
+        double GetParameterAtDistance(double distance);
+        Point GetPointAtDistance(double distance);
+        Point GetTangentAtDistance(double distance);
+        Point GetNormalAtDistance(double distance);
+
+        bool IsModified() const;
+        void Update();
+        unsigned long GetRevision() const;
+
         const std::vector<Point> & GetCurve(unsigned idx);
+        PointView GetCenterline();
+        PointView GetLeftRail();
+        PointView GetRightRail();
+        PointView GetNormals();
+        void GetOffsetLine(double offset, std::vector<Point> & points);
 
-        const std::vector<Point> & GetTangentPoints() const;
+        const std::vector<Point> & GetTangentPoints();
+        const std::vector<double> & GetParameters();
+        const std::vector<double> & GetArcLengths();
 
-    protected:
+        //! resolution and rail distance of a new curve
         static constexpr float kDefaultResolution = 0.025;
-        static constexpr float kDefaultDistance = 4.5;
+        static constexpr float kDefaultDistance = kTrackGauge / 2.0F;
+
+    protected:
         static constexpr float kDefaultLength = 100.0;
         static constexpr unsigned kControlPoints = 4;
         static constexpr unsigned kDerivativeControlPoints = 3;
+        static constexpr unsigned kArcLengthOversampling = 4;
+        static constexpr unsigned kDistanceRefinements = 3;
+        static constexpr float kDefaultTolerance = 0.25;
+        static constexpr unsigned kMaxSubdivisionDepth = 10;
+        static constexpr unsigned kLengthIntervals = 8;
+        static constexpr unsigned kRadiusRefinements = 24;
+        static constexpr unsigned kClosestRefinements = 4;
+        static constexpr double kNormalTolerance = 1e-3;
 
     private:
+        friend class BezierBatch;
+
         void ResizeCurve();
+        unsigned GetUniformSize() const;
         void RecalculateCurve();
-        std::unique_ptr<std::vector<Point>> RecalculateTangentPoints() const;
-        void RecalculateParallels(
-                const std::unique_ptr<std::vector<Point>> & tangent_points,
-                double distance);
+        void RecalculateBounds();
+        void EvaluateForwardDifference();
+        void EvaluateReference();
+        void RecalculateTangentPoints();
+        void RecalculateNormals();
+        static Point GetLimitNormal(const Point * points, double t);
+        void RecalculateParallels(double distance);
+        void RecalculateUniformParameters();
+        void RecalculateArcLengths();
+        void ResampleByArcLength();
+        void EvaluateParameters();
+        void RecalculateAdaptiveParameters();
+        void SubdivideCurve(const Point * points, double t0, double t1, unsigned depth);
 
 
         float _resolution;
         float _length;
         bool _fixed_length;
         float _parallels_distance;
+        EvaluationMode _evaluation_mode;
+        SamplingMode _sampling_mode;
+        double _curve_length;
+        double _tolerance;
+        unsigned long _revision;
 
         Point _control_points[kControlPoints];
         Point m_derivative_ctrl_pts[kDerivativeControlPoints];
+        // control point hull grown by the rail distance
+        Rect _bounds;
         std::vector<Point> _curve_points;
+        std::vector<Point> _tangent_points;
+        // unit normal to the left of each tangent, shared by the rails, the ties and
+        // any other line offset from the centerline
+        std::vector<Point> _normal_points;
         std::vector<Point> _top_left_points;
         std::vector<Point> _bottom_right_points;
 
+        // curve parameter and cumulative distance of each sample
+        std::vector<double> _parameters;
+        std::vector<double> _arc_lengths;
+        // cumulative length over the oversampled grid used for arc length sampling
+        std::vector<double> _arc_table;
+
+        //! \brief Properties derived on first use, each valid while its revision
+        //!        matches the curve revision
+        struct PropertyCache {
+            unsigned long bounds_revision;
+            Rect bounds;
+            unsigned long length_revision;
+            double length;
+            unsigned long radius_revision;
+            double radius;
+        };
+        static constexpr unsigned long kNoRevision = ~0UL;
+        PropertyCache _properties;
+
         // State fields
         bool _control_point_modified;
         bool _resolution_modified;
+        bool _parallels_modified;
     };
 
 }
@@ -0,0 +1,245 @@
+#ifndef BYTETRAIL_BEZIERCURVET_H
+#define BYTETRAIL_BEZIERCURVET_H
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "NScale.h"
+
+namespace ByteTrail {
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Binomial coefficient n over k, evaluated at compile time when the
+    //!        arguments are constants
+    //-----------------------------------------------------------------------------------
+    constexpr unsigned long Binomial(unsigned n, unsigned k) {
+        return k == 0 || k == n ? 1 : Binomial(n - 1, k - 1) + Binomial(n - 1, k);
+    }
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Point with the coordinate type of a curve
+    //-----------------------------------------------------------------------------------
+    template<typename Scalar>
+    struct PointT {
+        Scalar x;
+        Scalar y;
+    };
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Bernstein form of a Bezier curve of a fixed degree
+    //!
+    //! The sums are expanded by template recursion, so every term, its binomial
+    //! coefficient and the power indices are compile time constants and a kernel
+    //! for each degree is fully unrolled. Works with any point type having x and y
+    //! members.
+    //-----------------------------------------------------------------------------------
+    template<unsigned Degree, unsigned I = Degree>
+    struct BernsteinBasis {
+        //! powers t^0 .. t^Degree
+        template<typename Scalar>
+        static inline void Powers(Scalar t, Scalar * powers) {
+            BernsteinBasis<Degree, I - 1>::Powers(t, powers);
+            powers[I] = powers[I - 1] * t;
+        }
+
+        //! adds the terms 0 .. I of the sum over the control points
+        template<typename Scalar, typename PointType>
+        static inline void Sum(const PointType * points, const Scalar * t_powers,
+                               const Scalar * s_powers, Scalar & x, Scalar & y) {
+            BernsteinBasis<Degree, I - 1>::Sum(points, t_powers, s_powers, x, y);
+            const Scalar weight = static_cast<Scalar>(Binomial(Degree, I)) * t_powers[I] * s_powers[Degree - I];
+            x += weight * points[I].x;
+            y += weight * points[I].y;
+        }
+
+        //! adds the terms 0 .. I of the derivative, the Bernstein sum of degree
+        //! Degree - 1 over the differences of the control points
+        template<typename Scalar, typename PointType>
+        static inline void DerivativeSum(const PointType * points, const Scalar * t_powers,
+                                         const Scalar * s_powers, Scalar & x, Scalar & y) {
+            BernsteinBasis<Degree, I - 1>::DerivativeSum(points, t_powers, s_powers, x, y);
+            const Scalar weight = static_cast<Scalar>(Degree * Binomial(Degree - 1, I)) *
+                                  t_powers[I] * s_powers[Degree - 1 - I];
+            x += weight * (points[I + 1].x - points[I].x);
+            y += weight * (points[I + 1].y - points[I].y);
+        }
+
+        //-------------------------------------------------------------------------------
+        //! \brief Evaluates the curve at a parameter value
+        //-------------------------------------------------------------------------------
+        template<typename Scalar, typename PointType>
+        static inline void Evaluate(const PointType * points, Scalar t, Scalar & x, Scalar & y) {
+            Scalar t_powers[Degree + 1];
+            Scalar s_powers[Degree + 1];
+            BernsteinBasis<Degree>::Powers(t, t_powers);
+            BernsteinBasis<Degree>::Powers(static_cast<Scalar>(1) - t, s_powers);
+            x = 0;
+            y = 0;
+            BernsteinBasis<Degree>::Sum(points, t_powers, s_powers, x, y);
+        }
+
+        //-------------------------------------------------------------------------------
+        //! \brief Evaluates the first derivative of the curve at a parameter value
+        //-------------------------------------------------------------------------------
+        template<typename Scalar, typename PointType>
+        static inline void EvaluateDerivative(const PointType * points, Scalar t, Scalar & x, Scalar & y) {
+            Scalar t_powers[Degree + 1];
+            Scalar s_powers[Degree + 1];
+            BernsteinBasis<Degree>::Powers(t, t_powers);
+            BernsteinBasis<Degree>::Powers(static_cast<Scalar>(1) - t, s_powers);
+            x = 0;
+            y = 0;
+            BernsteinBasis<Degree, Degree - 1>::DerivativeSum(points, t_powers, s_powers, x, y);
+        }
+    };
+
+    template<unsigned Degree>
+    struct BernsteinBasis<Degree, 0> {
+        template<typename Scalar>
+        static inline void Powers(Scalar, Scalar * powers) {
+            powers[0] = 1;
+        }
+
+        template<typename Scalar, typename PointType>
+        static inline void Sum(const PointType * points, const Scalar *,
+                               const Scalar * s_powers, Scalar & x, Scalar & y) {
+            x += s_powers[Degree] * points[0].x;
+            y += s_powers[Degree] * points[0].y;
+        }
+
+        template<typename Scalar, typename PointType>
+        static inline void DerivativeSum(const PointType * points, const Scalar *,
+                                         const Scalar * s_powers, Scalar & x, Scalar & y) {
+            const Scalar weight = static_cast<Scalar>(Degree) * s_powers[Degree - 1];
+            x += weight * (points[1].x - points[0].x);
+            y += weight * (points[1].y - points[0].y);
+        }
+    };
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Bezier curve of any degree with its centerline and rails sampled on a
+    //!        uniform grid
+    //!
+    //! A lightweight counterpart of BezierCurve for straights (degree 1) and simple
+    //! easements (degree 2), or wherever a float instantiation halving the point
+    //! buffers is precise enough. Unlike BezierCurve it recalculates eagerly in
+    //! Tessellate() and keeps no arc length or revision state.
+    //-----------------------------------------------------------------------------------
+    template<unsigned Degree, typename Scalar = double>
+    class BezierCurveT {
+        static_assert(Degree >= 1, "a Bezier curve needs at least two control points");
+
+    public:
+        typedef PointT<Scalar> PointType;
+        typedef BernsteinBasis<Degree> Basis;
+
+        static constexpr unsigned kDegree = Degree;
+        static constexpr unsigned kControlPoints = Degree + 1;
+
+        BezierCurveT() : _parallels_distance(static_cast<Scalar>(kTrackGauge / 2)) {
+            for (unsigned i = 0; i < kControlPoints; i++)
+                _control_points[i] = PointType{0, 0};
+        }
+
+        inline const PointType & GetControlPoint(unsigned index) const {
+            assert(index < kControlPoints);
+            return _control_points[index];
+        }
+
+        inline void SetControlPoint(Scalar x, Scalar y, unsigned index) {
+            assert(index < kControlPoints);
+            _control_points[index] = PointType{x, y};
+        }
+
+        inline Scalar GetParallelsDistance() const { return _parallels_distance; }
+        inline void SetParallelsDistance(Scalar distance) { _parallels_distance = distance; }
+
+        inline PointType Evaluate(Scalar t) const {
+            PointType p;
+            Basis::Evaluate(_control_points, t, p.x, p.y);
+            return p;
+        }
+
+        inline PointType EvaluateDerivative(Scalar t) const {
+            PointType p;
+            Basis::EvaluateDerivative(_control_points, t, p.x, p.y);
+            return p;
+        }
+
+        //-------------------------------------------------------------------------------
+        //! \brief Samples the centerline and the rails
+        //!
+        //! The end points are assigned exactly from the control points. Rails are
+        //! offset along the normal; where the derivative vanishes the chord is used.
+        //!
+        //! \param segments the number of line segments, at least 1
+        //-------------------------------------------------------------------------------
+        void Tessellate(unsigned segments) {
+            assert(segments > 0);
+            _centerline.resize(segments + 1);
+            _left_rail.resize(segments + 1);
+            _right_rail.resize(segments + 1);
+
+            const Scalar step = static_cast<Scalar>(1) / segments;
+            for (unsigned idx = 0; idx <= segments; idx++) {
+                const Scalar t = idx == segments ? static_cast<Scalar>(1) : step * idx;
+                PointType p = idx == 0 ? _control_points[0] :
+                              idx == segments ? _control_points[Degree] : Evaluate(t);
+                PointType d = EvaluateDerivative(t);
+                Scalar length = std::sqrt(d.x * d.x + d.y * d.y);
+                if (length == 0) {
+                    d.x = _control_points[Degree].x - _control_points[0].x;
+                    d.y = _control_points[Degree].y - _control_points[0].y;
+                    length = std::sqrt(d.x * d.x + d.y * d.y);
+                }
+                const Scalar nx = length > 0 ? d.y / length * _parallels_distance : 0;
+                const Scalar ny = length > 0 ? d.x / length * _parallels_distance : 0;
+
+                _centerline[idx] = p;
+                _left_rail[idx] = PointType{p.x + nx, p.y - ny};
+                _right_rail[idx] = PointType{p.x - nx, p.y + ny};
+            }
+        }
+
+        //-------------------------------------------------------------------------------
+        //! \brief Gets the length of the sampled centerline
+        //-------------------------------------------------------------------------------
+        Scalar GetLength() const {
+            Scalar length = 0;
+            for (std::size_t idx = 1; idx < _centerline.size(); idx++) {
+                const Scalar dx = _centerline[idx].x - _centerline[idx - 1].x;
+                const Scalar dy = _centerline[idx].y - _centerline[idx - 1].y;
+                length += std::sqrt(dx * dx + dy * dy);
+            }
+            return length;
+        }
+
+        inline const std::vector<PointType> & GetCenterline() const { return _centerline; }
+        inline const std::vector<PointType> & GetLeftRail() const { return _left_rail; }
+        inline const std::vector<PointType> & GetRightRail() const { return _right_rail; }
+
+    private:
+        PointType _control_points[kControlPoints];
+        Scalar _parallels_distance;
+        std::vector<PointType> _centerline;
+        std::vector<PointType> _left_rail;
+        std::vector<PointType> _right_rail;
+    };
+
+    template<unsigned Degree, typename Scalar>
+    constexpr unsigned BezierCurveT<Degree, Scalar>::kDegree;
+    template<unsigned Degree, typename Scalar>
+    constexpr unsigned BezierCurveT<Degree, Scalar>::kControlPoints;
+
+    //! straight track
+    typedef BezierCurveT<1> LinearBezier;
+    //! simple easement
+    typedef BezierCurveT<2> QuadraticBezier;
+    //! the degree of BezierCurve, without its sampling modes and cached state
+    typedef BezierCurveT<3> CubicBezier;
+
+}
+
+#endif // BYTETRAIL_BEZIERCURVET_H
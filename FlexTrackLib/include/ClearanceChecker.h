@@ -0,0 +1,91 @@
+#ifndef BYTETRAIL_CLEARANCECHECKER_H
+#define BYTETRAIL_CLEARANCECHECKER_H
+
+#include <vector>
+
+#include "BezierCurve.h"
+#include "Geometry.h"
+#include "NScale.h"
+#include "SpatialGrid.h"
+#include "TrackGraph.h"
+
+namespace ByteTrail {
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Finds segments of a layout that cross or run too close to each other
+    //!
+    //! Clearance is measured between centerlines, like the track spacing of the NMRA
+    //! standards, so the rails of two segments closer than the clearance are closer
+    //! than it less the gauge.
+    //!
+    //! The broad phase keeps the control point bounds of every segment, grown by half
+    //! the clearance, in a SpatialGrid; only segments whose boxes overlap are compared.
+    //! The narrow phase splits both curves in halves until the pieces are flat, pruning
+    //! every pair of pieces whose bounds are too far apart to conflict or farther apart
+    //! than the closest pair found so far, and measures the remaining flat pieces as
+    //! line segments. Only control points are read, so curves need not be recalculated
+    //! before being checked.
+    //!
+    //! Results are kept per segment. Updating a segment re-checks it against the
+    //! segments near it only, so a drag re-checks the segments the edit touched.
+    //! Segments joined in the TrackGraph always meet at their joint, so near a shared
+    //! joint they are not compared.
+    //-----------------------------------------------------------------------------------
+    class ClearanceChecker {
+    public:
+        //! \brief Kind of a conflict between two segments
+        enum Kind {
+            CONFLICT_CROSSING,
+            CONFLICT_CLEARANCE
+        };
+
+        //! \brief Closest approach of two segments, first < second
+        struct Conflict {
+            unsigned first;
+            unsigned second;
+            Kind kind;
+            //! between the centerlines, 0 for a crossing
+            double distance;
+            //! the crossing, or halfway between the closest points
+            Point location;
+        };
+
+        explicit ClearanceChecker(double clearance = kDoubleTrackSpacing);
+        virtual ~ClearanceChecker();
+
+        double GetClearance() const;
+        void SetClearance(double clearance);
+
+        void Clear();
+        void Update(const TrackGraph & graph, unsigned segment);
+        void Update(const TrackGraph & graph);
+        void Remove(unsigned segment);
+
+        const std::vector<Conflict> & GetConflicts(unsigned segment) const;
+        void GetConflicts(std::vector<Conflict> & conflicts) const;
+        unsigned GetConflictCount() const;
+
+        static bool Check(const BezierCurve & a, const BezierCurve & b, double clearance,
+                          const std::vector<Point> & joints, Conflict & conflict);
+
+        //! largest distance of the inner control points from the chord of a flat piece
+        static constexpr double kFlatness = 0.05;
+        //! most times a curve is split in halves
+        static constexpr unsigned kMaxDepth = 16;
+
+    private:
+        static Rect GetCheckBounds(const BezierCurve & curve, double clearance);
+        void Unlink(unsigned segment);
+
+        double _clearance;
+        SpatialGrid _index;
+        // per segment, every conflict is listed with both of its segments
+        std::vector<std::vector<Conflict>> _conflicts;
+        unsigned _count;
+        std::vector<unsigned> _hits;
+        std::vector<Point> _joints;
+    };
+
+}
+
+#endif // BYTETRAIL_CLEARANCECHECKER_H
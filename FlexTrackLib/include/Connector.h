@@ -8,6 +8,11 @@ namespace ByteTrail
 {
 
 
+//-----------------------------------------------------------------------------
+//! \brief End of a track segment, where it joins another
+//!
+//! Holds the location of the end and the direction the track leaves in.
+//-----------------------------------------------------------------------------
 class Connector
 {
     public:
@@ -18,6 +23,9 @@ class Connector
         void Connect(std::shared_ptr<Connector> to);
         void Disconnect();
         double GetAngle() const;
+        void SetAngle(double angle);
+        const Point & GetLocation() const;
+        void SetLocation(const Point & location);
 
     protected:
     private:
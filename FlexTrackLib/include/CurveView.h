@@ -1,8 +1,21 @@
 #ifndef CURVEVIEW_H
 #define CURVEVIEW_H
 
+#include <cstdint>
+#include <unordered_map>
+#include <glibmm/dispatcher.h>
 #include <gtkmm/drawingarea.h>
+#include "BezierBatch.h"
 #include "BezierCurve.h"
+#include "ClearanceChecker.h"
+#include "EditJournal.h"
+#include "GeometryWorker.h"
+#include "LayoutRecalculator.h"
+#include "LevelOfDetail.h"
+#include "SpatialGrid.h"
+#include "Stats.h"
+#include "TaskPool.h"
+#include "TrackGraph.h"
 
 #define HEX_MAP_DEFAULT_SECTION         4
 
@@ -11,6 +24,8 @@ namespace ByteTrail
 
 using namespace ByteTrail;
 
+class LayoutGLArea;
+
 enum DragMode
 {
     CENTER_POINT,
@@ -25,33 +40,147 @@ class CurveView : public Gtk::DrawingArea
 
         void AddSegement();
         void RemoveSegment();
+        bool Undo();
+        bool Redo();
         void SetEditMode(bool edit_mode);
+        void SetTessellationTolerance(double pixels);
+        void SetScale(float scale);
+        float GetScale() const;
+        void SetStatsOverlay(bool overlay);
+        void SetBackgroundGeometry(bool background);
+        void SetMotionCoalescing(bool coalesce);
+        void SetGLArea(LayoutGLArea * area);
+        const FrameStats & GetFrameStats() const;
+        sigc::signal<void, const FrameStats &> signal_frame_stats();
 
     protected:
         virtual bool on_draw(const Cairo::RefPtr<Cairo::Context>& cr);
     private:
         float _scale;
         float _resolution;
+        double _tolerance;
         bool _edit_mode;
         bool _dragging;
 
         Point _drag_point;
         bool _drag_mode;
         unsigned _drag_idx;
+        unsigned _active_idx;
+        unsigned _attached_idx;
         unsigned _sections;
         std::shared_ptr<BezierCurve> _active_curve;
         std::shared_ptr<BezierCurve> _attached_active_curve;
+        std::shared_ptr<BezierCurve> _selected_curve;
 
         std::vector<std::shared_ptr<ByteTrail::BezierCurve>> _curves;
-
-        void DrawCurve(const Cairo::RefPtr<Cairo::Context>& cr,
-                         std::shared_ptr<BezierCurve> & curve) const;
+        BezierBatch _batch;
+        // the curves chained end to start, keeps the joints continuous while editing
+        TrackGraph _graph;
+        // crossings and tracks too close, re-checked for the curves an edit touches
+        ClearanceChecker _clearance;
+        std::vector<ClearanceChecker::Conflict> _conflicts;
+        // control points moved by each drag, for undo
+        EditJournal _journal;
+        bool Replay(bool undo);
+
+        // whole layouts, after a load or a scale change, are spread over the pool.
+        // It joins before returning, so drawing reads the curves without locks
+        TaskPool _pool;
+        LayoutRecalculator _recalculator;
+
+        // with background geometry the curves above only carry the control points
+        // and settings. Edits are posted to the worker and everything drawn comes
+        // from the snapshot it last published. The worker is declared after the
+        // dispatcher it emits so it stops first
+        Glib::Dispatcher _snapshot_published;
+        std::unique_ptr<GeometryWorker> _worker;
+        std::shared_ptr<const GeometryWorker::Snapshot> _snapshot;
+
+        void OnSnapshotPublished();
+        void PostCurve(size_t idx);
+        const std::vector<std::shared_ptr<BezierCurve>> & GetDrawnCurves() const;
+
+        // curve bounds and control handles indexed by curve index, handles as
+        // curve index * 4 + control point index
+        SpatialGrid _curve_index;
+        SpatialGrid _handle_index;
+        std::vector<unsigned> _hits;
+
+        //! rails and ties of a curve recorded as cairo paths at a curve revision,
+        //! scale and level of detail
+        struct RailPath
+        {
+            const BezierCurve * curve;
+            unsigned long revision;
+            float scale;
+            DetailLevel detail;
+            std::unique_ptr<Cairo::Path> path;
+            std::unique_ptr<Cairo::Path> ties;
+        };
+        std::vector<RailPath> _rail_paths;
+        // builds the geometry of the detail chosen for each curve per frame
+        LevelOfDetail _detail;
+
+        //! offscreen rendering of the static curves over one square of the widget
+        struct Tile
+        {
+            Cairo::RefPtr<Cairo::ImageSurface> surface;
+            bool valid = false;
+        };
+        static constexpr int kTileSize = 256;
+        std::unordered_map<std::uint64_t, Tile> _tiles;
+        float _tile_scale;
+
+        void DrawTiles(const Cairo::RefPtr<Cairo::Context> &cr);
+        void RenderTile(Tile & tile, int x, int y);
+        void InvalidateTiles(const Rect & bounds);
+        void InvalidateTiles();
+        static std::uint64_t GetTileKey(int x, int y);
+
+        // with a GL area under the view the rails and ties are drawn by it and the
+        // view only draws the handles and the selection
+        LayoutGLArea * _gl_area;
+        bool UseGL() const;
+
+        bool _stats_overlay;
+        FrameStats _frame_stats;
+        sigc::signal<void, const FrameStats &> _signal_frame_stats;
+
+        void DrawFrame(const Cairo::RefPtr<Cairo::Context>& cr);
+
+        void DrawCurve(const Cairo::RefPtr<Cairo::Context>& cr) const;
+        void DrawTies(const Cairo::RefPtr<Cairo::Context>& cr) const;
+        void UpdateRailPath(const Cairo::RefPtr<Cairo::Context>& cr, size_t idx);
         std::unique_ptr<BezierCurve> CreateCurve() const;
+        void ConfigureCurve(BezierCurve & curve) const;
+
+        void AddToGraph(size_t idx);
+        void UpdateIndex(size_t idx);
+        void RemoveIndex(size_t idx);
+        bool PickHandle(double x, double y, unsigned & curve, unsigned & handle);
+        bool PickCurve(double x, double y, unsigned & curve);
 
         void DrawText(const Cairo::RefPtr<Cairo::Context> &cr);
-        void DrawCurves(const Cairo::RefPtr<Cairo::Context> &cr);
+        void DrawCurves(const Cairo::RefPtr<Cairo::Context> &cr, bool live);
+        void DrawHandles(const Cairo::RefPtr<Cairo::Context> &cr, const BezierCurve & curve) const;
+        void DrawConflicts(const Cairo::RefPtr<Cairo::Context> &cr);
+        bool IsLive(size_t idx) const;
+        bool IsSelected(size_t idx) const;
+        Rect GetClipRect(const Cairo::RefPtr<Cairo::Context> &cr) const;
+        void InvalidateBounds(const Rect & bounds);
         void ParallelCurve(const Cairo::RefPtr<Cairo::Context> &cr, gdouble t, gdouble x, gdouble y);
 
+        // with motion coalescing only the latest drag position is kept and applied
+        // on the next frame clock tick
+        bool _coalesce_motion;
+        bool _motion_pending;
+        Point _motion_point;
+        guint _tick_id;
+
+        bool OnTick(const Glib::RefPtr<Gdk::FrameClock> & clock);
+        void FlushMotion();
+        void ApplyDrag(double x, double y);
+
         bool on_button_press(GdkEventButton * event);
         bool on_button_motion(GdkEventMotion * event);
         bool on_button_release(GdkEventButton * event);
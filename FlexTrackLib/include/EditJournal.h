@@ -0,0 +1,92 @@
+#ifndef BYTETRAIL_EDITJOURNAL_H
+#define BYTETRAIL_EDITJOURNAL_H
+
+#include <cstdint>
+#include <vector>
+
+#include "Geometry.h"
+#include "TrackGraph.h"
+
+namespace ByteTrail {
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Undo and redo history of the control point edits of a layout
+    //!
+    //! A step is everything between BeginStep() and EndStep(), typically one drag.
+    //! While it is open, Record() notes the control points of the segments an edit
+    //! touched, from TrackGraph::GetTouched(), the first time a segment is touched; any
+    //! number of motion events of the drag coalesce into that one record. Closing the
+    //! step keeps only the control points that ended up elsewhere, each as its
+    //! segment, index and the positions before and after the step.
+    //!
+    //! Changes are kept in a ring of fixed capacity allocated up front, so a step
+    //! costs sizeof(Change) per control point moved plus sizeof(Step), regardless of
+    //! how many samples the curves have, and recording never allocates once the first
+    //! drag is done. The oldest steps are dropped to make room for new ones.
+    //!
+    //! Undoing or redoing a step sets the control points of the segments it changed
+    //! back, which leaves every other curve unmodified, so only those are recalculated.
+    //! Only edits of control points are journaled; the history must be cleared when
+    //! segments are added or removed.
+    //-----------------------------------------------------------------------------------
+    class EditJournal {
+    public:
+        //! \brief Control point moved by a step
+        struct Change {
+            std::uint32_t segment;
+            std::uint32_t index;
+            Point before;
+            Point after;
+        };
+
+        //! \brief Changes of an undo step, by position in the ring
+        struct Step {
+            std::uint32_t first;
+            std::uint32_t count;
+        };
+
+        explicit EditJournal(unsigned capacity = kDefaultCapacity);
+        virtual ~EditJournal();
+
+        unsigned GetCapacity() const;
+        void Clear();
+
+        void BeginStep();
+        void Record(const TrackGraph & graph);
+        bool EndStep(const TrackGraph & graph);
+        bool IsRecording() const;
+
+        unsigned GetStepCount() const;
+        unsigned GetChangeCount() const;
+        bool CanUndo() const;
+        bool CanRedo() const;
+        bool Undo(TrackGraph & graph);
+        bool Redo(TrackGraph & graph);
+        const std::vector<TrackGraph::Touch> & GetReplayed() const;
+
+        //! control point changes kept by default
+        static constexpr unsigned kDefaultCapacity = 4096;
+
+    private:
+        void Replay(TrackGraph & graph, const Step & step, bool undo);
+
+        // ring of changes, the steps hold positions in it
+        std::vector<Change> _changes;
+        // ring of steps, at most one per change. _first is the oldest step kept,
+        // _count the number kept and _current the number of them applied
+        std::vector<Step> _steps;
+        unsigned _first;
+        unsigned _count;
+        unsigned _current;
+        // changes held by the steps kept
+        unsigned _used;
+
+        bool _recording;
+        // control points of each segment touched by the open step, before the step
+        std::vector<TrackGraph::Touch> _pending;
+        std::vector<TrackGraph::Touch> _replayed;
+    };
+
+}
+
+#endif // BYTETRAIL_EDITJOURNAL_H
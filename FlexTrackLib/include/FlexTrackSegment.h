@@ -16,12 +16,19 @@ namespace ByteTrail {
       virtual ~FlexTrackSegment();
 
       const std::shared_ptr<BezierCurve> GetCurve();
-      void GetTies();
-
-    protected:
-    private:
+      const std::vector<Quad> & GetTies();
+      const Quad * GetTieData();
+      std::size_t GetTieCount();
+
+      static void GenerateTies(BezierCurve & curve, std::vector<Quad> & ties);
+
+    protected:
+    private:
+      void RegenerateTies();
+
       std::shared_ptr<BezierCurve> _curve;
-      std::vector<std::shared_ptr<Polygon>> _ties;
+      std::vector<Quad> _ties;
+      unsigned long _ties_revision;
 
   };
 }
@@ -1,9 +1,10 @@
 #ifndef BTS_GEOMETRY_H_INCLUDED
 #define BTS_GEOMETRY_H_INCLUDED
 
-#include <memory>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
 #include <vector>
-#include <list>
 
 namespace ByteTrail {
 
@@ -15,13 +16,14 @@ namespace ByteTrail {
         SEG_CLOSE
     };
 
-    struct PathSegment {
+    //---------------------------------------------------------------------------
+    //! \brief One element of a FlatPath, referring into the path storage
+    //---------------------------------------------------------------------------
+    struct PathElement {
         SegmentType type;
-        std::shared_ptr<Point> point;
+        const Point * point;
     };
 
-    const PathSegment PATH_SEGMENT_CLOSE{SEG_CLOSE, nullptr};
-
     struct Point {
       double x;
       double y;
@@ -33,26 +35,57 @@ namespace ByteTrail {
           this->y = y;
       }
 
-      inline Point(const Point & point) {
-          x = point.x;
-          y = point.y;
-      }
-
       double Distance(const Point & other) const;
       double Slope(const Point & other) const;
       std::unique_ptr<Point> GetPointFrom(const Point & midpoint) const;
 
-      inline void operator=(const Point & point) {
-          x = point.x;
-          y = point.y;
-      }
-
       inline friend bool operator==(const Point & a, const Point & b) {
           return a.x == b.x && a.y == b.y;
 
       }
     };
 
+    // points are copied and moved as plain memory, so arrays of them can be
+    // resized, copied and handed to renderers without running any code per point
+    static_assert(std::is_trivially_copyable<Point>::value, "Point must stay plain data");
+
+    //---------------------------------------------------------------------------
+    //! \brief Four corners of a quadrilateral in perimeter order
+    //!
+    //! Quads are plain data so arrays of them can be handed to a renderer as a
+    //! single packed buffer of 8 doubles per quad.
+    //---------------------------------------------------------------------------
+    struct Quad {
+      Point corners[4];
+    };
+
+    //---------------------------------------------------------------------------
+    //! \brief Non-owning, read only view of contiguous points
+    //!
+    //! The view refers to storage owned elsewhere, typically the cached buffers of
+    //! a BezierCurve, and is invalidated when that storage is resized.
+    //---------------------------------------------------------------------------
+    class PointView {
+      public:
+        inline PointView() : _data(nullptr), _size(0) {}
+        inline PointView(const Point * data, std::size_t size) : _data(data), _size(size) {}
+        inline PointView(const std::vector<Point> & points)
+                : _data(points.data()), _size(points.size()) {}
+
+        inline const Point * begin() const { return _data; }
+        inline const Point * end() const { return _data + _size; }
+        inline const Point * data() const { return _data; }
+        inline std::size_t size() const { return _size; }
+        inline bool empty() const { return _size == 0; }
+        inline const Point & front() const { return _data[0]; }
+        inline const Point & back() const { return _data[_size - 1]; }
+        inline const Point & operator[](std::size_t idx) const { return _data[idx]; }
+
+      private:
+        const Point * _data;
+        std::size_t _size;
+    };
+
     struct Rect {
       double x;
       double y;
@@ -61,11 +94,66 @@ namespace ByteTrail {
 
       bool Contains(const Point & p ) const;
       bool Contains(double x, double y) const;
+      bool Intersects(const Rect & other) const;
+    };
+
+    //---------------------------------------------------------------------------
+    //! \brief Path stored as contiguous arrays of segment types and points
+    //!
+    //! Any number of sub paths can be appended. Clear() keeps the allocated
+    //! storage so a path rebuilt every frame does not allocate once it has
+    //! reached its largest size. The point stored with SEG_CLOSE is the start of
+    //! the sub path being closed.
+    //---------------------------------------------------------------------------
+    class FlatPath {
+      public:
+          class Iterator {
+            public:
+              inline Iterator(const FlatPath * path, std::size_t idx) : _path(path), _idx(idx) {}
+              inline PathElement operator*() const {
+                  return PathElement{_path->_types[_idx], &_path->_points[_idx]};
+              }
+              inline Iterator & operator++() { ++_idx; return *this; }
+              inline bool operator==(const Iterator & other) const { return _idx == other._idx; }
+              inline bool operator!=(const Iterator & other) const { return _idx != other._idx; }
+            private:
+              const FlatPath * _path;
+              std::size_t _idx;
+          };
+
+          FlatPath();
+          virtual ~FlatPath();
+
+          void Reserve(std::size_t elements);
+          void Clear();
+
+          void MoveTo(const Point & point);
+          void MoveTo(double x, double y);
+          void LineTo(const Point & point);
+          void LineTo(double x, double y);
+          void Close();
+          void PopBack();
+
+          std::size_t GetSize() const;
+          bool IsEmpty() const;
+
+          inline SegmentType GetType(std::size_t idx) const { return _types[idx]; }
+          inline const Point & GetPoint(std::size_t idx) const { return _points[idx]; }
+          inline const SegmentType * GetTypes() const { return _types.data(); }
+          inline const Point * GetPoints() const { return _points.data(); }
+
+          inline Iterator begin() const { return Iterator(this, 0); }
+          inline Iterator end() const { return Iterator(this, _types.size()); }
+
+      private:
+          std::vector<SegmentType> _types;
+          std::vector<Point> _points;
+          std::size_t _subpath_start;
     };
 
   class Path {
     public:
-         virtual const std::list<std::shared_ptr<PathSegment>> & GetPath() = 0;
+         virtual const FlatPath & GetPath() = 0;
   };
 
     class Polygon : private Path {
@@ -74,13 +162,15 @@ namespace ByteTrail {
           virtual ~Polygon();
 
           //const std::vector<Point> & GetPoints() const;
-          const std::list<std::shared_ptr<PathSegment>> & GetPath();
+          const FlatPath & GetPath();
           int Add(const Point & point);
           int GetSize() const;
+          void Reserve(std::size_t points);
+          void Clear();
       protected:
       private:
-          std::list<std::shared_ptr<PathSegment>> _path;
-    };
+          FlatPath _path;
+    };
 
 }
 #endif // BTS_GEOMETRY_H_INCLUDED
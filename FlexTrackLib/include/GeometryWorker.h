@@ -0,0 +1,81 @@
+#ifndef BYTETRAIL_GEOMETRYWORKER_H
+#define BYTETRAIL_GEOMETRYWORKER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "BezierCurve.h"
+#include "LayoutRecalculator.h"
+#include "TaskPool.h"
+
+namespace ByteTrail {
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Recalculates curves on a thread of its own and publishes the results as
+    //!        immutable snapshots
+    //!
+    //! The owner posts edited curves and keeps going. The worker copies them into its
+    //! back buffer, recalculates the copies and swaps in a new snapshot, which shares
+    //! every curve that did not change with the previous one. A snapshot is never
+    //! modified once published, so any number of them can be read while the worker
+    //! builds the next.
+    //-----------------------------------------------------------------------------------
+    class GeometryWorker {
+    public:
+        typedef std::vector<std::shared_ptr<BezierCurve>> Curves;
+
+        //! \brief Curves of a layout at one point in time, all of them up to date
+        //!
+        //! Reading the geometry of an up to date curve does not recalculate it, so a
+        //! snapshot is safe to draw from on one thread while the worker runs; its
+        //! curves must not be edited.
+        struct Snapshot {
+            unsigned long generation;
+            Curves curves;
+        };
+
+        explicit GeometryWorker(TaskPool & pool, std::function<void()> published = nullptr);
+        virtual ~GeometryWorker();
+
+        void Post(std::size_t idx, const BezierCurve & curve);
+        void Resize(std::size_t count);
+        void Wait();
+
+        std::shared_ptr<const Snapshot> GetSnapshot() const;
+
+    private:
+        GeometryWorker(const GeometryWorker &) = delete;
+        GeometryWorker & operator=(const GeometryWorker &) = delete;
+
+        void Run();
+
+        LayoutRecalculator _recalculator;
+        std::function<void()> _published;
+
+        std::mutex _mutex;
+        std::condition_variable _wake;
+        std::condition_variable _idle;
+        // edits posted since the worker last looked, the latest one per curve
+        std::map<std::size_t, BezierCurve> _pending;
+        std::size_t _count;
+        bool _busy;
+        bool _stop;
+
+        // accessed through the atomic shared_ptr functions
+        std::shared_ptr<const Snapshot> _snapshot;
+
+        // used by the worker thread only
+        Curves _changed;
+
+        std::thread _thread;
+    };
+
+}
+
+#endif // BYTETRAIL_GEOMETRYWORKER_H
@@ -0,0 +1,98 @@
+#ifndef BYTETRAIL_LAYOUTEXPORTER_H
+#define BYTETRAIL_LAYOUTEXPORTER_H
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include "BezierCurve.h"
+#include "FlexTrackSegment.h"
+#include "Geometry.h"
+#include "LayoutFile.h"
+
+namespace ByteTrail {
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Fixed size output buffer that is written to a stream in large chunks
+    //!
+    //! Text is appended to the buffer and only handed to the stream when the buffer is
+    //! full, so the stream sees one write per kBufferSize bytes however small the
+    //! pieces of output are.
+    //-----------------------------------------------------------------------------------
+    class BufferedSink {
+    public:
+        explicit BufferedSink(std::ostream & out);
+        virtual ~BufferedSink();
+
+        void Write(const char * text);
+        void Write(const char * text, std::size_t size);
+        void Write(char c);
+        void WriteNumber(double value);
+        void Flush();
+
+        bool IsGood() const;
+        std::size_t GetBytesWritten() const;
+        std::size_t GetChunkCount() const;
+
+        //! size of the buffer and so of the writes to the stream
+        static constexpr std::size_t kBufferSize = 64 * 1024;
+        //! decimal places written for coordinates, 1 micrometre in layout units
+        static constexpr unsigned kDecimals = 3;
+
+    private:
+        BufferedSink(const BufferedSink &) = delete;
+        BufferedSink & operator=(const BufferedSink &) = delete;
+
+        std::ostream & _out;
+        std::vector<char> _buffer;
+        std::size_t _used;
+        std::size_t _bytes_written;
+        std::size_t _chunk_count;
+    };
+
+    //! \brief Output formats of the layout exporter
+    enum ExportFormat {
+        EXPORT_SVG,
+        EXPORT_DXF
+    };
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Writes the rails and tie outlines of a layout for fabrication
+    //!
+    //! Segments are written one at a time straight from the point buffers the curves
+    //! and segments keep for drawing, so no polygons of the whole layout are built.
+    //! Export() streams a layout file through a single scratch segment, which makes
+    //! memory use independent of the size of the layout.
+    //!
+    //! SVG output uses layout coordinates as user units with y pointing down. DXF
+    //! output is plain ASCII DXF with a polyline entity per rail and tie on the RAILS
+    //! and TIES layers, with y pointing up.
+    //-----------------------------------------------------------------------------------
+    class LayoutExporter {
+    public:
+        LayoutExporter(std::ostream & out, ExportFormat format);
+        virtual ~LayoutExporter();
+
+        void Begin(const Rect & bounds);
+        void WriteCurve(BezierCurve & curve);
+        void WriteSegment(FlexTrackSegment & segment);
+        bool End();
+
+        unsigned Export(const LayoutFile & file);
+
+        const BufferedSink & GetSink() const;
+
+    private:
+        void WritePolyline(const Point * points, std::size_t count, bool closed, const char * layer);
+        void WriteCoordinate(double x, double y);
+
+        BufferedSink _sink;
+        ExportFormat _format;
+        // loaded from each record in turn by Export()
+        std::unique_ptr<FlexTrackSegment> _scratch;
+    };
+
+}
+
+#endif // BYTETRAIL_LAYOUTEXPORTER_H
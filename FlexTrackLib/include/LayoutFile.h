@@ -0,0 +1,115 @@
+#ifndef BYTETRAIL_LAYOUTFILE_H
+#define BYTETRAIL_LAYOUTFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BezierBatch.h"
+#include "BezierCurve.h"
+#include "Geometry.h"
+#include "TrackGraph.h"
+
+namespace ByteTrail {
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Binary layout file, mapped into memory and read in place
+    //!
+    //! The file is a 32 byte header followed by an index of fixed size segment
+    //! records; segment i is found at records offset + i * record size. All values
+    //! are little endian.
+    //!
+    //! Header:
+    //! | offset | type     | field                                       |
+    //! |--------|----------|---------------------------------------------|
+    //! | 0      | char[4]  | magic, "FTLY"                               |
+    //! | 4      | uint32   | version                                     |
+    //! | 8      | uint32   | number of segments                          |
+    //! | 12     | uint32   | record size, at least kRecordSize           |
+    //! | 16     | uint64   | offset of the first record                  |
+    //! | 24     | uint64   | reserved                                    |
+    //!
+    //! Segment record:
+    //! | offset | type      | field                                      |
+    //! |--------|-----------|--------------------------------------------|
+    //! | 0      | double[8] | control points 0 to 3, x then y            |
+    //! | 64     | double[4] | bounds x, y, width and height              |
+    //! | 96     | float     | resolution                                 |
+    //! | 100    | float     | parallels distance                         |
+    //! | 104    | uint32[2] | end slot joined to the start and finish    |
+    //! | 112    | uint32    | flags, bit 0 set for fixed track           |
+    //! | 116    | byte[12]  | reserved                                   |
+    //!
+    //! A joined end slot is segment * 2 + end as in TrackGraph, kNoLink if open.
+    //! Readers accept larger records, so later versions can append fields.
+    //!
+    //! Nothing is parsed when a file is opened: segment values are decoded from the
+    //! mapping on access, and curves are only created for the segments a viewport
+    //! needs. Open() only checks the structure of the file, so the accessors check
+    //! the values a curve cannot take: a resolution outside [kMinimumResolution, 1)
+    //! or a rail distance that is not finite reads as the default of a new curve.
+    //-----------------------------------------------------------------------------------
+    class LayoutFile {
+    public:
+        LayoutFile();
+        virtual ~LayoutFile();
+
+        static bool Write(const std::string & path, const TrackGraph & graph);
+
+        bool Open(const std::string & path);
+        void Close();
+        bool IsOpen() const;
+
+        unsigned GetVersion() const;
+        unsigned GetSegmentCount() const;
+        Point GetControlPoint(unsigned segment, unsigned index) const;
+        Rect GetBounds(unsigned segment) const;
+        float GetResolution(unsigned segment) const;
+        float GetParallelsDistance(unsigned segment) const;
+        bool IsFixed(unsigned segment) const;
+        unsigned GetLink(unsigned segment, TrackGraph::End end) const;
+
+        void Query(const Rect & area, std::vector<unsigned> & segments) const;
+        std::shared_ptr<BezierCurve> CreateCurve(unsigned segment) const;
+        unsigned LoadVisible(const Rect & viewport, std::vector<std::shared_ptr<BezierCurve>> & curves,
+                             BezierBatch & batch);
+        void Load(TrackGraph & graph) const;
+
+        static constexpr std::uint32_t kVersion = 1;
+        static constexpr std::size_t kHeaderSize = 32;
+        static constexpr std::size_t kRecordSize = 128;
+        static constexpr std::uint32_t kNoLink = TrackGraph::kNoLink;
+        static constexpr std::uint32_t kFlagFixed = 1;
+        //! finest resolution read from a record, a finer one would size the curve
+        //! buffers from a corrupt value
+        static constexpr float kMinimumResolution = 0.001F;
+
+    private:
+        LayoutFile(const LayoutFile &) = delete;
+        LayoutFile & operator=(const LayoutFile &) = delete;
+
+        const unsigned char * GetRecord(unsigned segment) const;
+
+        const unsigned char * _data;
+        std::size_t _size;
+        unsigned _segment_count;
+        std::size_t _record_size;
+        std::size_t _records_offset;
+        unsigned _version;
+#ifdef _WIN32
+        void * _file;
+        void * _mapping;
+#else
+        int _file;
+#endif
+
+        // segments in view and the curves created for them by LoadVisible()
+        std::vector<unsigned> _visible;
+        std::vector<std::shared_ptr<BezierCurve>> _visible_curves;
+    };
+
+}
+
+#endif // BYTETRAIL_LAYOUTFILE_H
@@ -0,0 +1,80 @@
+#ifndef BYTETRAIL_LAYOUTGLAREA_H
+#define BYTETRAIL_LAYOUTGLAREA_H
+
+#include <memory>
+#include <vector>
+#include <gtkmm/glarea.h>
+#include "BezierCurve.h"
+#include "LayoutVertexBuffer.h"
+#include "LevelOfDetail.h"
+
+namespace ByteTrail
+{
+
+//-----------------------------------------------------------------------------
+//! \brief OpenGL renderer of the rails and ties of a layout
+//!
+//! Placed under a CurveView in a Gtk::Overlay, it draws the layout while the
+//! view draws the handles, the selection and the overlays on top. The rails
+//! of every curve are drawn with one call from the centerline vertices, the
+//! vertex shader offsetting them to either rail, and the ties with one
+//! instanced call that expands a unit quad per tie. Only the ranges of the
+//! vertex buffers that changed are uploaded before a frame.
+//!
+//! Needs OpenGL 3.3. If no context can be created IsAvailable() stays false
+//! and the view keeps drawing with Cairo.
+//-----------------------------------------------------------------------------
+class LayoutGLArea : public Gtk::GLArea
+{
+    public:
+        LayoutGLArea();
+        virtual ~LayoutGLArea();
+
+        bool IsAvailable() const;
+        void SetEnabled(bool enabled);
+        void Sync(const std::vector<std::shared_ptr<BezierCurve>> & curves, float scale);
+
+    protected:
+        virtual void on_realize();
+        virtual void on_unrealize();
+        virtual bool on_render(const Glib::RefPtr<Gdk::GLContext> & context);
+
+    private:
+        //! locations of the uniforms of a shader program, -1 if it has none
+        struct Uniforms
+        {
+            int viewport;
+            int scale;
+            int side;
+            int tie_size;
+            int color;
+        };
+
+        bool CreateProgram(unsigned & program, Uniforms & uniforms, const char * vertex_source);
+        void Upload(LayoutVertexBuffer::Array array, bool whole);
+        void Release();
+
+        bool _available;
+        bool _enabled;
+        float _scale;
+        DetailLevel _detail;
+        LayoutVertexBuffer _vertices;
+        std::vector<int> _firsts;
+        std::vector<int> _counts;
+
+        unsigned _rail_program;
+        unsigned _tie_program;
+        Uniforms _rail_uniforms;
+        Uniforms _tie_uniforms;
+        unsigned _rail_array;
+        unsigned _tie_array;
+        unsigned _buffers[LayoutVertexBuffer::ARRAY_COUNT];
+        unsigned _quad_buffer;
+        // floats allocated for each buffer on the GPU
+        std::size_t _capacity[LayoutVertexBuffer::ARRAY_COUNT];
+        unsigned long _layout_revision;
+};
+
+}
+
+#endif // BYTETRAIL_LAYOUTGLAREA_H
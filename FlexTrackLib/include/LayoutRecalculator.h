@@ -0,0 +1,47 @@
+#ifndef BYTETRAIL_LAYOUTRECALCULATOR_H
+#define BYTETRAIL_LAYOUTRECALCULATOR_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "BezierCurve.h"
+#include "FlexTrackSegment.h"
+#include "SegmentStore.h"
+#include "TaskPool.h"
+
+namespace ByteTrail {
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Brings a whole layout up to date on a task pool
+    //!
+    //! A curve only depends on its own control points, so the modified curves of a
+    //! layout, and the ties of its segments, are recalculated in parallel chunks.
+    //! Recalculate() returns once every chunk is done, so the thread drawing the
+    //! layout reads the results without any locking.
+    //-----------------------------------------------------------------------------------
+    class LayoutRecalculator {
+    public:
+        explicit LayoutRecalculator(TaskPool & pool);
+        virtual ~LayoutRecalculator();
+
+        static std::size_t GetModifiedCount(const std::vector<std::shared_ptr<BezierCurve>> & curves);
+        static std::size_t GetModifiedCount(const SegmentStore & curves);
+
+        std::size_t Recalculate(std::vector<std::shared_ptr<BezierCurve>> & curves);
+        std::size_t Recalculate(SegmentStore & curves);
+        void Recalculate(std::vector<std::shared_ptr<FlexTrackSegment>> & segments);
+
+        //! number of curves or segments handed to a thread at a time
+        static constexpr std::size_t kGrainSize = 32;
+
+    private:
+        std::size_t RecalculateModified();
+
+        TaskPool & _pool;
+        std::vector<BezierCurve *> _modified;
+    };
+
+}
+
+#endif // BYTETRAIL_LAYOUTRECALCULATOR_H
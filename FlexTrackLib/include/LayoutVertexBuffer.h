@@ -0,0 +1,90 @@
+#ifndef BYTETRAIL_LAYOUTVERTEXBUFFER_H
+#define BYTETRAIL_LAYOUTVERTEXBUFFER_H
+
+#include <cstddef>
+#include <vector>
+
+#include "BezierCurve.h"
+#include "Geometry.h"
+
+namespace ByteTrail {
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Vertex data of a whole layout packed for upload to a GPU
+    //!
+    //! Rails are stored once per curve as the centerline points, each with the offset
+    //! to the left rail, so a shader draws either rail or the centerline from the same
+    //! vertices. Ties are stored as one instance per tie, its center and the unit
+    //! direction of the track, for a shader that expands a unit quad.
+    //!
+    //! Every curve owns a slot of each array with some room to grow. Updating a curve
+    //! rewrites its slot only and records the range of floats that changed, so an edit
+    //! re-uploads just that range. A curve outgrowing its slot is moved to the end of
+    //! the array; the space left behind is zeroed, which makes stale ties degenerate
+    //! quads, and the arrays are compacted once more than half of them is unused.
+    //-----------------------------------------------------------------------------------
+    class LayoutVertexBuffer {
+    public:
+        //! \brief Floats changed since the last TakeDirty() of an array
+        struct Range {
+            std::size_t first;
+            std::size_t count;
+        };
+
+        //! \brief Arrays of the buffer
+        enum Array {
+            ARRAY_RAILS,
+            ARRAY_TIES,
+            ARRAY_COUNT
+        };
+
+        LayoutVertexBuffer();
+        virtual ~LayoutVertexBuffer();
+
+        void Resize(unsigned curves);
+        unsigned GetSize() const;
+        bool Update(unsigned idx, BezierCurve & curve, bool ties);
+
+        const std::vector<float> & GetData(Array array) const;
+        unsigned long GetLayoutRevision() const;
+        bool TakeDirty(Array array, Range & range);
+
+        void GetRailStrips(std::vector<int> & firsts, std::vector<int> & counts) const;
+        std::size_t GetTieCount() const;
+
+        //! floats per rail vertex: x, y and the offset to the left rail
+        static constexpr unsigned kRailStride = 4;
+        //! floats per tie instance: center x, y and the unit direction
+        static constexpr unsigned kTieStride = 4;
+
+    private:
+        //! \brief Part of an array owned by a curve, in vertices or instances
+        struct Slot {
+            std::size_t first;
+            std::size_t count;
+            std::size_t capacity;
+        };
+
+        struct Entry {
+            Slot slots[ARRAY_COUNT];
+            unsigned long rails_revision;
+            unsigned long ties_revision;
+        };
+
+        float * Allocate(unsigned idx, Array array, std::size_t count);
+        void MarkDirty(Array array, std::size_t first, std::size_t count);
+        void Compact(Array array);
+
+        std::vector<Entry> _entries;
+        std::vector<float> _data[ARRAY_COUNT];
+        // vertices or instances of each array in slots no longer used
+        std::size_t _unused[ARRAY_COUNT];
+        Range _dirty[ARRAY_COUNT];
+        // changes whenever slots move, everything then has to be uploaded again
+        unsigned long _layout_revision;
+        std::vector<Quad> _ties;
+    };
+
+}
+
+#endif // BYTETRAIL_LAYOUTVERTEXBUFFER_H
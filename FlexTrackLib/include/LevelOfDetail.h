@@ -0,0 +1,65 @@
+#ifndef BYTETRAIL_LEVELOFDETAIL_H
+#define BYTETRAIL_LEVELOFDETAIL_H
+
+#include <cstddef>
+#include <vector>
+
+#include "BezierCurve.h"
+#include "Geometry.h"
+
+namespace ByteTrail {
+
+    //! \brief How much of a segment is drawn, from least to most
+    enum DetailLevel {
+        //! a single centerline with points about kCenterlinePixels apart
+        DETAIL_CENTERLINE,
+        //! both rails
+        DETAIL_RAILS,
+        //! both rails and the tie outlines
+        DETAIL_TIES
+    };
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Chooses and builds the geometry a segment is drawn with at a scale
+    //!
+    //! Features smaller than a few pixels on screen are dropped: ties once their
+    //! spacing closes up, the second rail once the rails merge and, for segments
+    //! that are short on screen, every point of the centerline but a few. The
+    //! geometry is built into buffers owned by the builder and reused for every
+    //! segment, so building it does not allocate once the buffers have grown.
+    //-----------------------------------------------------------------------------------
+    class LevelOfDetail {
+    public:
+        LevelOfDetail();
+        virtual ~LevelOfDetail();
+
+        static DetailLevel Select(double scale, double parallels_distance, double length);
+        static unsigned GetStride(std::size_t points, double screen_length);
+
+        void Build(BezierCurve & curve, DetailLevel level, double scale);
+
+        const std::vector<Point> & GetPoints() const;
+        const std::vector<unsigned> & GetStarts() const;
+        const std::vector<Quad> & GetTies() const;
+
+        //! on screen tie spacing from which ties are drawn, in pixels
+        static constexpr double kTiePixels = 4.0;
+        //! on screen distance between the rails from which both are drawn, in pixels
+        static constexpr double kRailPixels = 3.0;
+        //! segments shorter than this on screen are drawn as a centerline, in pixels
+        static constexpr double kRailLengthPixels = 8.0;
+        //! smallest on screen distance between decimated centerline points, in pixels
+        static constexpr double kCenterlinePixels = 4.0;
+
+    private:
+        void AddPolyline(const PointView & points, unsigned stride);
+
+        // polylines stored one after the other, each starting at an index in _starts
+        std::vector<Point> _points;
+        std::vector<unsigned> _starts;
+        std::vector<Quad> _ties;
+    };
+
+}
+
+#endif // BYTETRAIL_LEVELOFDETAIL_H
@@ -8,6 +8,15 @@ namespace ByteTrail
     constexpr float kAverageTieLength          = 16.1925F;
 
     constexpr float kFlexTrackLength           = 36.0F * 25.4F;
+
+    // distance between the rails, width of the roadbed under a track and
+    // distance between the centerlines of double track
+    constexpr float kTrackGauge                = 9.0F;
+    constexpr float kRoadbedWidth              = 25.4F;
+    constexpr float kDoubleTrackSpacing        = 31.75F;
+
+    // smallest radius most equipment runs through
+    constexpr float kMinimumRadius             = 9.75F * 25.4F;
 }
 
 #endif // NSCALE_H_INCLUDED
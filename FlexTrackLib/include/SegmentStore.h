@@ -0,0 +1,87 @@
+#ifndef BYTETRAIL_SEGMENTSTORE_H
+#define BYTETRAIL_SEGMENTSTORE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "BezierCurve.h"
+
+namespace ByteTrail {
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Curves of a layout held by value in one contiguous array
+    //!
+    //! Curves are identified by handles that stay valid while other curves are added
+    //! and removed. A handle names a slot and the generation of the slot, so a handle
+    //! to a removed curve is recognized even after its slot was reused. Removing a
+    //! curve moves the last curve into its place, which keeps the array dense and
+    //! walking the whole layout a linear pass over memory without any indirection or
+    //! reference counting.
+    //!
+    //! References and dense indices are invalidated by Add() and Remove(), handles only
+    //! by removing their own curve.
+    //-----------------------------------------------------------------------------------
+    class SegmentStore {
+    public:
+        //! \brief Stable name of a curve in the store
+        struct Handle {
+            std::uint32_t slot;
+            std::uint32_t generation;
+
+            inline friend bool operator==(const Handle & a, const Handle & b) {
+                return a.slot == b.slot && a.generation == b.generation;
+            }
+
+            inline friend bool operator!=(const Handle & a, const Handle & b) {
+                return !(a == b);
+            }
+        };
+
+        SegmentStore();
+        virtual ~SegmentStore();
+
+        unsigned GetSize() const;
+        bool IsEmpty() const;
+        void Reserve(unsigned size);
+        void Clear();
+
+        Handle Add(const BezierCurve & curve);
+        Handle Add(BezierCurve && curve);
+        bool Remove(Handle handle);
+
+        bool Contains(Handle handle) const;
+        BezierCurve * Find(Handle handle);
+        const BezierCurve * Find(Handle handle) const;
+        BezierCurve & Get(Handle handle);
+        const BezierCurve & Get(Handle handle) const;
+
+        unsigned GetIndex(Handle handle) const;
+        Handle GetHandle(unsigned idx) const;
+
+        inline BezierCurve & operator[](unsigned idx) { return _curves[idx]; }
+        inline const BezierCurve & operator[](unsigned idx) const { return _curves[idx]; }
+        inline BezierCurve * begin() { return _curves.data(); }
+        inline BezierCurve * end() { return _curves.data() + _curves.size(); }
+        inline const BezierCurve * begin() const { return _curves.data(); }
+        inline const BezierCurve * end() const { return _curves.data() + _curves.size(); }
+
+        //! handle that names no curve
+        static constexpr Handle kNoHandle = {~0U, 0};
+        //! dense index of a removed curve
+        static constexpr unsigned kNoIndex = ~0U;
+
+    private:
+        Handle Link();
+
+        std::vector<BezierCurve> _curves;
+        // per dense index, the slot naming the curve
+        std::vector<std::uint32_t> _owners;
+        // per slot, the dense index of its curve or kNoIndex, and its generation
+        std::vector<std::uint32_t> _indices;
+        std::vector<std::uint32_t> _generations;
+        std::vector<std::uint32_t> _free;
+    };
+
+}
+
+#endif // BYTETRAIL_SEGMENTSTORE_H
@@ -0,0 +1,71 @@
+#ifndef BYTETRAIL_SPATIALGRID_H
+#define BYTETRAIL_SPATIALGRID_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "Geometry.h"
+
+namespace ByteTrail {
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Uniform grid index of rectangles
+    //!
+    //! Every entry is identified by a small integer id and is registered in each grid
+    //! cell its bounding box overlaps. Point and area queries only visit the cells
+    //! they cover, so with entries that are small compared to the layout a query
+    //! costs about the same regardless of the number of entries. Moving an entry
+    //! only touches the cells it leaves and enters.
+    //!
+    //! Ids index an internal table and should be kept dense. Queries are not safe to
+    //! run concurrently on the same grid.
+    //-----------------------------------------------------------------------------------
+    class SpatialGrid {
+    public:
+        explicit SpatialGrid(double cell_size = kDefaultCellSize);
+        virtual ~SpatialGrid();
+
+        double GetCellSize() const;
+        unsigned GetSize() const;
+
+        void Clear();
+        void Insert(unsigned id, const Rect & bounds);
+        void Remove(unsigned id);
+        bool Contains(unsigned id) const;
+        const Rect & GetBounds(unsigned id) const;
+
+        void Query(const Rect & area, std::vector<unsigned> & ids) const;
+        void Query(double x, double y, std::vector<unsigned> & ids) const;
+
+        static constexpr double kDefaultCellSize = 64.0;
+
+    private:
+        struct Entry {
+            Rect bounds;
+            int min_x;
+            int min_y;
+            int max_x;
+            int max_y;
+            bool used;
+        };
+
+        int GetCell(double coordinate) const;
+        static std::uint64_t GetKey(int x, int y);
+        void Link(unsigned id, const Entry & entry);
+        void Unlink(unsigned id, const Entry & entry);
+
+        double _cell_size;
+        unsigned _size;
+        std::vector<Entry> _entries;
+        std::unordered_map<std::uint64_t, std::vector<unsigned>> _cells;
+
+        // per entry stamp of the last query that reported it, removes duplicates
+        // of entries that span several cells without allocating
+        mutable std::vector<unsigned> _stamps;
+        mutable unsigned _query;
+    };
+
+}
+
+#endif // BYTETRAIL_SPATIALGRID_H
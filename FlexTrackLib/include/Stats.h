@@ -0,0 +1,117 @@
+#ifndef BYTETRAIL_STATS_H
+#define BYTETRAIL_STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+namespace ByteTrail {
+
+    //! \brief Work counted per frame
+    enum StatCounter {
+        STAT_CURVES_RECALCULATED,
+        STAT_POINTS_EMITTED,
+        STAT_STROKES_ISSUED,
+        STAT_TIES_GENERATED,
+        STAT_CLEARANCE_PAIRS_CHECKED,
+        STAT_GRID_CELLS_VISITED,
+        STAT_COUNTER_COUNT
+    };
+
+    //! \brief Code timed per frame, nested timers include the time of inner ones
+    enum StatTimer {
+        STAT_TIMER_RECALCULATE_CURVE,
+        STAT_TIMER_RECALCULATE_PARALLELS,
+        STAT_TIMER_GET_TIES,
+        STAT_TIMER_DRAW,
+        STAT_TIMER_COUNT
+    };
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Counters and timings collected over one frame
+    //-----------------------------------------------------------------------------------
+    struct FrameStats {
+        std::uint64_t frame;
+        //! total time per timer in milliseconds
+        double time[STAT_TIMER_COUNT];
+        //! number of times each timer ran
+        std::uint64_t calls[STAT_TIMER_COUNT];
+        std::uint64_t counters[STAT_COUNTER_COUNT];
+
+        static void WriteCsvHeader(std::ostream & out);
+        void WriteCsv(std::ostream & out) const;
+    };
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Process wide accumulator of the per frame statistics
+    //!
+    //! Collection is off until enabled; while off, counting and timing cost one
+    //! relaxed atomic load. Counters may be updated from any thread. The owner of
+    //! the frame loop calls EndFrame() once per frame to collect and reset them.
+    //-----------------------------------------------------------------------------------
+    class Stats {
+    public:
+        Stats();
+
+        static Stats & GetInstance();
+        static const char * GetName(StatCounter counter);
+        static const char * GetName(StatTimer timer);
+
+        inline bool IsEnabled() const { return _enabled.load(std::memory_order_relaxed); }
+        void SetEnabled(bool enabled);
+
+        inline void Add(StatCounter counter, std::uint64_t count) {
+            if (IsEnabled())
+                _counters[counter].fetch_add(count, std::memory_order_relaxed);
+        }
+        inline void AddTime(StatTimer timer, std::uint64_t nanoseconds) {
+            _time[timer].fetch_add(nanoseconds, std::memory_order_relaxed);
+            _calls[timer].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void EndFrame(FrameStats & stats);
+
+    private:
+        Stats(const Stats &) = delete;
+        Stats & operator=(const Stats &) = delete;
+
+        std::atomic<bool> _enabled;
+        std::atomic<std::uint64_t> _frame;
+        std::atomic<std::uint64_t> _counters[STAT_COUNTER_COUNT];
+        std::atomic<std::uint64_t> _time[STAT_TIMER_COUNT];
+        std::atomic<std::uint64_t> _calls[STAT_TIMER_COUNT];
+    };
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Adds the time until it goes out of scope to a frame timer
+    //-----------------------------------------------------------------------------------
+    class ScopedTimer {
+    public:
+        inline explicit ScopedTimer(StatTimer timer) :
+                _timer(timer),
+                _running(Stats::GetInstance().IsEnabled()) {
+            if (_running)
+                _start = std::chrono::steady_clock::now();
+        }
+
+        inline ~ScopedTimer() {
+            if (_running) {
+                Stats::GetInstance().AddTime(_timer, static_cast<std::uint64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::steady_clock::now() - _start).count()));
+            }
+        }
+
+    private:
+        ScopedTimer(const ScopedTimer &) = delete;
+        ScopedTimer & operator=(const ScopedTimer &) = delete;
+
+        StatTimer _timer;
+        bool _running;
+        std::chrono::steady_clock::time_point _start;
+    };
+
+}
+
+#endif // BYTETRAIL_STATS_H
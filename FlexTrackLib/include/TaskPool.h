@@ -0,0 +1,82 @@
+#ifndef BYTETRAIL_TASKPOOL_H
+#define BYTETRAIL_TASKPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ByteTrail {
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Fixed set of worker threads that share out ranges of work
+    //!
+    //! ParallelFor() cuts a range into chunks and deals them out over one queue per
+    //! worker. A worker takes chunks from the back of its own queue and, once that is
+    //! empty, steals from the front of the others, so uneven chunks even out. The
+    //! calling thread works through the chunks as well and returns once all of them
+    //! are done; everything written by the chunks is then visible to the caller.
+    //!
+    //! Only one ParallelFor() may run at a time.
+    //-----------------------------------------------------------------------------------
+    class TaskPool {
+    public:
+        //! body of a parallel loop: begin and end of the chunk and the index of the
+        //! thread running it, from 0 to GetThreadCount() - 1
+        typedef std::function<void(std::size_t, std::size_t, unsigned)> RangeTask;
+
+        explicit TaskPool(unsigned workers = GetDefaultWorkers());
+        virtual ~TaskPool();
+
+        static unsigned GetDefaultWorkers();
+
+        unsigned GetWorkerCount() const;
+        unsigned GetThreadCount() const;
+
+        void ParallelFor(std::size_t count, std::size_t grain, const RangeTask & task);
+
+    private:
+        TaskPool(const TaskPool &) = delete;
+        TaskPool & operator=(const TaskPool &) = delete;
+
+        struct Chunk {
+            std::size_t begin;
+            std::size_t end;
+        };
+
+        //! chunks from head on are queued. The owner takes from the back and thieves
+        //! from the head, and the storage is reused once both meet, so queueing the
+        //! chunks of a loop does not allocate after the first loop of its size
+        struct Queue {
+            std::mutex mutex;
+            std::vector<Chunk> chunks;
+            std::size_t head = 0;
+        };
+
+        void Run(unsigned worker);
+        bool RunChunk(unsigned thread);
+        bool Pop(unsigned queue, Chunk & chunk);
+        bool Steal(unsigned thread, Chunk & chunk);
+
+        std::vector<std::thread> _workers;
+        std::vector<std::unique_ptr<Queue>> _queues;
+
+        // workers wait on _mutex for a new generation of work
+        std::mutex _mutex;
+        std::condition_variable _wake;
+        std::condition_variable _done;
+        unsigned long _generation;
+        bool _stop;
+
+        std::atomic<const RangeTask *> _task;
+        std::atomic<std::size_t> _remaining;
+        std::atomic<unsigned> _active;
+    };
+
+}
+
+#endif // BYTETRAIL_TASKPOOL_H
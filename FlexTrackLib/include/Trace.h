@@ -0,0 +1,90 @@
+#ifndef BYTETRAIL_TRACE_H
+#define BYTETRAIL_TRACE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "FlexTrackLibConfig.h"
+
+//---------------------------------------------------------------------------------------
+// Trace points compile to nothing unless the library is configured with FLEXTRACK_TRACE.
+// The name must be a string literal, only the pointer is recorded.
+//---------------------------------------------------------------------------------------
+#ifdef FLEXTRACK_TRACE
+#define FT_TRACE(category, name) \
+    ::ByteTrail::TraceBuffer::GetInstance().Record((category), (name), 0.0, 0.0)
+#define FT_TRACE1(category, name, a) \
+    ::ByteTrail::TraceBuffer::GetInstance().Record((category), (name), (a), 0.0)
+#define FT_TRACE2(category, name, a, b) \
+    ::ByteTrail::TraceBuffer::GetInstance().Record((category), (name), (a), (b))
+#else
+#define FT_TRACE(category, name) ((void)0)
+#define FT_TRACE1(category, name, a) ((void)0)
+#define FT_TRACE2(category, name, a, b) ((void)0)
+#endif
+
+namespace ByteTrail {
+
+    //! \brief Groups of trace points that can be enabled separately
+    enum TraceCategory {
+        TRACE_GEOMETRY,
+        TRACE_RENDER,
+        TRACE_INPUT,
+        TRACE_CATEGORY_COUNT
+    };
+
+    //! \brief One recorded trace point
+    struct TraceEvent {
+        //! steady clock time in nanoseconds
+        std::uint64_t timestamp;
+        TraceCategory category;
+        const char * name;
+        double values[2];
+    };
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Fixed size lock free queue of trace events
+    //!
+    //! Any number of threads may record while one thread drains. Recording never
+    //! blocks or allocates: an event that finds the buffer full is dropped and
+    //! counted. All categories are enabled by default; a disabled category costs
+    //! one relaxed atomic load per trace point.
+    //-----------------------------------------------------------------------------------
+    class TraceBuffer {
+    public:
+        TraceBuffer();
+        virtual ~TraceBuffer();
+
+        static TraceBuffer & GetInstance();
+
+        bool IsEnabled(TraceCategory category) const;
+        void SetEnabled(TraceCategory category, bool enabled);
+
+        bool Record(TraceCategory category, const char * name, double a, double b);
+        std::size_t Drain(std::vector<TraceEvent> & events);
+        std::uint64_t GetDropped() const;
+
+        //! number of events the buffer holds, a power of two
+        static constexpr std::size_t kCapacity = 4096;
+
+    private:
+        TraceBuffer(const TraceBuffer &) = delete;
+        TraceBuffer & operator=(const TraceBuffer &) = delete;
+
+        struct Slot {
+            std::atomic<std::size_t> sequence;
+            TraceEvent event;
+        };
+
+        std::atomic<unsigned> _enabled;
+        std::atomic<std::uint64_t> _dropped;
+        std::atomic<std::size_t> _write;
+        std::atomic<std::size_t> _read;
+        std::vector<Slot> _slots;
+    };
+
+}
+
+#endif // BYTETRAIL_TRACE_H
@@ -0,0 +1,95 @@
+#ifndef BYTETRAIL_TRACKGRAPH_H
+#define BYTETRAIL_TRACKGRAPH_H
+
+#include <memory>
+#include <vector>
+
+#include "BezierBatch.h"
+#include "BezierCurve.h"
+#include "Connector.h"
+#include "Geometry.h"
+
+namespace ByteTrail {
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Segments of a layout and the joints between their ends
+    //!
+    //! Segments are nodes identified by their index. Each has two ends, each end a
+    //! Connector and a slot in a flat link table that holds the end it joins, so the
+    //! graph is walked through plain index arrays.
+    //!
+    //! Joined ends share a location and, for G1 continuity, a tangent. Moving a
+    //! control point restores both constraints from the edited end outwards. Flexible
+    //! segments absorb a change by adjusting their end point and the handle next to
+    //! it, which leaves their far end alone and ends the propagation. Fixed segments
+    //! can only move as a whole, so they carry the change on to their far joint.
+    //! The segments changed by an edit are recorded so only those are recalculated
+    //! and redrawn.
+    //-----------------------------------------------------------------------------------
+    class TrackGraph {
+    public:
+        //! \brief End of a segment, at control point 0 or 3 of its curve
+        enum End {
+            END_START = 0,
+            END_FINISH = 1
+        };
+
+        //! \brief Segment changed by the last edit, with its bounds and control points
+        //!        before the edit
+        struct Touch {
+            unsigned segment;
+            Rect bounds;
+            Point points[4];
+        };
+
+        TrackGraph();
+        virtual ~TrackGraph();
+
+        unsigned AddSegment(const std::shared_ptr<BezierCurve> & curve);
+        void PopSegment();
+        unsigned GetSegmentCount() const;
+        const std::shared_ptr<BezierCurve> & GetCurve(unsigned segment) const;
+
+        bool IsFixed(unsigned segment) const;
+        void SetFixed(unsigned segment, bool fixed);
+
+        bool Connect(unsigned segment, End end, unsigned other, End other_end);
+        void Disconnect(unsigned segment, End end);
+        bool GetNeighbor(unsigned segment, End end, unsigned & other, End & other_end) const;
+        const Connector & GetConnector(unsigned segment, End end);
+
+        void MoveControlPoint(unsigned segment, unsigned index, const Point & point);
+        const std::vector<Touch> & GetTouched() const;
+        void Recalculate(BezierBatch & batch);
+
+        //! link of an end that is not joined
+        static constexpr unsigned kNoLink = ~0U;
+        //! distance below which two points are taken to be the same
+        static constexpr double kEpsilon = 1.0e-9;
+
+    private:
+        static inline unsigned GetSlot(unsigned segment, End end) { return segment * 2 + end; }
+        static inline unsigned GetEndPoint(unsigned slot) { return slot % 2 == END_START ? 0 : 3; }
+        static inline unsigned GetHandle(unsigned slot) { return slot % 2 == END_START ? 1 : 2; }
+
+        void TouchSegment(unsigned segment);
+        void Propagate();
+        void RestoreJoint(unsigned from, unsigned to);
+
+        std::vector<std::shared_ptr<BezierCurve>> _curves;
+        std::vector<unsigned char> _fixed;
+        // per end slot, segment * 2 + end
+        std::vector<unsigned> _links;
+        std::vector<Connector> _connectors;
+
+        std::vector<Touch> _touched;
+        std::vector<unsigned long> _touch_stamps;
+        unsigned long _stamp;
+        // end slots whose joint changed and still has to be restored
+        std::vector<unsigned> _worklist;
+        std::vector<std::shared_ptr<BezierCurve>> _touched_curves;
+    };
+
+}
+
+#endif // BYTETRAIL_TRACKGRAPH_H
@@ -0,0 +1,54 @@
+//
+// Replacement global allocation functions that count heap allocations.
+// Include from exactly one translation unit of a test executable.
+//
+
+#ifndef BYTETRAIL_ALLOCATIONCOUNTER_H
+#define BYTETRAIL_ALLOCATIONCOUNTER_H
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace ByteTrail {
+
+    static std::atomic<std::size_t> g_allocation_count(0);
+
+    //-----------------------------------------------------------------------------------
+    //! \brief Gets the number of heap allocations made since the program started
+    //-----------------------------------------------------------------------------------
+    inline std::size_t GetAllocationCount() {
+        return g_allocation_count.load(std::memory_order_relaxed);
+    }
+
+}
+
+void *operator new(std::size_t size) {
+    ByteTrail::g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    void *ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+#endif // BYTETRAIL_ALLOCATIONCOUNTER_H
@@ -0,0 +1,140 @@
+//
+// Heap allocation checks for the curve recalculation path
+//
+
+#define BOOST_TEST_MODULE AllocationTest
+
+#include <boost/test/unit_test.hpp>
+#include <memory>
+#include <vector>
+#include "AllocationCounter.h"
+#include "BezierBatch.h"
+#include "BezierCurve.h"
+#include "FlexTrackSegment.h"
+
+namespace ByteTrail {
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that the replacement allocation functions are counting
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(AllocationCounterTest) {
+    std::size_t before = GetAllocationCount();
+    std::unique_ptr<BezierCurve> curve(new BezierCurve());
+    curve->GetCurve(0);
+    BOOST_TEST(GetAllocationCount() > before);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that recalculating a curve after its buffers are sized performs no
+//!        heap allocations
+//!
+//! Simulates a drag: every iteration moves a control point and reads the curve, the
+//! tangent points and both rails.
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(SteadyStateRecalculateTest) {
+    BezierCurve curve;
+    curve.SetControlPoint(0, 0, 0);
+    curve.SetControlPoint(25, 40, 1);
+    curve.SetControlPoint(75, -40, 2);
+    curve.SetControlPoint(100, 0, 3);
+
+    // first evaluation sizes the buffers
+    curve.GetCurve(0);
+
+    std::size_t before = GetAllocationCount();
+    for (int i = 0; i < 100; i++) {
+        curve.SetControlPoint(25 + i, 40 - i, 1);
+        curve.GetTangentPoints();
+        curve.GetCurve(0);
+        curve.GetCurve(1);
+        curve.GetCurve(2);
+        curve.GetLength();
+    }
+    std::size_t allocations = GetAllocationCount() - before;
+    BOOST_TEST(allocations == 0U);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that the tangent buffer is sized with the curve and kept in step with
+//!        control point changes
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(TangentPointsTest) {
+    BezierCurve curve;
+    curve.SetControlPoint(0, 0, 0);
+    curve.SetControlPoint(3, 0, 1);
+    curve.SetControlPoint(7, 0, 2);
+    curve.SetControlPoint(10, 0, 3);
+
+    const std::vector<Point> &tangents = curve.GetTangentPoints();
+    BOOST_TEST(tangents.size() == curve.GetCurve(0).size());
+    BOOST_TEST(tangents.front().x == 9.0);
+    BOOST_TEST(tangents.back().x == 9.0);
+    BOOST_TEST(tangents.back().y == 0.0);
+
+    curve.SetControlPoint(7, 5, 2);
+    const Point *data = tangents.data();
+    curve.GetTangentPoints();
+    BOOST_TEST(tangents.data() == data);
+    BOOST_TEST(tangents.back().y == -15.0);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that a batch recalculation of a layout reuses its storage
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(SteadyStateBatchTest) {
+    std::vector<std::shared_ptr<BezierCurve>> curves;
+    for (int c = 0; c < 16; c++) {
+        std::shared_ptr<BezierCurve> curve = std::make_shared<BezierCurve>();
+        curve->SetControlPoint(c * 100.0, 0, 0);
+        curve->SetControlPoint(c * 100.0 + 25, 40, 1);
+        curve->SetControlPoint(c * 100.0 + 75, -40, 2);
+        curve->SetControlPoint(c * 100.0 + 100, 0, 3);
+        curves.push_back(curve);
+    }
+
+    BezierBatch batch;
+    batch.Recalculate(curves);
+
+    std::size_t before = GetAllocationCount();
+    for (int i = 0; i < 10; i++) {
+        for (auto &curve : curves)
+            curve->Move(1.0, 0.5);
+        batch.Recalculate(curves);
+    }
+    std::size_t allocations = GetAllocationCount() - before;
+    BOOST_TEST(allocations == 0U);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that regenerating the ties of a segment reuses the tie buffer
+//!
+//! Bending the segment changes its length so the tie count changes between three
+//! lengths. Once the buffer has grown to the largest count no allocation is made.
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(TieRegenerationTest) {
+    FlexTrackSegment segment;
+    std::shared_ptr<BezierCurve> curve = segment.GetCurve();
+    const Point end = curve->GetControlPoint(3);
+
+    for (int i = 0; i < 3; i++) {
+        curve->SetControlPoint(end.x, end.y + i * 100.0, 3);
+        segment.GetTies();
+    }
+
+    std::size_t before = GetAllocationCount();
+    for (int i = 0; i < 30; i++) {
+        curve->SetControlPoint(end.x, end.y + (i % 3) * 100.0, 3);
+        segment.GetTies();
+    }
+    std::size_t allocations = GetAllocationCount() - before;
+    BOOST_TEST(allocations == 0U);
+
+    // a longer segment needs one bulk allocation for all of its ties
+    curve->SetControlPoint(end.x, end.y + 500.0, 3);
+    before = GetAllocationCount();
+    segment.GetTies();
+    allocations = GetAllocationCount() - before;
+    BOOST_TEST(allocations == 1U);
+}
+
+}
@@ -0,0 +1,97 @@
+//
+// Bezier curves of a fixed degree
+//
+
+#define BOOST_TEST_MODULE BezierCurveTTest
+
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include "BezierCurve.h"
+#include "BezierCurveT.h"
+
+namespace utf = boost::unit_test;
+
+namespace ByteTrail {
+
+    static_assert(Binomial(3, 0) == 1 && Binomial(3, 1) == 3 && Binomial(3, 2) == 3, "cubic binomials");
+    static_assert(Binomial(6, 3) == 20, "binomial of degree 6");
+    static_assert(sizeof(PointT<float>) * 2 == sizeof(PointT<double>), "float points halve the buffers");
+    static_assert(CubicBezier::kControlPoints == 4, "cubic control points");
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates the cubic template against BezierCurve
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(CubicTest, * utf::tolerance(0.000001)) {
+    BezierCurve curve;
+    CubicBezier cubic;
+    const double points[4][2] = {{0, 0}, {100, 20}, {100, 100}, {200, 100}};
+    for (unsigned i = 0; i < 4; i++) {
+        curve.SetControlPoint(points[i][0], points[i][1], i);
+        cubic.SetControlPoint(points[i][0], points[i][1], i);
+    }
+
+    for (double t = 0.0; t <= 1.0; t += 0.125) {
+        BOOST_TEST(cubic.Evaluate(t).x == curve.Evaluate(t).x);
+        BOOST_TEST(cubic.Evaluate(t).y == curve.Evaluate(t).y);
+        BOOST_TEST(cubic.EvaluateDerivative(t).x == curve.EvaluateDerivative(t).x);
+        BOOST_TEST(cubic.EvaluateDerivative(t).y == curve.EvaluateDerivative(t).y);
+    }
+
+    curve.SetResolution(1.0F / 40);
+    cubic.Tessellate(40);
+    BOOST_REQUIRE_EQUAL(cubic.GetCenterline().size(), curve.GetPointCount());
+    for (unsigned i = 0; i < curve.GetPointCount(); i++) {
+        BOOST_TEST(cubic.GetCenterline()[i].x == curve.GetCenterline()[i].x);
+        BOOST_TEST(cubic.GetLeftRail()[i].y == curve.GetLeftRail()[i].y);
+        BOOST_TEST(cubic.GetRightRail()[i].x == curve.GetRightRail()[i].x);
+    }
+    BOOST_TEST(cubic.GetLength() == curve.GetLength());
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates straights and quadratic easements
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(LowerDegreeTest, * utf::tolerance(0.000001)) {
+    LinearBezier straight;
+    straight.SetControlPoint(0, 0, 0);
+    straight.SetControlPoint(30, 40, 1);
+    straight.Tessellate(10);
+    BOOST_TEST(straight.GetLength() == 50.0);
+    BOOST_TEST(straight.Evaluate(0.5).x == 15.0);
+    BOOST_TEST(straight.EvaluateDerivative(0.2).y == 40.0);
+    // rails of a straight are parallel at the rail distance
+    BOOST_TEST(straight.GetLeftRail()[3].x - straight.GetCenterline()[3].x == 4.5 * 40 / 50);
+    BOOST_TEST(straight.GetRightRail()[3].y - straight.GetCenterline()[3].y == 4.5 * 30 / 50);
+
+    // B(t) = (1-t)^2 p0 + 2(1-t)t p1 + t^2 p2
+    QuadraticBezier easement;
+    easement.SetControlPoint(0, 0, 0);
+    easement.SetControlPoint(50, 0, 1);
+    easement.SetControlPoint(100, 50, 2);
+    BOOST_TEST(easement.Evaluate(0.5).x == 50.0);
+    BOOST_TEST(easement.Evaluate(0.5).y == 12.5);
+    BOOST_TEST(easement.EvaluateDerivative(0.0).x == 100.0);
+    BOOST_TEST(easement.EvaluateDerivative(1.0).y == 100.0);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that a float instantiation stays close to the double one
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(FloatTest, * utf::tolerance(0.001)) {
+    BezierCurveT<3, float> single;
+    CubicBezier reference;
+    const double points[4][2] = {{10, 250}, {180, 20}, {400, 300}, {600, 120}};
+    for (unsigned i = 0; i < 4; i++) {
+        single.SetControlPoint(points[i][0], points[i][1], i);
+        reference.SetControlPoint(points[i][0], points[i][1], i);
+    }
+    single.Tessellate(100);
+    reference.Tessellate(100);
+    for (unsigned i = 0; i <= 100; i++) {
+        BOOST_TEST(single.GetCenterline()[i].x == reference.GetCenterline()[i].x);
+        BOOST_TEST(single.GetLeftRail()[i].y == reference.GetLeftRail()[i].y);
+    }
+    BOOST_TEST(single.GetLength() == reference.GetLength());
+}
+
+}
@@ -5,8 +5,10 @@
 #define BOOST_TEST_MODULE BezierTest
 
 #include <boost/test/unit_test.hpp>
+#include <algorithm>
 #include <cmath>
 #include <iostream>
+#include "BezierBatch.h"
 #include "BezierCurve.h"
 
 namespace utf = boost::unit_test;
@@ -68,5 +70,589 @@ BOOST_AUTO_TEST_CASE(ArcDistanceTest, * utf::tolerance(0.001)) {
     BOOST_TEST(len == arc_distance);
 }
 
+//---------------------------------------------------------------------------------------
+//! \brief Validates that reading the rails and the length does not modify the
+//!        centerline and that the views refer to the cached buffers
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(CurveViewTest) {
+    BezierCurve curve;
+    curve.SetControlPoint(0, 0, 0);
+    curve.SetControlPoint(25, 40, 1);
+    curve.SetControlPoint(75, -40, 2);
+    curve.SetControlPoint(100, 0, 3);
+
+    std::vector<Point> centerline = curve.GetCurve(CURVE_CENTERLINE);
+    std::vector<Point> left = curve.GetCurve(CURVE_LEFT_RAIL);
+    std::vector<Point> right = curve.GetCurve(CURVE_RIGHT_RAIL);
+    curve.GetLength();
+
+    PointView centerline_view = curve.GetCenterline();
+    PointView left_view = curve.GetLeftRail();
+    PointView right_view = curve.GetRightRail();
+    BOOST_TEST(centerline_view.data() == curve.GetCurve(CURVE_CENTERLINE).data());
+    BOOST_TEST(left_view.data() == curve.GetCurve(CURVE_LEFT_RAIL).data());
+    BOOST_TEST(right_view.data() == curve.GetCurve(CURVE_RIGHT_RAIL).data());
+
+    BOOST_TEST_REQUIRE(centerline_view.size() == centerline.size());
+    for (size_t i = 0; i < centerline.size(); i++) {
+        BOOST_CHECK(centerline_view[i] == centerline[i]);
+        BOOST_CHECK(left_view[i] == left[i]);
+        BOOST_CHECK(right_view[i] == right[i]);
+        BOOST_CHECK(!(left[i] == centerline[i]));
+    }
+    BOOST_CHECK(centerline_view.front() == curve.GetControlPoint(0));
+    BOOST_CHECK(centerline_view.back() == curve.GetControlPoint(3));
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates the forward differencing engine against the std::pow reference
+//!        evaluation for several control point sets and resolutions
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(ForwardDifferenceTest, * utf::tolerance(0.000001)) {
+    const Point control_points[][4] = {
+            {{0, 0}, {0, 0}, {10, 0}, {10, 0}},
+            {{10, 0}, {10, 5.5228}, {5.5228, 10}, {0, 10}},
+            {{12, 240}, {198, 3}, {-75, 160}, {243, 97}},
+    };
+    const float resolutions[] = {0.025F, 0.0125F, 0.011F, 0.1F};
+
+    for (auto &points : control_points) {
+        for (float resolution : resolutions) {
+            BezierCurve fast;
+            BezierCurve reference;
+            reference.SetEvaluationMode(EVAL_REFERENCE);
+            for (unsigned i = 0; i < 4; i++) {
+                fast.SetControlPoint(points[i], i);
+                reference.SetControlPoint(points[i], i);
+            }
+            fast.SetResolution(resolution);
+            reference.SetResolution(resolution);
+
+            const std::vector<Point> &fast_points = fast.GetCurve(0);
+            const std::vector<Point> &reference_points = reference.GetCurve(0);
+            BOOST_TEST_REQUIRE(fast_points.size() == reference_points.size());
+            for (size_t i = 0; i < fast_points.size(); i++) {
+                BOOST_TEST(fast_points[i].x == reference_points[i].x);
+                BOOST_TEST(fast_points[i].y == reference_points[i].y);
+            }
+            BOOST_TEST(fast.GetLength() == reference.GetLength());
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates every supported batch kernel against curves evaluated one at a time
+//!
+//! Nine curves are used so that the last SSE2 and AVX register is still only partially filled.
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(BatchKernelTest, * utf::tolerance(0.000001)) {
+    const BatchKernel kernels[] = {KERNEL_SCALAR, KERNEL_SSE2, KERNEL_AVX, KERNEL_NEON};
+    const unsigned kCurves = 9;
+
+    std::vector<std::shared_ptr<BezierCurve>> curves;
+    std::srand(42);
+    for (unsigned c = 0; c < kCurves; c++) {
+        std::shared_ptr<BezierCurve> curve = std::make_shared<BezierCurve>();
+        for (unsigned i = 0; i < 4; i++)
+            curve->SetControlPoint(std::rand() % 250, std::rand() % 250, i);
+        curves.push_back(curve);
+    }
+    // handles coinciding with their ends, where the tangent vanishes
+    for (unsigned i = 0; i < 4; i++)
+        curves[7]->SetControlPoint(i < 2 ? 0 : 200, 0, i);
+    curves[8]->SetControlPoint(curves[8]->GetControlPoint(0), 1);
+
+    for (BatchKernel kernel : kernels) {
+        if (!BezierBatch::IsKernelSupported(kernel))
+            continue;
+        BOOST_TEST_MESSAGE("Kernel " << kernel);
+
+        BezierBatch batch;
+        batch.SetKernel(kernel);
+        BOOST_TEST(batch.GetKernel() == kernel);
+        for (auto &curve : curves)
+            batch.Add(*curve);
+        batch.Evaluate();
+        BOOST_TEST_REQUIRE(batch.GetSize() == kCurves);
+
+        for (unsigned c = 0; c < kCurves; c++) {
+            BezierCurve expected = *curves[c];
+            std::vector<Point> points = expected.GetCurve(0);
+            std::vector<Point> left = expected.GetCurve(1);
+            std::vector<Point> right = expected.GetCurve(2);
+            PointView normals = expected.GetNormals();
+            BOOST_TEST_REQUIRE(batch.GetSamples() == points.size());
+
+            for (unsigned i = 0; i < batch.GetSamples(); i++) {
+                BOOST_TEST(batch.GetPoint(c, i).x == points[i].x);
+                BOOST_TEST(batch.GetPoint(c, i).y == points[i].y);
+                BOOST_TEST(batch.GetNormal(c, i).x == normals[i].x);
+                BOOST_TEST(batch.GetNormal(c, i).y == normals[i].y);
+                BOOST_TEST(batch.GetLeftRail(c, i).x == left[i].x);
+                BOOST_TEST(batch.GetLeftRail(c, i).y == left[i].y);
+                BOOST_TEST(batch.GetRightRail(c, i).x == right[i].x);
+                BOOST_TEST(batch.GetRightRail(c, i).y == right[i].y);
+            }
+
+            // the curve gets the same rails and length from the batch
+            BezierCurve stored = *curves[c];
+            batch.Store(c, stored);
+            BOOST_TEST(!stored.IsModified());
+            BOOST_TEST(stored.GetLength() == expected.GetLength());
+            PointView stored_left = stored.GetLeftRail();
+            PointView stored_normals = stored.GetNormals();
+            for (unsigned i = 0; i < batch.GetSamples(); i++) {
+                BOOST_TEST(stored_normals[i].x == normals[i].x);
+                BOOST_TEST(stored_normals[i].y == normals[i].y);
+                BOOST_TEST(stored_left[i].x == left[i].x);
+                BOOST_TEST(stored_left[i].y == left[i].y);
+            }
+        }
+    }
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that a batch recalculation leaves curves up to date
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(BatchRecalculateTest, * utf::tolerance(0.000001)) {
+    std::vector<std::shared_ptr<BezierCurve>> curves;
+    for (unsigned c = 0; c < 5; c++) {
+        std::shared_ptr<BezierCurve> curve = std::make_shared<BezierCurve>();
+        curve->SetControlPoint(c * 10.0, 0, 0);
+        curve->SetControlPoint(c * 10.0 + 3, 4, 1);
+        curve->SetControlPoint(c * 10.0 + 6, -4, 2);
+        curve->SetControlPoint(c * 10.0 + 10, 0, 3);
+        curves.push_back(curve);
+    }
+    curves.back()->SetResolution(0.05F);
+
+    BezierBatch batch;
+    batch.Recalculate(curves);
+
+    for (auto &curve : curves) {
+        BOOST_TEST(!curve->IsModified());
+        BezierCurve expected = *curve;
+        expected.SetEvaluationMode(EVAL_REFERENCE);
+        const std::vector<Point> &actual_points = curve->GetCurve(0);
+        const std::vector<Point> &expected_points = expected.GetCurve(0);
+        BOOST_TEST_REQUIRE(actual_points.size() == expected_points.size());
+        for (size_t i = 0; i < actual_points.size(); i++) {
+            BOOST_TEST(actual_points[i].x == expected_points[i].x);
+            BOOST_TEST(actual_points[i].y == expected_points[i].y);
+        }
+        // the kernel writes the arc lengths along with the points
+        const std::vector<double> &actual_lengths = curve->GetArcLengths();
+        const std::vector<double> &expected_lengths = expected.GetArcLengths();
+        for (size_t i = 0; i < actual_lengths.size(); i++) {
+            BOOST_TEST(actual_lengths[i] == expected_lengths[i]);
+            BOOST_TEST(curve->GetParameters()[i] == expected.GetParameters()[i]);
+        }
+        BOOST_TEST(curve->GetLength() == expected.GetLength());
+    }
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that the two curves at a dragged joint are recalculated by the
+//!        curves themselves, being too few to fill a register of the batch
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(BatchSmallEditTest) {
+    std::vector<std::shared_ptr<BezierCurve>> curves;
+    for (unsigned c = 0; c < 2; c++) {
+        std::shared_ptr<BezierCurve> curve = std::make_shared<BezierCurve>();
+        curve->SetControlPoint(c * 10.0, 0, 0);
+        curve->SetControlPoint(c * 10.0 + 3, 4, 1);
+        curve->SetControlPoint(c * 10.0 + 6, -4, 2);
+        curve->SetControlPoint(c * 10.0 + 10, 0, 3);
+        curves.push_back(curve);
+    }
+    std::vector<BezierCurve> expected;
+    for (auto &curve : curves)
+        expected.push_back(*curve);
+
+    BezierBatch batch;
+    batch.Recalculate(curves);
+
+    for (unsigned c = 0; c < 2; c++) {
+        BOOST_TEST(!curves[c]->IsModified());
+        const std::vector<Point> &actual_points = curves[c]->GetCurve(0);
+        const std::vector<Point> &expected_points = expected[c].GetCurve(0);
+        BOOST_TEST_REQUIRE(actual_points.size() == expected_points.size());
+        for (size_t i = 0; i < actual_points.size(); i++)
+            BOOST_TEST((actual_points[i] == expected_points[i]));
+    }
+}
+
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates point and tangent queries by distance along the curve
+//!
+//! The control points of the straight line are unevenly spaced so that the curve
+//! parameter is not proportional to distance.
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(DistanceQueryTest, * utf::tolerance(0.001)) {
+    BezierCurve curve;
+    curve.SetControlPoint(0, 0, 0);
+    curve.SetControlPoint(1, 0, 1);
+    curve.SetControlPoint(2, 0, 2);
+    curve.SetControlPoint(10, 0, 3);
+
+    BOOST_TEST(curve.GetLength() == 10.0);
+    BOOST_TEST(curve.GetArcLengths().back() == curve.GetLength());
+    BOOST_TEST(curve.GetParameterAtDistance(0.0) == 0.0);
+    BOOST_TEST(curve.GetParameterAtDistance(10.0) == 1.0);
+
+    for (double distance = 0.5; distance < 10.0; distance += 0.5) {
+        Point p = curve.GetPointAtDistance(distance);
+        Point tangent = curve.GetTangentAtDistance(distance);
+        BOOST_TEST(p.x == distance);
+        BOOST_TEST(p.y == 0.0);
+        BOOST_TEST(tangent.x == 1.0);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that arc length sampling spaces the curve points evenly
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(ArcLengthSamplingTest, * utf::tolerance(0.001)) {
+    double ctrl_offset = 10.0 * 4.0 * (std::sqrt(2.0)-1.0) / 3.0;
+    BezierCurve curve;
+    curve.SetControlPoint(0, 0, 0);
+    curve.SetControlPoint(ctrl_offset * 3, 0, 1);
+    curve.SetControlPoint(10, 10 - ctrl_offset, 2);
+    curve.SetControlPoint(10, 10, 3);
+    curve.SetResolution(0.05F);
+    curve.SetSamplingMode(SAMPLE_ARC_LENGTH);
+
+    PointView points = curve.GetCenterline();
+    const std::vector<double> &parameters = curve.GetParameters();
+    BOOST_TEST_REQUIRE(points.size() == 21U);
+    BOOST_CHECK(points.front() == curve.GetControlPoint(0));
+    BOOST_CHECK(points.back() == curve.GetControlPoint(3));
+
+    double spacing = curve.GetLength() / (points.size() - 1);
+    double min_spacing = spacing;
+    double max_spacing = spacing;
+    for (size_t i = 1; i < points.size(); i++) {
+        double d = points[i - 1].Distance(points[i]);
+        min_spacing = std::min(min_spacing, d);
+        max_spacing = std::max(max_spacing, d);
+        BOOST_TEST(parameters[i] > parameters[i - 1]);
+    }
+    BOOST_CHECK(max_spacing / min_spacing < 1.02);
+
+    // the same curve sampled uniformly in t is visibly uneven
+    curve.SetSamplingMode(SAMPLE_UNIFORM);
+    points = curve.GetCenterline();
+    BOOST_CHECK(points[0].Distance(points[1]) / points[10].Distance(points[11]) > 1.1);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates adaptive sampling point counts and the tolerance bound
+//!
+//! A straight line needs a single segment while a tight curve is subdivided until every
+//! segment midpoint is within the tolerance of the curve.
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(AdaptiveSamplingTest) {
+    BezierCurve straight;
+    straight.SetControlPoint(0, 0, 0);
+    straight.SetControlPoint(300, 0, 1);
+    straight.SetControlPoint(600, 0, 2);
+    straight.SetControlPoint(900, 0, 3);
+    straight.SetSamplingMode(SAMPLE_ADAPTIVE);
+    BOOST_TEST(straight.GetPointCount() == 2U);
+    BOOST_TEST(straight.GetLength() == 900.0);
+
+    const double tolerance = 0.05;
+    BezierCurve curve;
+    curve.SetControlPoint(0, 0, 0);
+    curve.SetControlPoint(100, 0, 1);
+    curve.SetControlPoint(100, 100, 2);
+    curve.SetControlPoint(0, 100, 3);
+    curve.SetSamplingMode(SAMPLE_ADAPTIVE);
+    curve.SetTolerance(tolerance);
+
+    PointView points = curve.GetCenterline();
+    const std::vector<double> &parameters = curve.GetParameters();
+    BOOST_TEST(curve.GetPointCount() > 2U);
+    BOOST_TEST(curve.GetPointCount() < 100U);
+    BOOST_TEST_REQUIRE(parameters.size() == points.size());
+    BOOST_TEST(curve.GetCurve(CURVE_LEFT_RAIL).size() == points.size());
+    BOOST_CHECK(points.front() == curve.GetControlPoint(0));
+    BOOST_CHECK(points.back() == curve.GetControlPoint(3));
+    for (size_t i = 1; i < points.size(); i++) {
+        Point chord_middle((points[i - 1].x + points[i].x) / 2, (points[i - 1].y + points[i].y) / 2);
+        Point curve_middle = curve.Evaluate((parameters[i - 1] + parameters[i]) / 2);
+        BOOST_TEST(chord_middle.Distance(curve_middle) <= tolerance);
+    }
+
+    // a looser tolerance needs fewer points
+    unsigned fine_count = curve.GetPointCount();
+    curve.SetTolerance(tolerance * 16);
+    BOOST_TEST(curve.GetPointCount() < fine_count);
+
+    // switching back restores the uniform grid
+    curve.SetSamplingMode(SAMPLE_UNIFORM);
+    BOOST_TEST(curve.GetPointCount() == 41U);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that the bounding box encloses the curve and both rails and
+//!        follows control point edits
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(BoundsTest)
+{
+    BezierCurve curve;
+    curve.SetControlPoint(0, 0, 0);
+    curve.SetControlPoint(100, -50, 1);
+    curve.SetControlPoint(200, 150, 2);
+    curve.SetControlPoint(300, 0, 3);
+
+    const Rect &bounds = curve.GetBounds();
+    BOOST_TEST(bounds.x < 0.0);
+    BOOST_TEST(bounds.y < -50.0);
+    BOOST_TEST(bounds.x + bounds.width > 300.0);
+    BOOST_TEST(bounds.y + bounds.height > 150.0);
+
+    for (unsigned line = CURVE_CENTERLINE; line <= CURVE_RIGHT_RAIL; line++) {
+        for (const Point &p : curve.GetCurve(line)) {
+            BOOST_CHECK(bounds.Contains(p));
+        }
+    }
+
+    Rect before = bounds;
+    curve.Move(10, 20);
+    BOOST_TEST(curve.GetBounds().x == before.x + 10);
+    BOOST_TEST(curve.GetBounds().y == before.y + 20);
+    BOOST_TEST(curve.GetBounds().width == before.width);
+
+    curve.SetControlPoint(1000, 20, 3);
+    BOOST_TEST(curve.GetBounds().x + curve.GetBounds().width > 1000.0);
+    BOOST_CHECK(!curve.GetBounds().Intersects(Rect {1100, 0, 10, 10}));
+    BOOST_CHECK(curve.GetBounds().Intersects(Rect {990, 10, 100, 100}));
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that changing the rail distance only moves the rails
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(ParallelsDistanceTest, * utf::tolerance(0.0001))
+{
+    BezierCurve curve;
+    curve.SetControlPoint(0, 0, 0);
+    curve.SetControlPoint(100, 0, 1);
+    curve.SetControlPoint(200, 0, 2);
+    curve.SetControlPoint(300, 0, 3);
+    curve.Update();
+    unsigned long revision = curve.GetRevision();
+    double width = curve.GetBounds().width;
+
+    curve.SetParallelsDistance(10.0F);
+    BOOST_CHECK(curve.IsModified());
+    BOOST_TEST(curve.GetParallelsDistance() == 10.0F);
+    BOOST_TEST(curve.GetBounds().width > width);
+
+    PointView left = curve.GetLeftRail();
+    PointView right = curve.GetRightRail();
+    PointView center = curve.GetCenterline();
+    BOOST_TEST(curve.GetRevision() == revision + 1);
+    for (size_t i = 0; i < center.size(); i++) {
+        BOOST_TEST(left[i].Distance(center[i]) == 10.0);
+        BOOST_TEST(right[i].Distance(center[i]) == 10.0);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates the cached normals and the lines offset along them
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(OffsetLineTest, * utf::tolerance(0.0001))
+{
+    BezierCurve curve;
+    curve.SetControlPoint(0, 0, 0);
+    curve.SetControlPoint(100, 80, 1);
+    curve.SetControlPoint(200, -80, 2);
+    curve.SetControlPoint(300, 0, 3);
+    BOOST_TEST(curve.GetParallelsDistance() == kTrackGauge / 2.0F);
+
+    PointView center = curve.GetCenterline();
+    PointView normals = curve.GetNormals();
+    PointView left = curve.GetLeftRail();
+    const std::vector<Point> &tangents = curve.GetTangentPoints();
+    BOOST_TEST_REQUIRE(normals.size() == center.size());
+    for (size_t i = 0; i < normals.size(); i++) {
+        BOOST_TEST(normals[i].x * normals[i].x + normals[i].y * normals[i].y == 1.0);
+        BOOST_TEST(normals[i].x * tangents[i].x + normals[i].y * tangents[i].y == 0.0);
+    }
+
+    // the rails are offset lines like any other
+    std::vector<Point> line;
+    curve.GetOffsetLine(kTrackGauge / 2.0, line);
+    BOOST_TEST_REQUIRE(line.size() == left.size());
+    for (size_t i = 0; i < line.size(); i++) {
+        BOOST_TEST(line[i].x == left[i].x);
+        BOOST_TEST(line[i].y == left[i].y);
+    }
+
+    // a second track to the right, reusing the storage of the first line
+    const Point *storage = line.data();
+    curve.GetOffsetLine(-kDoubleTrackSpacing, line);
+    BOOST_CHECK(line.data() == storage);
+    for (size_t i = 0; i < line.size(); i++)
+        BOOST_TEST(line[i].Distance(center[i]) == kDoubleTrackSpacing);
+
+    // normals between the samples are interpolated and stay unit length
+    const std::vector<double> &lengths = curve.GetArcLengths();
+    for (size_t i = 0; i + 1 < lengths.size(); i++) {
+        Point at = curve.GetNormalAtDistance(lengths[i]);
+        BOOST_TEST(at.x == normals[i].x);
+        BOOST_TEST(at.y == normals[i].y);
+        Point between = curve.GetNormalAtDistance((lengths[i] + lengths[i + 1]) / 2.0);
+        BOOST_TEST(between.x * between.x + between.y * between.y == 1.0);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates the rails where a handle coincides with its end and the tangent
+//!        vanishes
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(CoincidentHandleTest, * utf::tolerance(0.0001))
+{
+    BezierCurve curve;
+    curve.SetControlPoint(0, 0, 0);
+    curve.SetControlPoint(0, 0, 1);
+    curve.SetControlPoint(200, 0, 2);
+    curve.SetControlPoint(200, 0, 3);
+    const double distance = curve.GetParallelsDistance();
+
+    const SamplingMode modes[] = {SAMPLE_UNIFORM, SAMPLE_ARC_LENGTH, SAMPLE_ADAPTIVE};
+    for (SamplingMode mode : modes) {
+        BOOST_TEST_MESSAGE("Sampling mode " << mode);
+        curve.SetSamplingMode(mode);
+        PointView center = curve.GetCenterline();
+        PointView normals = curve.GetNormals();
+        PointView left = curve.GetLeftRail();
+        PointView right = curve.GetRightRail();
+        BOOST_TEST(curve.GetTangentPoints().front().x == 0.0);
+        BOOST_TEST(curve.GetTangentPoints().back().x == 0.0);
+        for (size_t i = 0; i < center.size(); i++) {
+            BOOST_TEST(normals[i].x == 0.0);
+            BOOST_TEST(normals[i].y == -1.0);
+            BOOST_TEST(left[i].x == center[i].x);
+            BOOST_TEST(left[i].Distance(center[i]) == distance);
+            BOOST_TEST(right[i].Distance(left[i]) == 2.0 * distance);
+        }
+    }
+
+    // the queries along the curve take the same limit
+    BOOST_TEST(curve.GetTangentAtDistance(0.0).x == 1.0);
+    BOOST_TEST(curve.GetTangentAtDistance(curve.GetLength()).x == 1.0);
+    BOOST_TEST(curve.GetNormalAtDistance(0.0).y == -1.0);
+    BOOST_TEST(curve.GetNormalAtDistance(0.5).y == -1.0);
+    BOOST_TEST(curve.GetNormalAtDistance(curve.GetLength()).y == -1.0);
+
+    // all of the curve on one point has no direction at all
+    curve.SetControlPoint(50, 50, 0);
+    curve.SetControlPoint(50, 50, 1);
+    curve.SetControlPoint(50, 50, 2);
+    curve.SetControlPoint(50, 50, 3);
+    for (const Point &normal : curve.GetNormals()) {
+        BOOST_TEST(normal.x == 0.0);
+        BOOST_TEST(normal.y == 0.0);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates the minimum radius where the speed of the curve is zero
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(ZeroSpeedRadiusTest)
+{
+    // straights never turn, with handles on their ends or doubling back
+    BezierCurve curve;
+    curve.SetControlPoint(0, 0, 0);
+    curve.SetControlPoint(0, 0, 1);
+    curve.SetControlPoint(200, 0, 2);
+    curve.SetControlPoint(200, 0, 3);
+    BOOST_CHECK(std::isinf(curve.GetMinimumRadius()));
+    BOOST_CHECK(curve.GetMinimumRadius() > kMinimumRadius);
+    curve.SetControlPoint(0, 0, 1);
+    curve.SetControlPoint(0, 0, 2);
+    BOOST_CHECK(std::isinf(curve.GetMinimumRadius()));
+    curve.SetControlPoint(300, 0, 1);
+    curve.SetControlPoint(-100, 0, 2);
+    BOOST_CHECK(std::isinf(curve.GetMinimumRadius()));
+    // a diagonal straight whose coordinates do not multiply exactly
+    curve.SetControlPoint(0.1, 0.3, 0);
+    curve.SetControlPoint(0.1, 0.3, 1);
+    curve.SetControlPoint(70.1, 210.3, 2);
+    curve.SetControlPoint(100.1, 300.3, 3);
+    BOOST_CHECK(std::isinf(curve.GetMinimumRadius()));
+
+    // a bend starting from rest has unbounded curvature at that end
+    curve.SetControlPoint(0, 0, 0);
+    curve.SetControlPoint(0, 0, 1);
+    curve.SetControlPoint(100, 80, 2);
+    curve.SetControlPoint(200, 0, 3);
+    BOOST_CHECK_EQUAL(curve.GetMinimumRadius(), 0.0);
+
+    // the handles crossed over make a cusp half way
+    curve.SetControlPoint(200, 100, 1);
+    curve.SetControlPoint(0, 100, 2);
+    BOOST_CHECK(curve.GetMinimumRadius() < 0.01);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates the cached bounds, length and radius and the closest point query
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(PropertyCacheTest, * utf::tolerance(0.0001))
+{
+    // a quarter circle of radius 200 centered on the origin
+    const double kappa = 0.5522847498;
+    BezierCurve curve;
+    curve.SetControlPoint(200, 0, 0);
+    curve.SetControlPoint(200, 200 * kappa, 1);
+    curve.SetControlPoint(200 * kappa, 200, 2);
+    curve.SetControlPoint(0, 200, 3);
+
+    const double distance = curve.GetParallelsDistance();
+    const Rect &bounds = curve.GetTightBounds();
+    BOOST_TEST(bounds.x == -distance);
+    BOOST_TEST(bounds.y == -distance);
+    BOOST_TEST(bounds.width == 200.0 + 2.0 * distance);
+    BOOST_TEST(bounds.height == 200.0 + 2.0 * distance);
+
+    BOOST_CHECK_CLOSE(curve.GetExactLength(), 100.0 * M_PI, 0.05);
+    BOOST_CHECK(curve.GetExactLength() > curve.GetLength());
+    // the cubic bends slightly tighter than the circle a fifth of the way along
+    BOOST_CHECK_CLOSE(curve.GetMinimumRadius(), 198.4117, 0.001);
+    BOOST_CHECK(curve.GetMinimumRadius() > kMinimumRadius / 2.0);
+
+    // the closest point lies on the line through the center
+    Point closest = curve.GetClosestPoint(Point(300, 300));
+    BOOST_CHECK_CLOSE(closest.x, closest.y, 0.1);
+    BOOST_CHECK_CLOSE(closest.Distance(Point(0, 0)), 200.0, 0.1);
+    double t = curve.GetClosestParameter(Point(200, -50));
+    BOOST_TEST(t == 0.0);
+
+    // long handles leave the control point box loose but not the tight one
+    curve.SetControlPoint(0, 0, 0);
+    curve.SetControlPoint(100, 300, 1);
+    curve.SetControlPoint(200, -300, 2);
+    curve.SetControlPoint(300, 0, 3);
+    const Rect &tight = curve.GetTightBounds();
+    BOOST_CHECK(tight.height < curve.GetBounds().height / 2.0);
+    double top = 0.0;
+    for (unsigned i = 0; i <= 1000; i++)
+        top = std::max(top, curve.Evaluate(i / 1000.0).y);
+    BOOST_CHECK_CLOSE(tight.y + tight.height, top + distance, 0.001);
+    for (const Point &p : curve.GetLeftRail())
+        BOOST_CHECK(tight.Contains(p));
+
+    // a straight curve never turns
+    curve.SetControlPoint(0, 0, 0);
+    curve.SetControlPoint(100, 0, 1);
+    curve.SetControlPoint(200, 0, 2);
+    curve.SetControlPoint(300, 0, 3);
+    BOOST_TEST(curve.GetExactLength() == 300.0);
+    BOOST_CHECK(std::isinf(curve.GetMinimumRadius()));
+    BOOST_TEST(curve.GetClosestPoint(Point(123.4, 50)).x == 123.4);
+}
 
 }
@@ -0,0 +1,188 @@
+//
+// Crossings and clearance between the segments of a layout
+//
+
+#define BOOST_TEST_MODULE ClearanceCheckerTest
+
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+#include "BezierCurve.h"
+#include "ClearanceChecker.h"
+#include "TrackGraph.h"
+
+namespace utf = boost::unit_test;
+
+namespace ByteTrail {
+
+    //! straight segment with its handles at the thirds
+    static unsigned AddStraight(TrackGraph &graph, const Point &from, const Point &to) {
+        std::shared_ptr<BezierCurve> curve = std::make_shared<BezierCurve>();
+        curve->SetControlPoint(from.x, from.y, 0);
+        curve->SetControlPoint(from.x + (to.x - from.x) / 3.0, from.y + (to.y - from.y) / 3.0, 1);
+        curve->SetControlPoint(from.x + 2.0 * (to.x - from.x) / 3.0, from.y + 2.0 * (to.y - from.y) / 3.0, 2);
+        curve->SetControlPoint(to.x, to.y, 3);
+        return graph.AddSegment(curve);
+    }
+
+    //! smallest distance between the sampled centerlines of two curves
+    static double GetSampledDistance(const BezierCurve &a, const BezierCurve &b) {
+        double distance = INFINITY;
+        for (unsigned i = 0; i <= 400; i++) {
+            const Point p = a.Evaluate(i / 400.0);
+            for (unsigned j = 0; j <= 400; j++)
+                distance = std::min(distance, p.Distance(b.Evaluate(j / 400.0)));
+        }
+        return distance;
+    }
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates finding crossings and parallel tracks too close to each other
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(ConflictTest, * utf::tolerance(1e-3)) {
+    TrackGraph graph;
+    AddStraight(graph, Point(0, 0), Point(300, 0));
+    AddStraight(graph, Point(0, 20), Point(300, 20));
+    AddStraight(graph, Point(0, 60), Point(300, 60));
+    AddStraight(graph, Point(100, -100), Point(200, 200));
+
+    ClearanceChecker checker;
+    BOOST_CHECK_EQUAL(checker.GetClearance(), kDoubleTrackSpacing);
+    checker.Update(graph);
+
+    std::vector<ClearanceChecker::Conflict> conflicts;
+    checker.GetConflicts(conflicts);
+    BOOST_REQUIRE_EQUAL(conflicts.size(), 4);
+    BOOST_CHECK_EQUAL(checker.GetConflictCount(), 4);
+
+    // the two tracks 20 apart, 60 is far enough
+    BOOST_CHECK_EQUAL(conflicts[0].first, 0);
+    BOOST_CHECK_EQUAL(conflicts[0].second, 1);
+    BOOST_CHECK_EQUAL(conflicts[0].kind, ClearanceChecker::CONFLICT_CLEARANCE);
+    BOOST_TEST(conflicts[0].distance == 20.0);
+    BOOST_TEST(conflicts[0].location.y == 10.0);
+
+    // the diagonal crosses all three
+    for (unsigned i = 1; i < 4; i++) {
+        BOOST_CHECK_EQUAL(conflicts[i].first, i - 1);
+        BOOST_CHECK_EQUAL(conflicts[i].second, 3);
+        BOOST_CHECK_EQUAL(conflicts[i].kind, ClearanceChecker::CONFLICT_CROSSING);
+        BOOST_TEST(conflicts[i].distance == 0.0);
+    }
+    BOOST_TEST(conflicts[3].location.x == 100.0 + 160.0 / 3.0);
+    BOOST_TEST(conflicts[3].location.y == 60.0);
+    BOOST_CHECK_EQUAL(checker.GetConflicts(2).size(), 1);
+    BOOST_CHECK_EQUAL(checker.GetConflicts(3).size(), 3);
+    BOOST_CHECK(checker.GetConflicts(7).empty());
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that joined segments only conflict away from their joint
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(JointTest) {
+    TrackGraph graph;
+    // a chain of s bends, joined end to start
+    for (unsigned i = 0; i < 4; i++) {
+        std::shared_ptr<BezierCurve> curve = std::make_shared<BezierCurve>();
+        curve->SetControlPoint(300.0 * i, 0, 0);
+        curve->SetControlPoint(300.0 * i + 100, 40, 1);
+        curve->SetControlPoint(300.0 * i + 200, -40, 2);
+        curve->SetControlPoint(300.0 * i + 300, 0, 3);
+        const unsigned segment = graph.AddSegment(curve);
+        if (segment > 0)
+            graph.Connect(segment - 1, TrackGraph::END_FINISH, segment, TrackGraph::END_START);
+    }
+
+    ClearanceChecker checker;
+    checker.Update(graph);
+    BOOST_CHECK_EQUAL(checker.GetConflictCount(), 0);
+
+    // the last segment folds back along the first, which it is not joined to
+    graph.MoveControlPoint(3, 3, Point(0, 25));
+    for (const TrackGraph::Touch &touch : graph.GetTouched())
+        checker.Update(graph, touch.segment);
+    bool folded = false;
+    for (const ClearanceChecker::Conflict &conflict : checker.GetConflicts(3))
+        folded = folded || conflict.first == 0;
+    BOOST_CHECK(folded);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that moving a segment re-checks its neighbors
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(UpdateTest) {
+    TrackGraph graph;
+    for (unsigned i = 0; i < 10; i++)
+        AddStraight(graph, Point(0, 100.0 * i), Point(300, 100.0 * i));
+
+    ClearanceChecker checker;
+    checker.Update(graph);
+    BOOST_CHECK_EQUAL(checker.GetConflictCount(), 0);
+
+    // drag segment 5 next to segment 2
+    std::shared_ptr<BezierCurve> curve = graph.GetCurve(5);
+    for (unsigned i = 0; i < 4; i++)
+        curve->SetControlPoint(100.0 * i, 225, i);
+    checker.Update(graph, 5);
+    BOOST_REQUIRE_EQUAL(checker.GetConflictCount(), 1);
+    BOOST_CHECK_EQUAL(checker.GetConflicts(2).size(), 1);
+    BOOST_CHECK_EQUAL(checker.GetConflicts(5)[0].first, 2);
+    BOOST_CHECK_CLOSE(checker.GetConflicts(5)[0].distance, 25.0, 1e-6);
+
+    // and on to segment 7
+    for (unsigned i = 0; i < 4; i++)
+        curve->SetControlPoint(100.0 * i, 690, i);
+    checker.Update(graph, 5);
+    BOOST_REQUIRE_EQUAL(checker.GetConflictCount(), 1);
+    BOOST_CHECK(checker.GetConflicts(2).empty());
+    BOOST_CHECK_EQUAL(checker.GetConflicts(5)[0].second, 7);
+
+    checker.Remove(7);
+    BOOST_CHECK_EQUAL(checker.GetConflictCount(), 0);
+    BOOST_CHECK(checker.GetConflicts(5).empty());
+
+    // a wider clearance takes effect once checked again
+    checker.SetClearance(150.0);
+    checker.Update(graph);
+    BOOST_CHECK_EQUAL(checker.GetConflictCount(), 10);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates the narrow phase against sampling both curves
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(DistanceTest) {
+    std::mt19937 random(27);
+    std::uniform_real_distribution<double> coordinate(0.0, 200.0);
+    const std::vector<Point> joints;
+    unsigned checked = 0;
+
+    for (unsigned n = 0; n < 50; n++) {
+        BezierCurve a;
+        BezierCurve b;
+        for (int i = 0; i < 4; i++) {
+            a.SetControlPoint(coordinate(random), coordinate(random), i);
+            b.SetControlPoint(coordinate(random) + 100.0, coordinate(random), i);
+        }
+        const double sampled = GetSampledDistance(a, b);
+        ClearanceChecker::Conflict conflict;
+        const bool found = ClearanceChecker::Check(a, b, 40.0, joints, conflict);
+        if (sampled > 41.0)
+            BOOST_CHECK(!found);
+        if (!found)
+            continue;
+
+        ++checked;
+        if (conflict.kind == ClearanceChecker::CONFLICT_CROSSING) {
+            BOOST_CHECK(sampled < 2.0);
+        } else {
+            BOOST_CHECK(sampled > 0.0);
+            BOOST_CHECK(std::abs(conflict.distance - sampled) < 2.0 * ClearanceChecker::kFlatness + 0.5);
+        }
+    }
+    BOOST_CHECK(checked > 10);
+}
+
+}
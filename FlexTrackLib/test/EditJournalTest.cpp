@@ -0,0 +1,169 @@
+//
+// Undo and redo of control point edits
+//
+
+#define BOOST_TEST_MODULE EditJournalTest
+
+#include <boost/test/unit_test.hpp>
+#include <memory>
+#include <vector>
+#include "BezierCurve.h"
+#include "EditJournal.h"
+#include "TrackGraph.h"
+
+namespace ByteTrail {
+
+    //! chain of s bends joined end to start
+    static void BuildChain(TrackGraph &graph, unsigned count, float resolution) {
+        for (unsigned i = 0; i < count; i++) {
+            std::shared_ptr<BezierCurve> curve = std::make_shared<BezierCurve>();
+            curve->SetResolution(resolution);
+            curve->SetControlPoint(300.0 * i, 0, 0);
+            curve->SetControlPoint(300.0 * i + 100, 40, 1);
+            curve->SetControlPoint(300.0 * i + 200, -40, 2);
+            curve->SetControlPoint(300.0 * i + 300, 0, 3);
+            curve->Update();
+            const unsigned segment = graph.AddSegment(curve);
+            if (segment > 0)
+                graph.Connect(segment - 1, TrackGraph::END_FINISH, segment, TrackGraph::END_START);
+        }
+    }
+
+    static std::vector<Point> GetControlPoints(const TrackGraph &graph) {
+        std::vector<Point> points;
+        for (unsigned segment = 0; segment < graph.GetSegmentCount(); segment++) {
+            for (unsigned i = 0; i < 4; i++)
+                points.push_back(graph.GetCurve(segment)->GetControlPoint(i));
+        }
+        return points;
+    }
+
+    //! drags a control point through a number of motion events as one step
+    static void Drag(EditJournal &journal, TrackGraph &graph, unsigned segment, unsigned index,
+                     double dx, double dy, unsigned events) {
+        const Point start = graph.GetCurve(segment)->GetControlPoint(index);
+        journal.BeginStep();
+        for (unsigned i = 1; i <= events; i++) {
+            graph.MoveControlPoint(segment, index, Point(start.x + dx * i / events, start.y + dy * i / events));
+            journal.Record(graph);
+        }
+        journal.EndStep(graph);
+    }
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that a drag is undone and redone exactly, as one step
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(UndoTest) {
+    TrackGraph graph;
+    BuildChain(graph, 5, 0.025F);
+    EditJournal journal;
+    const std::vector<Point> before = GetControlPoints(graph);
+    BOOST_CHECK(!journal.CanUndo());
+
+    // the end point drags its handle and the neighbor joined to it along
+    Drag(journal, graph, 2, 3, 37.5, -12.25, 50);
+    const std::vector<Point> after = GetControlPoints(graph);
+    BOOST_CHECK_EQUAL(journal.GetStepCount(), 1);
+    BOOST_CHECK(journal.GetChangeCount() >= 2);
+    BOOST_CHECK(journal.GetChangeCount() <= 8);
+    for (unsigned segment = 0; segment < graph.GetSegmentCount(); segment++)
+        graph.GetCurve(segment)->Update();
+
+    BOOST_REQUIRE(journal.Undo(graph));
+    BOOST_CHECK(GetControlPoints(graph) == before);
+    BOOST_CHECK(!journal.CanUndo());
+    BOOST_CHECK(journal.CanRedo());
+
+    // only the segments of the step need to be recalculated
+    std::vector<unsigned> replayed;
+    for (const TrackGraph::Touch &touch : journal.GetReplayed())
+        replayed.push_back(touch.segment);
+    BOOST_CHECK_EQUAL(replayed.size(), 2);
+    for (unsigned segment = 0; segment < graph.GetSegmentCount(); segment++) {
+        const bool touched = segment == 2 || segment == 3;
+        BOOST_CHECK_EQUAL(graph.GetCurve(segment)->IsModified(), touched);
+    }
+
+    BOOST_REQUIRE(journal.Redo(graph));
+    BOOST_CHECK(GetControlPoints(graph) == after);
+    BOOST_CHECK(!journal.Redo(graph));
+
+    // an empty drag is not a step
+    journal.BeginStep();
+    BOOST_CHECK(!journal.CanUndo());
+    BOOST_CHECK(!journal.EndStep(graph));
+    BOOST_CHECK_EQUAL(journal.GetStepCount(), 1);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that a step costs the same whatever the number of samples
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(SizeTest) {
+    BOOST_CHECK(sizeof(EditJournal::Change) + sizeof(EditJournal::Step) <= 64);
+
+    unsigned changes[2];
+    const float resolutions[2] = {0.1F, 0.001F};
+    for (unsigned i = 0; i < 2; i++) {
+        TrackGraph graph;
+        BuildChain(graph, 3, resolutions[i]);
+        EditJournal journal;
+        Drag(journal, graph, 0, 1, 10.0, 10.0, 20);
+        changes[i] = journal.GetChangeCount();
+    }
+    // a handle at an open end moves by itself
+    BOOST_CHECK_EQUAL(changes[0], 1);
+    BOOST_CHECK_EQUAL(changes[1], changes[0]);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates dropping the oldest steps and the steps undone
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(RingTest) {
+    TrackGraph graph;
+    BuildChain(graph, 3, 0.025F);
+    EditJournal journal(4);
+    BOOST_CHECK_EQUAL(journal.GetCapacity(), 4);
+
+    std::vector<std::vector<Point>> states;
+    states.push_back(GetControlPoints(graph));
+    for (unsigned i = 0; i < 6; i++) {
+        // handles at the open ends of the chain
+        if (i % 2 == 0)
+            Drag(journal, graph, 0, 1, 5.0, 0.0, 3);
+        else
+            Drag(journal, graph, 2, 2, 5.0, 0.0, 3);
+        states.push_back(GetControlPoints(graph));
+    }
+    // one change per step, the four latest are kept
+    BOOST_CHECK_EQUAL(journal.GetStepCount(), 4);
+    BOOST_CHECK_EQUAL(journal.GetChangeCount(), 4);
+    unsigned undone = 0;
+    while (journal.Undo(graph))
+        BOOST_CHECK(GetControlPoints(graph) == states[6 - ++undone]);
+    BOOST_CHECK_EQUAL(undone, 4);
+
+    // a new step replaces the steps undone, the handle at a joint turns the
+    // handle across it as well
+    journal.Redo(graph);
+    Drag(journal, graph, 0, 2, 0.0, 5.0, 3);
+    BOOST_CHECK_EQUAL(journal.GetStepCount(), 2);
+    BOOST_CHECK(!journal.CanRedo());
+    BOOST_CHECK(journal.Undo(graph));
+    BOOST_CHECK(GetControlPoints(graph) == states[3]);
+    BOOST_CHECK(journal.Undo(graph));
+    BOOST_CHECK(GetControlPoints(graph) == states[2]);
+    BOOST_CHECK(!journal.Undo(graph));
+
+    // a step larger than the whole ring drops the history
+    EditJournal small(1);
+    Drag(small, graph, 0, 1, 5.0, 0.0, 3);
+    BOOST_CHECK_EQUAL(small.GetStepCount(), 1);
+    small.BeginStep();
+    graph.MoveControlPoint(0, 2, Point(150.0, 0.0));
+    small.Record(graph);
+    BOOST_CHECK(!small.EndStep(graph));
+    BOOST_CHECK_EQUAL(small.GetStepCount(), 0);
+    BOOST_CHECK(!small.CanUndo());
+}
+
+}
@@ -0,0 +1,87 @@
+//
+// Tie generation for flex track segments
+//
+
+#define BOOST_TEST_MODULE FlexTrackSegmentTest
+
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <memory>
+#include "FlexTrackSegment.h"
+#include "NScale.h"
+
+namespace utf = boost::unit_test;
+
+namespace ByteTrail {
+
+    static Point GetCenter(const Quad &quad) {
+        Point center(0, 0);
+        for (const Point &corner : quad.corners) {
+            center.x += corner.x / 4.0;
+            center.y += corner.y / 4.0;
+        }
+        return center;
+    }
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates the tie count, spacing and dimensions of a straight segment
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(StraightTiesTest, * utf::tolerance(0.0001)) {
+    FlexTrackSegment segment;
+
+    const std::vector<Quad> &ties = segment.GetTies();
+    BOOST_TEST(ties.size() == 288U);
+    BOOST_TEST(segment.GetTieCount() == ties.size());
+    BOOST_TEST(segment.GetTieData() == ties.data());
+
+    BOOST_TEST(GetCenter(ties.front()).x == kAverageTieSpacing / 2.0);
+    for (size_t i = 1; i < ties.size(); i++) {
+        BOOST_TEST(GetCenter(ties[i - 1]).Distance(GetCenter(ties[i])) == kAverageTieSpacing);
+    }
+
+    // perimeter order: leading edge, then trailing edge in reverse
+    const Quad &tie = ties[10];
+    BOOST_TEST(tie.corners[0].Distance(tie.corners[1]) == kAverageTieLength);
+    BOOST_TEST(tie.corners[1].Distance(tie.corners[2]) == kAverageTieWidth);
+    BOOST_TEST(tie.corners[2].Distance(tie.corners[3]) == kAverageTieLength);
+    BOOST_TEST(tie.corners[3].Distance(tie.corners[0]) == kAverageTieWidth);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that the ties follow the curve when it is edited
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(RegenerateTiesTest, * utf::tolerance(0.0001)) {
+    FlexTrackSegment segment;
+    const Quad *before = segment.GetTieData();
+    BOOST_TEST(GetCenter(segment.GetTies().front()).y == 0.0);
+
+    segment.GetCurve()->Move(0, 50);
+    const std::vector<Quad> &ties = segment.GetTies();
+    BOOST_TEST(ties.data() == before);
+    for (const Quad &tie : ties) {
+        BOOST_TEST(GetCenter(tie).y == 50.0);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that the ties keep their size where the handles coincide with
+//!        the ends of the segment
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(CoincidentHandleTiesTest, * utf::tolerance(0.0001)) {
+    FlexTrackSegment segment;
+    std::shared_ptr<BezierCurve> curve = segment.GetCurve();
+    curve->SetControlPoint(0, 0, 0);
+    curve->SetControlPoint(0, 0, 1);
+    curve->SetControlPoint(200, 0, 2);
+    curve->SetControlPoint(200, 0, 3);
+
+    const std::vector<Quad> &ties = segment.GetTies();
+    BOOST_TEST_REQUIRE(ties.size() == 63U);
+    for (const Quad &tie : ties) {
+        BOOST_TEST(tie.corners[0].Distance(tie.corners[1]) == kAverageTieLength);
+        BOOST_TEST(tie.corners[1].Distance(tie.corners[2]) == kAverageTieWidth);
+        BOOST_TEST(GetCenter(tie).y == 0.0);
+    }
+}
+
+}
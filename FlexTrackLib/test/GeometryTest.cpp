@@ -69,4 +69,63 @@ BOOST_AUTO_TEST_CASE(SlopeTest) {
 
     pt_b = {2, -2};
     BOOST_CHECK_EQUAL(-1.0, pt_a.Slope(pt_b));
-}
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates the element sequence of a polygon
+//!
+//! A polygon is a move to the first point, a line to each following point and a close
+//! back to the first point.
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(PolygonPathTest) {
+    ByteTrail::Polygon polygon;
+    BOOST_CHECK_EQUAL(0, polygon.GetSize());
+
+    BOOST_CHECK_EQUAL(0, polygon.Add({10, 10}));
+    BOOST_CHECK_EQUAL(1, polygon.Add({100, 10}));
+    BOOST_CHECK_EQUAL(2, polygon.Add({100, 50}));
+    BOOST_CHECK_EQUAL(3, polygon.GetSize());
+
+    const ByteTrail::SegmentType expected_types[] = {
+            ByteTrail::SEG_MOVE_TO, ByteTrail::SEG_LINE_TO, ByteTrail::SEG_LINE_TO, ByteTrail::SEG_CLOSE};
+    const ByteTrail::Point expected_points[] = {{10, 10}, {100, 10}, {100, 50}, {10, 10}};
+
+    const ByteTrail::FlatPath & path = polygon.GetPath();
+    BOOST_CHECK_EQUAL(4U, path.GetSize());
+    int idx = 0;
+    for(auto seg : path) {
+        BOOST_CHECK_EQUAL(expected_types[idx], seg.type);
+        BOOST_CHECK(expected_points[idx] == *seg.point);
+        idx++;
+    }
+    BOOST_CHECK_EQUAL(4, idx);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that a flat path keeps its storage when cleared and that sub paths
+//!        close to their own start point
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(FlatPathReuseTest) {
+    ByteTrail::FlatPath path;
+    path.Reserve(10);
+    const ByteTrail::Point * storage = path.GetPoints();
+
+    for(int pass = 0; pass < 3; pass++) {
+        path.Clear();
+        BOOST_CHECK(path.IsEmpty());
+        path.MoveTo(0, 0);
+        path.LineTo(1, 0);
+        path.Close();
+        path.MoveTo(5, 5);
+        path.LineTo(6, 5);
+        path.LineTo(6, 6);
+        path.Close();
+        BOOST_CHECK_EQUAL(7U, path.GetSize());
+        BOOST_CHECK(storage == path.GetPoints());
+    }
+
+    BOOST_CHECK_EQUAL(ByteTrail::SEG_CLOSE, path.GetType(2));
+    BOOST_CHECK(ByteTrail::Point(0, 0) == path.GetPoint(2));
+    BOOST_CHECK_EQUAL(ByteTrail::SEG_CLOSE, path.GetType(6));
+    BOOST_CHECK(ByteTrail::Point(5, 5) == path.GetPoint(6));
+}
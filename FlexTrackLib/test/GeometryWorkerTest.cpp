@@ -0,0 +1,109 @@
+//
+// Background recalculation into curve snapshots
+//
+
+#define BOOST_TEST_MODULE GeometryWorkerTest
+
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include "BezierCurve.h"
+#include "GeometryWorker.h"
+#include "TaskPool.h"
+
+namespace ByteTrail {
+
+    static void SetCurve(BezierCurve &curve, double x, double y) {
+        curve.SetControlPoint(x, y, 0);
+        curve.SetControlPoint(x + 100, y + 20, 1);
+        curve.SetControlPoint(x + 100, y + 100, 2);
+        curve.SetControlPoint(x + 200, y + 100, 3);
+    }
+
+    static void CheckCurve(BezierCurve &curve, double x, double y) {
+        BezierCurve expected;
+        SetCurve(expected, x, y);
+        BOOST_CHECK(!curve.IsModified());
+        BOOST_REQUIRE_EQUAL(curve.GetPointCount(), expected.GetPointCount());
+        for (unsigned i = 0; i < expected.GetPointCount(); i++) {
+            BOOST_REQUIRE_EQUAL(curve.GetCenterline()[i].x, expected.GetCenterline()[i].x);
+            BOOST_REQUIRE_EQUAL(curve.GetLeftRail()[i].y, expected.GetLeftRail()[i].y);
+        }
+    }
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that posted curves are recalculated into a new snapshot that
+//!        shares the unchanged curves and leaves earlier snapshots alone
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(SnapshotTest) {
+    TaskPool pool(1);
+    std::atomic<unsigned> published(0);
+    GeometryWorker worker(pool, [&published]() { ++published; });
+    BOOST_CHECK(worker.GetSnapshot()->curves.empty());
+
+    BezierCurve curve;
+    worker.Resize(3);
+    for (unsigned i = 0; i < 3; i++) {
+        SetCurve(curve, 10.0 * i, 0);
+        worker.Post(i, curve);
+    }
+    worker.Wait();
+    BOOST_CHECK(published > 0);
+
+    std::shared_ptr<const GeometryWorker::Snapshot> first = worker.GetSnapshot();
+    BOOST_REQUIRE_EQUAL(first->curves.size(), 3);
+    for (unsigned i = 0; i < 3; i++)
+        CheckCurve(*first->curves[i], 10.0 * i, 0);
+
+    // the posted copy is unaffected by later edits of the original
+    SetCurve(curve, 50, 50);
+    worker.Post(1, curve);
+    curve.Move(1000, 0);
+    worker.Wait();
+
+    std::shared_ptr<const GeometryWorker::Snapshot> second = worker.GetSnapshot();
+    BOOST_CHECK(second->generation > first->generation);
+    BOOST_CHECK(second->curves[0] == first->curves[0]);
+    BOOST_CHECK(second->curves[1] != first->curves[1]);
+    BOOST_CHECK(second->curves[2] == first->curves[2]);
+    CheckCurve(*second->curves[1], 50, 50);
+    CheckCurve(*first->curves[1], 10, 0);
+
+    // edits of curves past the end are dropped
+    worker.Post(2, curve);
+    worker.Resize(2);
+    worker.Wait();
+    BOOST_REQUIRE_EQUAL(worker.GetSnapshot()->curves.size(), 2);
+    BOOST_CHECK(worker.GetSnapshot()->curves[1] == second->curves[1]);
+
+    worker.Resize(4);
+    worker.Wait();
+    BOOST_REQUIRE_EQUAL(worker.GetSnapshot()->curves.size(), 4);
+    BOOST_CHECK(!worker.GetSnapshot()->curves[3]->IsModified());
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that a burst of edits of many curves ends in a snapshot with the
+//!        last edit of each
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(BurstTest) {
+    TaskPool pool(2);
+    GeometryWorker worker(pool);
+    const unsigned count = 200;
+    worker.Resize(count);
+
+    BezierCurve curve;
+    for (unsigned step = 0; step < 5; step++) {
+        for (unsigned i = 0; i < count; i++) {
+            SetCurve(curve, i, step);
+            worker.Post(i, curve);
+        }
+    }
+    worker.Wait();
+
+    std::shared_ptr<const GeometryWorker::Snapshot> snapshot = worker.GetSnapshot();
+    BOOST_REQUIRE_EQUAL(snapshot->curves.size(), count);
+    for (unsigned i = 0; i < count; i++)
+        CheckCurve(*snapshot->curves[i], i, 4);
+}
+
+}
@@ -0,0 +1,176 @@
+//
+// Streaming SVG and DXF export
+//
+
+#define BOOST_TEST_MODULE LayoutExporterTest
+
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include "AllocationCounter.h"
+#include "FlexTrackSegment.h"
+#include "LayoutExporter.h"
+#include "LayoutFile.h"
+#include "TrackGraph.h"
+
+namespace ByteTrail {
+
+    static const char * kPath = "LayoutExporterTest.ftl";
+
+    //! stream buffer that discards its output and records the writes made to it
+    class CountingBuffer : public std::streambuf {
+    public:
+        CountingBuffer() : bytes(0), writes(0) {}
+
+        std::size_t bytes;
+        std::size_t writes;
+
+    protected:
+        std::streamsize xsputn(const char *, std::streamsize count) override {
+            bytes += count;
+            ++writes;
+            return count;
+        }
+
+        int_type overflow(int_type c) override {
+            return xsputn(nullptr, 1) == 1 ? c : traits_type::eof();
+        }
+    };
+
+    //! stream buffer that refuses every write, as a full disk would
+    class FailingBuffer : public std::streambuf {
+    protected:
+        std::streamsize xsputn(const char *, std::streamsize) override {
+            return 0;
+        }
+
+        int_type overflow(int_type) override {
+            return traits_type::eof();
+        }
+    };
+
+    static std::size_t Count(const std::string &text, const std::string &pattern) {
+        std::size_t count = 0;
+        for (std::size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1))
+            ++count;
+        return count;
+    }
+
+    //! writes a layout file of segments laid end to end along the x axis
+    static void WriteLayout(unsigned count) {
+        TrackGraph graph;
+        for (unsigned i = 0; i < count; i++) {
+            std::shared_ptr<BezierCurve> curve = std::make_shared<BezierCurve>();
+            curve->SetControlPoint(300.0 * i, 0, 0);
+            curve->SetControlPoint(300.0 * i + 100, 40, 1);
+            curve->SetControlPoint(300.0 * i + 200, -40, 2);
+            curve->SetControlPoint(300.0 * i + 300, 0, 3);
+            curve->Update();
+            graph.AddSegment(curve);
+        }
+        BOOST_REQUIRE(LayoutFile::Write(kPath, graph));
+    }
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates the SVG elements written for a segment
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(SvgTest) {
+    FlexTrackSegment segment;
+    std::ostringstream out;
+    LayoutExporter exporter(out, EXPORT_SVG);
+    exporter.Begin(Rect {-10, -20.5, 934.4, 41});
+    exporter.WriteSegment(segment);
+    BOOST_CHECK(exporter.End());
+
+    const std::string svg = out.str();
+    BOOST_CHECK_EQUAL(svg.find("<?xml"), 0);
+    BOOST_CHECK(svg.find("viewBox=\"-10 -20.5 934.4 41\"") != std::string::npos);
+    BOOST_CHECK_EQUAL(Count(svg, "<polyline class=\"rail\""), 2);
+    BOOST_CHECK_EQUAL(Count(svg, "<polygon class=\"tie\""), segment.GetTieCount());
+    BOOST_CHECK_EQUAL(svg.substr(svg.size() - 7), "</svg>\n");
+    // the left rail of a straight segment along x starts at its parallels distance
+    BOOST_CHECK(svg.find("points=\"0,-4.5 ") != std::string::npos);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates the DXF entities written for a segment
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(DxfTest) {
+    FlexTrackSegment segment;
+    std::ostringstream out;
+    LayoutExporter exporter(out, EXPORT_DXF);
+    exporter.Begin(Rect {0, -10, 100, 20});
+    exporter.WriteSegment(segment);
+    BOOST_CHECK(exporter.End());
+
+    const std::string dxf = out.str();
+    BOOST_CHECK_EQUAL(dxf.find("0\nSECTION\n2\nHEADER\n"), 0);
+    BOOST_CHECK_EQUAL(Count(dxf, "0\nPOLYLINE\n8\nRAILS\n"), 2);
+    BOOST_CHECK_EQUAL(Count(dxf, "0\nPOLYLINE\n8\nTIES\n66\n1\n70\n1\n"), segment.GetTieCount());
+    BOOST_CHECK_EQUAL(Count(dxf, "0\nSEQEND\n"), segment.GetTieCount() + 2);
+    BOOST_CHECK_EQUAL(dxf.substr(dxf.size() - 15), "0\nENDSEC\n0\nEOF\n");
+    // y is flipped, so the left rail is above the centerline
+    BOOST_CHECK(dxf.find("0\nVERTEX\n8\nRAILS\n10\n0\n20\n4.5\n") != std::string::npos);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that exporting a large layout writes in whole buffers and allocates
+//!        no more than exporting a small one
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(StreamingTest) {
+    WriteLayout(100);
+    LayoutFile small;
+    BOOST_REQUIRE(small.Open(kPath));
+    CountingBuffer small_buffer;
+    std::ostream small_out(&small_buffer);
+    std::size_t before = GetAllocationCount();
+    {
+        LayoutExporter exporter(small_out, EXPORT_SVG);
+        BOOST_CHECK_EQUAL(exporter.Export(small), 100);
+    }
+    const std::size_t small_allocations = GetAllocationCount() - before;
+    small.Close();
+
+    WriteLayout(10000);
+    LayoutFile large;
+    BOOST_REQUIRE(large.Open(kPath));
+    CountingBuffer large_buffer;
+    std::ostream large_out(&large_buffer);
+    before = GetAllocationCount();
+    std::size_t chunks;
+    {
+        LayoutExporter exporter(large_out, EXPORT_SVG);
+        BOOST_CHECK_EQUAL(exporter.Export(large), 10000);
+        chunks = exporter.GetSink().GetChunkCount();
+        BOOST_CHECK_EQUAL(exporter.GetSink().GetBytesWritten(), large_buffer.bytes);
+    }
+    const std::size_t large_allocations = GetAllocationCount() - before;
+    large.Close();
+    std::remove(kPath);
+
+    BOOST_TEST(large_allocations == small_allocations);
+    BOOST_TEST(large_buffer.bytes > 100 * BufferedSink::kBufferSize);
+    BOOST_TEST(large_buffer.writes == chunks);
+    BOOST_TEST(large_buffer.writes <= large_buffer.bytes / (BufferedSink::kBufferSize / 2) + 1);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that exporting to a stream that fails reports no segments written
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(FailingStreamTest) {
+    WriteLayout(10);
+    LayoutFile file;
+    BOOST_REQUIRE(file.Open(kPath));
+    FailingBuffer buffer;
+    std::ostream out(&buffer);
+    LayoutExporter exporter(out, EXPORT_SVG);
+    BOOST_CHECK_EQUAL(exporter.Export(file), 0);
+    BOOST_CHECK(!exporter.GetSink().IsGood());
+    file.Close();
+    std::remove(kPath);
+}
+
+}
@@ -0,0 +1,194 @@
+//
+// Memory mapped layout files
+//
+
+#define BOOST_TEST_MODULE LayoutFileTest
+
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <vector>
+#include "BezierBatch.h"
+#include "BezierCurve.h"
+#include "LayoutFile.h"
+#include "TrackGraph.h"
+
+namespace utf = boost::unit_test;
+
+namespace ByteTrail {
+
+    static const char * kPath = "LayoutFileTest.ftl";
+
+    //! row of segments along the x axis, each 300 long, joined end to start
+    static void BuildRow(TrackGraph &graph, unsigned count) {
+        for (unsigned i = 0; i < count; i++) {
+            std::shared_ptr<BezierCurve> curve = std::make_shared<BezierCurve>();
+            curve->SetControlPoint(300.0 * i, 0, 0);
+            curve->SetControlPoint(300.0 * i + 100, 50, 1);
+            curve->SetControlPoint(300.0 * i + 200, -50, 2);
+            curve->SetControlPoint(300.0 * i + 300, 0, 3);
+            curve->SetResolution(0.05f);
+            curve->Update();
+            unsigned segment = graph.AddSegment(curve);
+            if (segment > 0)
+                graph.Connect(segment - 1, TrackGraph::END_FINISH, segment, TrackGraph::END_START);
+        }
+    }
+
+    static std::vector<unsigned char> ReadFile(const char *path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::vector<unsigned char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    static void WriteFile(const char *path, const std::vector<unsigned char> &data) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(data.data()), data.size());
+    }
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that a written graph reads back unchanged
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(RoundTripTest) {
+    TrackGraph graph;
+    BuildRow(graph, 4);
+    graph.SetFixed(2, true);
+    BOOST_REQUIRE(LayoutFile::Write(kPath, graph));
+
+    LayoutFile file;
+    BOOST_REQUIRE(file.Open(kPath));
+    BOOST_CHECK_EQUAL(file.GetVersion(), LayoutFile::kVersion);
+    BOOST_CHECK_EQUAL(file.GetSegmentCount(), 4);
+    for (unsigned segment = 0; segment < 4; segment++) {
+        const BezierCurve &curve = *graph.GetCurve(segment);
+        for (unsigned i = 0; i < 4; i++) {
+            BOOST_TEST(file.GetControlPoint(segment, i).x == curve.GetControlPoint(i).x);
+            BOOST_TEST(file.GetControlPoint(segment, i).y == curve.GetControlPoint(i).y);
+        }
+        BOOST_TEST(file.GetBounds(segment).x == curve.GetBounds().x);
+        BOOST_TEST(file.GetBounds(segment).height == curve.GetBounds().height);
+        BOOST_TEST(file.GetResolution(segment) == 0.05f);
+        BOOST_TEST(file.GetParallelsDistance(segment) == curve.GetParallelsDistance());
+        BOOST_CHECK_EQUAL(file.IsFixed(segment), segment == 2);
+    }
+    BOOST_CHECK_EQUAL(file.GetLink(0, TrackGraph::END_START), LayoutFile::kNoLink);
+    BOOST_CHECK_EQUAL(file.GetLink(0, TrackGraph::END_FINISH), 1 * 2 + TrackGraph::END_START);
+    BOOST_CHECK_EQUAL(file.GetLink(1, TrackGraph::END_START), 0 * 2 + TrackGraph::END_FINISH);
+    BOOST_CHECK_EQUAL(file.GetLink(3, TrackGraph::END_FINISH), LayoutFile::kNoLink);
+
+    TrackGraph loaded;
+    file.Load(loaded);
+    BOOST_CHECK_EQUAL(loaded.GetSegmentCount(), 4);
+    BOOST_CHECK(loaded.IsFixed(2));
+    BOOST_CHECK(!loaded.IsFixed(1));
+    for (unsigned segment = 0; segment < 3; segment++) {
+        unsigned other;
+        TrackGraph::End end;
+        BOOST_REQUIRE(loaded.GetNeighbor(segment, TrackGraph::END_FINISH, other, end));
+        BOOST_CHECK_EQUAL(other, segment + 1);
+        BOOST_CHECK_EQUAL(end, TrackGraph::END_START);
+    }
+    BOOST_TEST(loaded.GetCurve(3)->GetControlPoint(2).y == -50.0);
+
+    file.Close();
+    BOOST_CHECK(!file.IsOpen());
+    std::remove(kPath);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that only the curves in view are created
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(LazyLoadTest, * utf::tolerance(1.0e-9)) {
+    TrackGraph graph;
+    BuildRow(graph, 10);
+    BOOST_REQUIRE(LayoutFile::Write(kPath, graph));
+
+    LayoutFile file;
+    BOOST_REQUIRE(file.Open(kPath));
+
+    std::vector<unsigned> segments;
+    file.Query(Rect {650, -100, 300, 200}, segments);
+    BOOST_REQUIRE_EQUAL(segments.size(), 2);
+    BOOST_CHECK_EQUAL(segments[0], 2);
+    BOOST_CHECK_EQUAL(segments[1], 3);
+
+    BezierBatch batch;
+    std::vector<std::shared_ptr<BezierCurve>> curves;
+    BOOST_CHECK_EQUAL(file.LoadVisible(Rect {650, -100, 300, 200}, curves, batch), 2);
+    BOOST_CHECK_EQUAL(curves.size(), 10);
+    BOOST_CHECK(curves[1] == nullptr);
+    BOOST_REQUIRE(curves[2] != nullptr);
+    BOOST_CHECK(!curves[2]->IsModified());
+    BOOST_CHECK_EQUAL(curves[2]->GetPointCount(), graph.GetCurve(2)->GetPointCount());
+    BOOST_TEST(curves[2]->GetLength() == graph.GetCurve(2)->GetLength());
+
+    // panning keeps the curves already created
+    std::shared_ptr<BezierCurve> kept = curves[3];
+    BOOST_CHECK_EQUAL(file.LoadVisible(Rect {1000, -100, 300, 200}, curves, batch), 1);
+    BOOST_CHECK(curves[3] == kept);
+    BOOST_CHECK(curves[4] != nullptr);
+    BOOST_CHECK(curves[5] == nullptr);
+    std::remove(kPath);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates the byte order and that damaged files are refused
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(FormatTest) {
+    TrackGraph graph;
+    BuildRow(graph, 2);
+    BOOST_REQUIRE(LayoutFile::Write(kPath, graph));
+    std::vector<unsigned char> data = ReadFile(kPath);
+    BOOST_REQUIRE_EQUAL(data.size(), LayoutFile::kHeaderSize + 2 * LayoutFile::kRecordSize);
+
+    // little endian segment count and record size
+    BOOST_CHECK_EQUAL(data[8], 2);
+    BOOST_CHECK_EQUAL(data[9], 0);
+    BOOST_CHECK_EQUAL(data[12], LayoutFile::kRecordSize);
+    BOOST_CHECK_EQUAL(data[13], 0);
+
+    LayoutFile file;
+    BOOST_CHECK(!file.Open("LayoutFileTest.missing"));
+
+    std::vector<unsigned char> truncated(data.begin(), data.end() - 1);
+    WriteFile(kPath, truncated);
+    BOOST_CHECK(!file.Open(kPath));
+
+    std::vector<unsigned char> bad_magic = data;
+    bad_magic[0] = 'X';
+    WriteFile(kPath, bad_magic);
+    BOOST_CHECK(!file.Open(kPath));
+
+    std::vector<unsigned char> later_version = data;
+    later_version[4] = LayoutFile::kVersion + 1;
+    WriteFile(kPath, later_version);
+    BOOST_CHECK(!file.Open(kPath));
+
+    WriteFile(kPath, data);
+    BOOST_CHECK(file.Open(kPath));
+    BOOST_CHECK(!file.IsFixed(1));
+
+    // values a curve cannot take read as the defaults, the structure is sound
+    const float resolutions[] = {0.0F, 1.0F, -0.5F, 1e-30F, std::numeric_limits<float>::quiet_NaN()};
+    for (float resolution : resolutions) {
+        std::vector<unsigned char> corrupt = data;
+        std::memcpy(&corrupt[LayoutFile::kHeaderSize + 96], &resolution, sizeof(resolution));
+        const float distance = std::numeric_limits<float>::infinity();
+        std::memcpy(&corrupt[LayoutFile::kHeaderSize + 100], &distance, sizeof(distance));
+        WriteFile(kPath, corrupt);
+        BOOST_REQUIRE(file.Open(kPath));
+        BOOST_CHECK_EQUAL(file.GetResolution(0), BezierCurve::kDefaultResolution);
+        BOOST_CHECK_EQUAL(file.GetParallelsDistance(0), BezierCurve::kDefaultDistance);
+        BOOST_CHECK_EQUAL(file.GetResolution(1), 0.05F);
+
+        std::shared_ptr<BezierCurve> curve = file.CreateCurve(0);
+        BOOST_CHECK_EQUAL(curve->GetResolution(), BezierCurve::kDefaultResolution);
+        BOOST_CHECK_EQUAL(curve->GetPointCount(), 41U);
+    }
+    file.Close();
+    std::remove(kPath);
+}
+
+}
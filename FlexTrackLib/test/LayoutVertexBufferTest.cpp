@@ -0,0 +1,146 @@
+//
+// Packing of the layout vertex data uploaded to the GL renderer
+//
+
+#define BOOST_TEST_MODULE LayoutVertexBufferTest
+
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <vector>
+#include "BezierCurve.h"
+#include "LayoutVertexBuffer.h"
+
+namespace ByteTrail {
+
+    namespace utf = boost::unit_test;
+
+    //! gentle s bend about 300 long starting at x
+    static void BuildCurve(BezierCurve &curve, double x, float resolution) {
+        curve.SetResolution(resolution);
+        curve.SetControlPoint(x, 0, 0);
+        curve.SetControlPoint(x + 100, 40, 1);
+        curve.SetControlPoint(x + 200, -40, 2);
+        curve.SetControlPoint(x + 300, 0, 3);
+        curve.Update();
+    }
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that an edit only rewrites the slots of the curve edited
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(UpdateTest, * utf::tolerance(1e-4)) {
+    BezierCurve curves[3];
+    for (unsigned i = 0; i < 3; i++)
+        BuildCurve(curves[i], i * 400.0, 0.1F);
+
+    LayoutVertexBuffer buffer;
+    buffer.Resize(3);
+    for (unsigned i = 0; i < 3; i++)
+        BOOST_CHECK(buffer.Update(i, curves[i], true));
+
+    LayoutVertexBuffer::Range range;
+    const std::vector<float> &rails = buffer.GetData(LayoutVertexBuffer::ARRAY_RAILS);
+    BOOST_REQUIRE(buffer.TakeDirty(LayoutVertexBuffer::ARRAY_RAILS, range));
+    BOOST_CHECK_EQUAL(range.first, 0);
+    BOOST_CHECK(range.count > 0);
+    BOOST_CHECK(range.count <= rails.size());
+    BOOST_CHECK(!buffer.TakeDirty(LayoutVertexBuffer::ARRAY_RAILS, range));
+    BOOST_REQUIRE(buffer.TakeDirty(LayoutVertexBuffer::ARRAY_TIES, range));
+
+    // nothing to write for a curve that did not change
+    BOOST_CHECK(!buffer.Update(1, curves[1], true));
+    BOOST_CHECK(!buffer.TakeDirty(LayoutVertexBuffer::ARRAY_RAILS, range));
+    BOOST_CHECK(!buffer.TakeDirty(LayoutVertexBuffer::ARRAY_TIES, range));
+
+    curves[1].SetControlPoint(500, 60, 1);
+    BOOST_CHECK(buffer.Update(1, curves[1], true));
+    const unsigned long revision = buffer.GetLayoutRevision();
+
+    std::vector<int> firsts;
+    std::vector<int> counts;
+    buffer.GetRailStrips(firsts, counts);
+    BOOST_REQUIRE_EQUAL(firsts.size(), 3);
+    PointView center = curves[1].GetCenterline();
+    PointView left = curves[1].GetLeftRail();
+    BOOST_CHECK_EQUAL(counts[1], center.size());
+    BOOST_CHECK(firsts[0] < firsts[1]);
+    BOOST_CHECK(firsts[1] < firsts[2]);
+
+    // the dirty range is the slot of the curve edited only
+    BOOST_REQUIRE(buffer.TakeDirty(LayoutVertexBuffer::ARRAY_RAILS, range));
+    BOOST_CHECK_EQUAL(range.first, firsts[1] * LayoutVertexBuffer::kRailStride);
+    BOOST_CHECK_EQUAL(range.count, counts[1] * LayoutVertexBuffer::kRailStride);
+    for (std::size_t i = 0; i < center.size(); i++) {
+        const float *vertex = rails.data() + range.first + i * LayoutVertexBuffer::kRailStride;
+        BOOST_TEST(vertex[0] == center[i].x);
+        BOOST_TEST(vertex[1] == center[i].y);
+        BOOST_TEST(vertex[0] + vertex[2] == left[i].x);
+        BOOST_TEST(vertex[1] + vertex[3] == left[i].y);
+    }
+
+    // ties are placed about the centerline, square to it
+    const std::vector<float> &ties = buffer.GetData(LayoutVertexBuffer::ARRAY_TIES);
+    BOOST_REQUIRE(buffer.TakeDirty(LayoutVertexBuffer::ARRAY_TIES, range));
+    BOOST_CHECK(range.count > 0);
+    for (std::size_t i = range.first; i < range.first + range.count; i += LayoutVertexBuffer::kTieStride) {
+        const float length = std::sqrt(ties[i + 2] * ties[i + 2] + ties[i + 3] * ties[i + 3]);
+        BOOST_TEST(length == 1.0);
+        BOOST_CHECK(ties[i] >= 400.0F && ties[i] <= 700.0F);
+    }
+    BOOST_CHECK_EQUAL(buffer.GetTieCount() * LayoutVertexBuffer::kTieStride, ties.size());
+    BOOST_CHECK_EQUAL(buffer.GetLayoutRevision(), revision);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates moving outgrown slots and compacting the arrays
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(GrowTest) {
+    BezierCurve curves[2];
+    BuildCurve(curves[0], 0.0, 0.1F);
+    BuildCurve(curves[1], 400.0, 0.1F);
+
+    LayoutVertexBuffer buffer;
+    buffer.Resize(2);
+    buffer.Update(0, curves[0], false);
+    buffer.Update(1, curves[1], false);
+    const unsigned long revision = buffer.GetLayoutRevision();
+    const std::vector<float> &rails = buffer.GetData(LayoutVertexBuffer::ARRAY_RAILS);
+    LayoutVertexBuffer::Range range;
+    buffer.TakeDirty(LayoutVertexBuffer::ARRAY_RAILS, range);
+
+    // ten times the points no longer fit, the curve moves to the end
+    BuildCurve(curves[1], 400.0, 0.01F);
+    BOOST_CHECK(buffer.Update(1, curves[1], false));
+    BOOST_CHECK_EQUAL(buffer.GetLayoutRevision(), revision);
+
+    std::vector<int> firsts;
+    std::vector<int> counts;
+    buffer.GetRailStrips(firsts, counts);
+    BOOST_REQUIRE_EQUAL(firsts.size(), 2);
+    BOOST_CHECK_EQUAL(firsts[0], 0);
+    BOOST_CHECK_EQUAL(counts[1], curves[1].GetCenterline().size());
+    for (int i = (firsts[0] + counts[0]) * LayoutVertexBuffer::kRailStride;
+         i < firsts[1] * static_cast<int>(LayoutVertexBuffer::kRailStride); i++)
+        BOOST_CHECK_EQUAL(rails[i], 0.0F);
+
+    // the slot left behind and the new slot are uploaded, the first curve is not
+    BOOST_REQUIRE(buffer.TakeDirty(LayoutVertexBuffer::ARRAY_RAILS, range));
+    BOOST_CHECK(range.first >= (firsts[0] + counts[0]) * LayoutVertexBuffer::kRailStride);
+    BOOST_CHECK_EQUAL(range.first + range.count, (firsts[1] + counts[1]) * LayoutVertexBuffer::kRailStride);
+
+    // no ties were asked for
+    BOOST_CHECK_EQUAL(buffer.GetTieCount(), 0);
+
+    // dropping the large curve leaves most of the array unused
+    buffer.Resize(1);
+    BOOST_CHECK_EQUAL(buffer.GetSize(), 1);
+    BOOST_CHECK_EQUAL(buffer.GetLayoutRevision(), revision + 1);
+    buffer.GetRailStrips(firsts, counts);
+    BOOST_REQUIRE_EQUAL(firsts.size(), 1);
+    BOOST_CHECK_EQUAL(firsts[0], 0);
+    BOOST_CHECK(rails.size() < 2 * counts[0] * LayoutVertexBuffer::kRailStride);
+    BOOST_REQUIRE(buffer.TakeDirty(LayoutVertexBuffer::ARRAY_RAILS, range));
+    BOOST_CHECK_EQUAL(range.first, 0);
+    BOOST_CHECK_EQUAL(range.count, rails.size());
+}
+
+}
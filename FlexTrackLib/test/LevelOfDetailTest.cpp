@@ -0,0 +1,76 @@
+//
+// Level of detail selection and geometry
+//
+
+#define BOOST_TEST_MODULE LevelOfDetailTest
+
+#include <boost/test/unit_test.hpp>
+#include <vector>
+#include "BezierCurve.h"
+#include "FlexTrackSegment.h"
+#include "LevelOfDetail.h"
+
+namespace ByteTrail {
+
+    //! gentle s bend about 300 long
+    static void BuildCurve(BezierCurve &curve) {
+        curve.SetControlPoint(0, 0, 0);
+        curve.SetControlPoint(100, 40, 1);
+        curve.SetControlPoint(200, -40, 2);
+        curve.SetControlPoint(300, 0, 3);
+        curve.Update();
+    }
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates the detail chosen from the scale and the on screen length
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(SelectTest) {
+    // tie spacing 6.4 pixels
+    BOOST_CHECK_EQUAL(LevelOfDetail::Select(2.0, 4.5, 300), DETAIL_TIES);
+    // ties 1.6 pixels apart, rails 4.5 pixels apart
+    BOOST_CHECK_EQUAL(LevelOfDetail::Select(0.5, 4.5, 300), DETAIL_RAILS);
+    // rails less than a pixel apart
+    BOOST_CHECK_EQUAL(LevelOfDetail::Select(0.1, 4.5, 300), DETAIL_CENTERLINE);
+    // a segment 4 pixels long is a line whatever the scale
+    BOOST_CHECK_EQUAL(LevelOfDetail::Select(2.0, 4.5, 2), DETAIL_CENTERLINE);
+
+    BOOST_CHECK_EQUAL(LevelOfDetail::GetStride(2, 100), 1);
+    BOOST_CHECK_EQUAL(LevelOfDetail::GetStride(41, 400), 1);
+    BOOST_CHECK_EQUAL(LevelOfDetail::GetStride(41, 40), 4);
+    BOOST_CHECK_EQUAL(LevelOfDetail::GetStride(41, 0), 40);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates the geometry built at each detail level
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(BuildTest) {
+    BezierCurve curve;
+    BuildCurve(curve);
+    LevelOfDetail detail;
+
+    detail.Build(curve, DETAIL_TIES, 2.0);
+    BOOST_REQUIRE_EQUAL(detail.GetStarts().size(), 2);
+    BOOST_CHECK_EQUAL(detail.GetStarts()[1], curve.GetLeftRail().size());
+    BOOST_CHECK_EQUAL(detail.GetPoints().size(), curve.GetLeftRail().size() + curve.GetRightRail().size());
+    std::vector<Quad> ties;
+    FlexTrackSegment::GenerateTies(curve, ties);
+    BOOST_CHECK(!ties.empty());
+    BOOST_CHECK_EQUAL(detail.GetTies().size(), ties.size());
+
+    detail.Build(curve, DETAIL_RAILS, 0.5);
+    BOOST_CHECK_EQUAL(detail.GetStarts().size(), 2);
+    BOOST_CHECK(detail.GetTies().empty());
+
+    // about 30 pixels long, so a point every 4 pixels or so
+    detail.Build(curve, DETAIL_CENTERLINE, 0.1);
+    BOOST_REQUIRE_EQUAL(detail.GetStarts().size(), 1);
+    const std::vector<Point> &points = detail.GetPoints();
+    BOOST_CHECK(points.size() >= 3);
+    BOOST_CHECK(points.size() <= 12);
+    BOOST_CHECK(points.size() < curve.GetCenterline().size());
+    BOOST_TEST(points.front().x == 0.0);
+    BOOST_TEST(points.back().x == 300.0);
+    BOOST_TEST(points.back().y == 0.0);
+}
+
+}
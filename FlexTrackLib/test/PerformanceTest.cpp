@@ -0,0 +1,308 @@
+//
+// Allocation, work and determinism budgets of recalculating whole layouts
+//
+
+#define BOOST_TEST_MODULE PerformanceTest
+
+#include <boost/test/unit_test.hpp>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "AllocationCounter.h"
+#include "BezierBatch.h"
+#include "BezierCurve.h"
+#include "ClearanceChecker.h"
+#include "EditJournal.h"
+#include "FlexTrackSegment.h"
+#include "LayoutRecalculator.h"
+#include "Stats.h"
+#include "TaskPool.h"
+#include "TrackGraph.h"
+
+namespace ByteTrail {
+
+    //! layout sizes every budget is checked at
+    static const unsigned kSizes[] = {100, 1000, 10000};
+
+    //! chained s bends, each starting where the one before finishes
+    static void SetCurve(BezierCurve &curve, unsigned i) {
+        curve.SetControlPoint(200.0 * i, 0, 0);
+        curve.SetControlPoint(200.0 * i + 70, 30, 1);
+        curve.SetControlPoint(200.0 * i + 130, -30, 2);
+        curve.SetControlPoint(200.0 * i + 200, 0, 3);
+    }
+
+    static std::vector<std::shared_ptr<BezierCurve>> BuildLayout(unsigned count) {
+        std::vector<std::shared_ptr<BezierCurve>> curves;
+        for (unsigned i = 0; i < count; i++) {
+            std::shared_ptr<BezierCurve> curve = std::make_shared<BezierCurve>();
+            SetCurve(*curve, i);
+            curves.push_back(curve);
+        }
+        return curves;
+    }
+
+    static std::vector<std::shared_ptr<FlexTrackSegment>> BuildSegments(unsigned count) {
+        std::vector<std::shared_ptr<FlexTrackSegment>> segments;
+        for (unsigned i = 0; i < count; i++) {
+            std::shared_ptr<FlexTrackSegment> segment = std::make_shared<FlexTrackSegment>();
+            SetCurve(*segment->GetCurve(), i);
+            segments.push_back(segment);
+        }
+        return segments;
+    }
+
+    static void BuildGraph(TrackGraph &graph, unsigned count) {
+        for (unsigned i = 0; i < count; i++) {
+            std::shared_ptr<BezierCurve> curve = std::make_shared<BezierCurve>();
+            SetCurve(*curve, i);
+            curve->Update();
+            const unsigned segment = graph.AddSegment(curve);
+            if (segment > 0)
+                graph.Connect(segment - 1, TrackGraph::END_FINISH, segment, TrackGraph::END_START);
+        }
+    }
+
+    //! marks every curve modified without changing its shape
+    static void Touch(std::vector<std::shared_ptr<BezierCurve>> &curves, double dx) {
+        for (auto &curve : curves)
+            curve->Move(dx, 0.0);
+    }
+
+    static bool IsSame(PointView a, PointView b) {
+        return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(Point)) == 0;
+    }
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that recalculating a layout again allocates nothing, whatever its
+//!        size and whichever path recalculates it
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(SteadyStateTest) {
+    TaskPool pool(3);
+    for (unsigned size : kSizes) {
+        BOOST_TEST_MESSAGE("curves: " << size);
+        std::vector<std::shared_ptr<BezierCurve>> curves = BuildLayout(size);
+        LayoutRecalculator recalculator(pool);
+        BezierBatch batch;
+
+        // the first pass sizes every buffer
+        recalculator.Recalculate(curves);
+        Touch(curves, 1.0);
+        batch.Recalculate(curves);
+
+        std::size_t before = GetAllocationCount();
+        for (unsigned i = 0; i < 3; i++) {
+            Touch(curves, 1.0);
+            for (auto &curve : curves)
+                curve->Update();
+        }
+        BOOST_CHECK_EQUAL(GetAllocationCount() - before, 0U);
+
+        before = GetAllocationCount();
+        for (unsigned i = 0; i < 3; i++) {
+            Touch(curves, -1.0);
+            batch.Recalculate(curves);
+        }
+        BOOST_CHECK_EQUAL(GetAllocationCount() - before, 0U);
+
+        before = GetAllocationCount();
+        for (unsigned i = 0; i < 3; i++) {
+            Touch(curves, 1.0);
+            BOOST_CHECK_EQUAL(recalculator.Recalculate(curves), size);
+        }
+        BOOST_CHECK_EQUAL(GetAllocationCount() - before, 0U);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that regenerating the ties of every segment allocates nothing
+//!        once the tie buffers are sized
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(SteadyStateTiesTest) {
+    TaskPool pool(3);
+    for (unsigned size : kSizes) {
+        BOOST_TEST_MESSAGE("segments: " << size);
+        std::vector<std::shared_ptr<FlexTrackSegment>> segments = BuildSegments(size);
+        LayoutRecalculator recalculator(pool);
+        recalculator.Recalculate(segments);
+
+        const std::size_t before = GetAllocationCount();
+        for (unsigned i = 0; i < 3; i++) {
+            for (auto &segment : segments)
+                segment->GetCurve()->Move(0.0, 1.0);
+            recalculator.Recalculate(segments);
+        }
+        BOOST_CHECK_EQUAL(GetAllocationCount() - before, 0U);
+    }
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that a drag step allocates nothing and costs the same whatever the
+//!        size of the layout
+//!
+//! A step moves a joint, recalculates the segments it touched, checks their clearance
+//! and journals the change, as the view does on every motion event. The cost is the
+//! work counted by Stats, which unlike the time does not depend on the load of the
+//! machine.
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(DragStepTest) {
+    Stats &stats = Stats::GetInstance();
+    FrameStats frame;
+    stats.SetEnabled(true);
+
+    std::uint64_t curves = 0;
+    std::uint64_t points = 0;
+    for (unsigned size : kSizes) {
+        BOOST_TEST_MESSAGE("segments: " << size);
+        TrackGraph graph;
+        BuildGraph(graph, size);
+        ClearanceChecker clearance;
+        clearance.Update(graph);
+        EditJournal journal;
+
+        const unsigned segment = size / 2;
+        const Point joint = graph.GetCurve(segment)->GetControlPoint(3);
+        unsigned events = 0;
+        auto step = [&]() {
+            ++events;
+            graph.MoveControlPoint(segment, 3, Point(joint.x, joint.y + 1 + (events % 8)));
+            journal.Record(graph);
+            for (const TrackGraph::Touch &touch : graph.GetTouched()) {
+                graph.GetCurve(touch.segment)->Update();
+                clearance.Update(graph, touch.segment);
+            }
+        };
+
+        journal.BeginStep();
+        for (unsigned i = 0; i < 16; i++)
+            step();
+        stats.EndFrame(frame);
+        const std::size_t before = GetAllocationCount();
+        for (unsigned i = 0; i < 64; i++)
+            step();
+        BOOST_CHECK_EQUAL(GetAllocationCount() - before, 0U);
+        stats.EndFrame(frame);
+        BOOST_CHECK(journal.EndStep(graph));
+
+        // the work of a step does not depend on the segments left alone
+        BOOST_CHECK_EQUAL(frame.counters[STAT_CURVES_RECALCULATED], 64U * 2);
+        if (size == kSizes[0]) {
+            curves = frame.counters[STAT_CURVES_RECALCULATED];
+            points = frame.counters[STAT_POINTS_EMITTED];
+        }
+        BOOST_CHECK_EQUAL(frame.counters[STAT_CURVES_RECALCULATED], curves);
+        BOOST_CHECK_EQUAL(frame.counters[STAT_POINTS_EMITTED], points);
+    }
+    stats.SetEnabled(false);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that the work of recalculating and checking a whole layout grows
+//!        linearly with the number of segments
+//!
+//! The layout is driven through LayoutRecalculator, BezierBatch and ClearanceChecker
+//! and their work is counted by Stats: curves recalculated and points emitted, and
+//! for the clearance the narrow phase pair tests and the grid cells visited by the
+//! broad phase. Unlike the time these do not depend on the load of the machine, and
+//! a broad phase that lets through more than the neighbors of a segment shows as
+//! work per segment growing with the layout.
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(ScalingTest) {
+    Stats &stats = Stats::GetInstance();
+    FrameStats frame;
+    stats.SetEnabled(true);
+    stats.EndFrame(frame);
+
+    TaskPool pool(3);
+    LayoutRecalculator recalculator(pool);
+    BezierBatch batch;
+    double pairs = 0.0;
+    double cells = 0.0;
+    for (unsigned size : kSizes) {
+        BOOST_TEST_MESSAGE("segments: " << size);
+        std::vector<std::shared_ptr<BezierCurve>> curves = BuildLayout(size);
+        const unsigned points = BezierCurve(*curves[0]).GetPointCount();
+
+        stats.EndFrame(frame);
+        BOOST_CHECK_EQUAL(recalculator.Recalculate(curves), size);
+        stats.EndFrame(frame);
+        BOOST_CHECK_EQUAL(frame.counters[STAT_CURVES_RECALCULATED], size);
+        // the centerline and both rails of every curve
+        BOOST_CHECK_EQUAL(frame.counters[STAT_POINTS_EMITTED], 3U * points * size);
+
+        Touch(curves, 1.0);
+        batch.Recalculate(curves);
+        stats.EndFrame(frame);
+        BOOST_CHECK_EQUAL(frame.counters[STAT_CURVES_RECALCULATED], size);
+        BOOST_CHECK_EQUAL(frame.counters[STAT_POINTS_EMITTED], 3U * points * size);
+
+        // curves left alone cost nothing
+        recalculator.Recalculate(curves);
+        batch.Recalculate(curves);
+        stats.EndFrame(frame);
+        BOOST_CHECK_EQUAL(frame.counters[STAT_CURVES_RECALCULATED], 0U);
+
+        TrackGraph graph;
+        BuildGraph(graph, size);
+        ClearanceChecker clearance;
+        stats.EndFrame(frame);
+        clearance.Update(graph);
+        stats.EndFrame(frame);
+        BOOST_CHECK_EQUAL(clearance.GetConflictCount(), 0U);
+        const double segment_pairs = static_cast<double>(frame.counters[STAT_CLEARANCE_PAIRS_CHECKED]) / size;
+        const double segment_cells = static_cast<double>(frame.counters[STAT_GRID_CELLS_VISITED]) / size;
+        BOOST_TEST_MESSAGE("pairs per segment: " << segment_pairs << ", cells per segment: " << segment_cells);
+        BOOST_CHECK(segment_pairs > 0.0);
+        BOOST_CHECK(segment_cells > 0.0);
+        if (size == kSizes[0]) {
+            pairs = segment_pairs;
+            cells = segment_cells;
+        }
+        BOOST_CHECK_CLOSE(segment_pairs, pairs, 10.0);
+        BOOST_CHECK_CLOSE(segment_cells, cells, 10.0);
+    }
+    stats.SetEnabled(false);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that recalculating on the pool gives the very same samples and
+//!        ties as recalculating serially
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(DeterminismTest) {
+    TaskPool pool(3);
+    LayoutRecalculator recalculator(pool);
+    for (unsigned size : kSizes) {
+        BOOST_TEST_MESSAGE("curves: " << size);
+        std::vector<std::shared_ptr<BezierCurve>> serial = BuildLayout(size);
+        std::vector<std::shared_ptr<BezierCurve>> threaded = BuildLayout(size);
+        for (auto &curve : serial)
+            curve->Update();
+        BOOST_CHECK_EQUAL(recalculator.Recalculate(threaded), size);
+
+        unsigned mismatches = 0;
+        for (unsigned i = 0; i < size; i++) {
+            BezierCurve &a = *serial[i];
+            BezierCurve &b = *threaded[i];
+            if (!IsSame(a.GetCenterline(), b.GetCenterline()) || !IsSame(a.GetLeftRail(), b.GetLeftRail()) ||
+                !IsSame(a.GetRightRail(), b.GetRightRail()) || !IsSame(a.GetNormals(), b.GetNormals()) ||
+                !IsSame(a.GetTangentPoints(), b.GetTangentPoints()))
+                ++mismatches;
+        }
+        BOOST_CHECK_EQUAL(mismatches, 0U);
+
+        std::vector<std::shared_ptr<FlexTrackSegment>> segments = BuildSegments(size);
+        std::vector<std::shared_ptr<FlexTrackSegment>> reference = BuildSegments(size);
+        recalculator.Recalculate(segments);
+        mismatches = 0;
+        for (unsigned i = 0; i < size; i++) {
+            const std::vector<Quad> &a = reference[i]->GetTies();
+            const std::vector<Quad> &b = segments[i]->GetTies();
+            if (a.size() != b.size() || std::memcmp(a.data(), b.data(), a.size() * sizeof(Quad)) != 0)
+                ++mismatches;
+        }
+        BOOST_CHECK_EQUAL(mismatches, 0U);
+    }
+}
+
+}
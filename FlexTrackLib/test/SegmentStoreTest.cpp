@@ -0,0 +1,130 @@
+//
+// Curves held by value behind stable handles
+//
+
+#define BOOST_TEST_MODULE SegmentStoreTest
+
+#include <boost/test/unit_test.hpp>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "BezierBatch.h"
+#include "BezierCurve.h"
+#include "LayoutRecalculator.h"
+#include "SegmentStore.h"
+#include "TaskPool.h"
+
+namespace ByteTrail {
+
+    static void SetCurve(BezierCurve &curve, double x) {
+        curve.SetControlPoint(x, 0, 0);
+        curve.SetControlPoint(x + 100, 50, 1);
+        curve.SetControlPoint(x + 200, -50, 2);
+        curve.SetControlPoint(x + 300, 0, 3);
+    }
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that handles survive removing other curves and go stale with
+//!        their own
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(HandleTest) {
+    SegmentStore store;
+    std::vector<SegmentStore::Handle> handles;
+    for (unsigned i = 0; i < 5; i++) {
+        BezierCurve curve;
+        SetCurve(curve, 1000.0 * i);
+        handles.push_back(store.Add(std::move(curve)));
+    }
+    BOOST_CHECK_EQUAL(store.GetSize(), 5);
+    BOOST_CHECK(!store.Contains(SegmentStore::kNoHandle));
+    BOOST_CHECK(store.Find(SegmentStore::kNoHandle) == nullptr);
+
+    // the last curve takes the place of the one removed
+    BOOST_CHECK(store.Remove(handles[1]));
+    BOOST_CHECK(!store.Remove(handles[1]));
+    BOOST_CHECK_EQUAL(store.GetSize(), 4);
+    BOOST_CHECK(!store.Contains(handles[1]));
+    BOOST_CHECK_EQUAL(store.GetIndex(handles[1]), SegmentStore::kNoIndex);
+    BOOST_CHECK_EQUAL(store.GetIndex(handles[4]), 1);
+    BOOST_CHECK(store.GetHandle(1) == handles[4]);
+    for (unsigned i : {0U, 2U, 3U, 4U})
+        BOOST_CHECK_EQUAL(store.Get(handles[i]).GetControlPoint(0).x, 1000.0 * i);
+
+    // a reused slot gets a new generation
+    BezierCurve curve;
+    SetCurve(curve, 5000.0);
+    SegmentStore::Handle reused = store.Add(curve);
+    BOOST_CHECK_EQUAL(reused.slot, handles[1].slot);
+    BOOST_CHECK(reused != handles[1]);
+    BOOST_CHECK(store.Find(handles[1]) == nullptr);
+    BOOST_CHECK_EQUAL(store.Find(reused)->GetControlPoint(0).x, 5000.0);
+
+    store.Clear();
+    BOOST_CHECK(store.IsEmpty());
+    BOOST_CHECK(!store.Contains(handles[0]));
+    BOOST_CHECK(!store.Contains(reused));
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that storing and moving curves hands over their point buffers
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(MoveTest) {
+    BezierCurve curve;
+    SetCurve(curve, 0.0);
+    curve.Update();
+    const Point *points = curve.GetCenterline().data();
+    const std::size_t size = curve.GetCenterline().size();
+
+    SegmentStore store;
+    store.Reserve(2);
+    SegmentStore::Handle first = store.Add(std::move(curve));
+    BOOST_CHECK(store.Get(first).GetCenterline().data() == points);
+
+    BezierCurve second;
+    SetCurve(second, 1000.0);
+    SegmentStore::Handle handle = store.Add(std::move(second));
+    BOOST_CHECK(store.Remove(first));
+    BOOST_CHECK_EQUAL(store.GetIndex(handle), 0);
+
+    // a copy owns buffers of its own
+    BezierCurve copy(store.Get(handle));
+    BOOST_CHECK(copy.GetCenterline().data() != store.Get(handle).GetCenterline().data());
+    BOOST_CHECK_EQUAL(copy.GetCenterline().size(), size);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that a store recalculates like shared curves
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(RecalculateTest) {
+    SegmentStore store;
+    std::vector<std::shared_ptr<BezierCurve>> shared;
+    for (unsigned i = 0; i < 100; i++) {
+        std::shared_ptr<BezierCurve> curve = std::make_shared<BezierCurve>();
+        SetCurve(*curve, 400.0 * i);
+        store.Add(*curve);
+        shared.push_back(curve);
+    }
+
+    BezierBatch batch;
+    batch.Recalculate(shared);
+    batch.Recalculate(store);
+    BOOST_CHECK_EQUAL(LayoutRecalculator::GetModifiedCount(store), 0);
+    for (unsigned i = 0; i < store.GetSize(); i++) {
+        PointView expected = shared[i]->GetLeftRail();
+        PointView actual = store[i].GetLeftRail();
+        BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+        for (std::size_t j = 0; j < actual.size(); j++)
+            BOOST_CHECK(actual[j] == expected[j]);
+    }
+
+    TaskPool pool(2);
+    LayoutRecalculator recalculator(pool);
+    for (BezierCurve &curve : store)
+        curve.Move(1.0, 0.0);
+    BOOST_CHECK_EQUAL(LayoutRecalculator::GetModifiedCount(store), 100);
+    BOOST_CHECK_EQUAL(recalculator.Recalculate(store), 100);
+    BOOST_CHECK_EQUAL(LayoutRecalculator::GetModifiedCount(store), 0);
+    BOOST_CHECK_EQUAL(store[0].GetCenterline()[0].x, 1.0);
+}
+
+}
@@ -0,0 +1,93 @@
+//
+// Spatial index used for hit testing
+//
+
+#define BOOST_TEST_MODULE SpatialGridTest
+
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include "SpatialGrid.h"
+
+namespace ByteTrail {
+
+    static bool Found(const std::vector<unsigned> &ids, unsigned id) {
+        return std::find(ids.begin(), ids.end(), id) != ids.end();
+    }
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates point and area queries, including negative coordinates and
+//!        entries spanning several cells
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(QueryTest) {
+    SpatialGrid grid(10.0);
+    grid.Insert(0, Rect{1, 1, 2, 2});
+    grid.Insert(1, Rect{-15, -15, 4, 4});
+    grid.Insert(2, Rect{0, 0, 100, 5});
+    BOOST_TEST(grid.GetSize() == 3U);
+
+    std::vector<unsigned> ids;
+    grid.Query(2, 2, ids);
+    BOOST_TEST(ids.size() == 2U);
+    BOOST_CHECK(Found(ids, 0) && Found(ids, 2));
+
+    ids.clear();
+    grid.Query(-13, -13, ids);
+    BOOST_TEST(ids.size() == 1U);
+    BOOST_CHECK(Found(ids, 1));
+
+    ids.clear();
+    grid.Query(50, 50, ids);
+    BOOST_TEST(ids.empty());
+
+    // an area covering every cell of entry 2 reports it once
+    ids.clear();
+    grid.Query(Rect{-20, -20, 140, 30}, ids);
+    BOOST_TEST(ids.size() == 3U);
+
+    ids.clear();
+    grid.Query(Rect{60, 0, 5, 5}, ids);
+    BOOST_TEST(ids.size() == 1U);
+    BOOST_CHECK(Found(ids, 2));
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that moved and removed entries are only found at their new place
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(UpdateTest) {
+    SpatialGrid grid(10.0);
+    grid.Insert(0, Rect{1, 1, 2, 2});
+    grid.Insert(5, Rect{3, 3, 2, 2});
+    BOOST_TEST(grid.GetSize() == 2U);
+    BOOST_CHECK(!grid.Contains(3));
+
+    // a move within the same cell
+    grid.Insert(0, Rect{6, 6, 2, 2});
+    std::vector<unsigned> ids;
+    grid.Query(2, 2, ids);
+    BOOST_TEST(ids.empty());
+    grid.Query(7, 7, ids);
+    BOOST_TEST(ids.size() == 1U);
+
+    // a move to another cell
+    grid.Insert(0, Rect{41, 41, 2, 2});
+    BOOST_TEST(grid.GetSize() == 2U);
+    ids.clear();
+    grid.Query(7, 7, ids);
+    BOOST_TEST(ids.empty());
+    grid.Query(42, 42, ids);
+    BOOST_TEST(ids.size() == 1U);
+    BOOST_TEST(grid.GetBounds(0).x == 41.0);
+
+    grid.Remove(5);
+    grid.Remove(5);
+    BOOST_TEST(grid.GetSize() == 1U);
+    ids.clear();
+    grid.Query(4, 4, ids);
+    BOOST_TEST(ids.empty());
+
+    grid.Clear();
+    BOOST_TEST(grid.GetSize() == 0U);
+    BOOST_CHECK(!grid.Contains(0));
+}
+
+}
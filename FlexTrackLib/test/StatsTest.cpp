@@ -0,0 +1,87 @@
+//
+// Per frame statistics
+//
+
+#define BOOST_TEST_MODULE StatsTest
+
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <sstream>
+#include "BezierCurve.h"
+#include "FlexTrackSegment.h"
+#include "Stats.h"
+
+namespace ByteTrail {
+
+    static std::size_t CountColumns(const std::string &line) {
+        return std::count(line.begin(), line.end(), ',') + 1;
+    }
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that recalculation and tie generation are counted and timed and
+//!        that ending a frame resets the statistics
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(FrameStatsTest) {
+    Stats &stats = Stats::GetInstance();
+    FrameStats frame;
+    stats.SetEnabled(true);
+    stats.EndFrame(frame);
+
+    BezierCurve curve;
+    curve.SetControlPoint(0, 0, 0);
+    curve.SetControlPoint(100, 0, 1);
+    curve.SetControlPoint(200, 0, 2);
+    curve.SetControlPoint(300, 0, 3);
+    curve.Update();
+
+    FlexTrackSegment segment;
+    std::size_t ties = segment.GetTies().size();
+
+    stats.EndFrame(frame);
+    BOOST_TEST(frame.counters[STAT_CURVES_RECALCULATED] == 2U);
+    BOOST_TEST(frame.counters[STAT_POINTS_EMITTED] >= 3U * curve.GetPointCount());
+    BOOST_TEST(frame.counters[STAT_TIES_GENERATED] == ties);
+    BOOST_TEST(frame.calls[STAT_TIMER_RECALCULATE_CURVE] == 2U);
+    BOOST_TEST(frame.calls[STAT_TIMER_RECALCULATE_PARALLELS] == 2U);
+    BOOST_TEST(frame.calls[STAT_TIMER_GET_TIES] == 1U);
+    BOOST_TEST(frame.time[STAT_TIMER_RECALCULATE_CURVE] >= frame.time[STAT_TIMER_RECALCULATE_PARALLELS]);
+
+    std::uint64_t number = frame.frame;
+    stats.EndFrame(frame);
+    BOOST_TEST(frame.frame == number + 1);
+    BOOST_TEST(frame.counters[STAT_CURVES_RECALCULATED] == 0U);
+    BOOST_TEST(frame.calls[STAT_TIMER_GET_TIES] == 0U);
+
+    // nothing is collected while disabled
+    stats.SetEnabled(false);
+    curve.Move(10, 0);
+    curve.Update();
+    stats.EndFrame(frame);
+    BOOST_TEST(frame.counters[STAT_CURVES_RECALCULATED] == 0U);
+    BOOST_TEST(frame.calls[STAT_TIMER_RECALCULATE_CURVE] == 0U);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that the CSV header and rows have the same columns
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(CsvTest) {
+    FrameStats frame = FrameStats();
+    frame.frame = 7;
+    frame.time[STAT_TIMER_DRAW] = 1.5;
+    frame.counters[STAT_STROKES_ISSUED] = 3;
+
+    std::ostringstream out;
+    FrameStats::WriteCsvHeader(out);
+    frame.WriteCsv(out);
+
+    std::istringstream in(out.str());
+    std::string header, row;
+    std::getline(in, header);
+    std::getline(in, row);
+    BOOST_TEST(CountColumns(header) == 1U + 2U * STAT_TIMER_COUNT + STAT_COUNTER_COUNT);
+    BOOST_TEST(CountColumns(row) == CountColumns(header));
+    BOOST_TEST(header.find("draw_ms") != std::string::npos);
+    BOOST_TEST(row.substr(0, 2) == "7,");
+}
+
+}
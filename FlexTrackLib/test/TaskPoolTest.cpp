@@ -0,0 +1,126 @@
+//
+// Work stealing task pool and parallel layout recalculation
+//
+
+#define BOOST_TEST_MODULE TaskPoolTest
+
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "BezierCurve.h"
+#include "FlexTrackSegment.h"
+#include "LayoutRecalculator.h"
+#include "TaskPool.h"
+
+namespace ByteTrail {
+
+    static void SetCurve(BezierCurve &curve, double x, double y) {
+        curve.SetControlPoint(x, y, 0);
+        curve.SetControlPoint(x + 100, y + 20, 1);
+        curve.SetControlPoint(x + 100, y + 100, 2);
+        curve.SetControlPoint(x + 200, y + 100, 3);
+    }
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that every index of a loop runs exactly once, over many loops
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(ParallelForTest) {
+    TaskPool pool(3);
+    BOOST_CHECK_EQUAL(pool.GetWorkerCount(), 3);
+    BOOST_CHECK_EQUAL(pool.GetThreadCount(), 4);
+
+    const std::size_t count = 1000;
+    std::vector<std::atomic<unsigned>> visits(count);
+    std::atomic<bool> thread_valid(true);
+    for (unsigned loop = 0; loop < 200; loop++) {
+        for (auto &visit : visits)
+            visit.store(0);
+        pool.ParallelFor(count, 7, [&](std::size_t begin, std::size_t end, unsigned thread) {
+            if (thread >= pool.GetThreadCount() || end - begin > 7)
+                thread_valid = false;
+            for (std::size_t idx = begin; idx < end; idx++)
+                visits[idx].fetch_add(1);
+        });
+        for (std::size_t idx = 0; idx < count; idx++) {
+            BOOST_REQUIRE_EQUAL(visits[idx].load(), 1);
+        }
+    }
+    BOOST_CHECK(thread_valid);
+
+    // a range within one grain and an empty range run on the caller
+    pool.ParallelFor(5, 7, [&](std::size_t begin, std::size_t end, unsigned thread) {
+        BOOST_CHECK_EQUAL(begin, 0);
+        BOOST_CHECK_EQUAL(end, 5);
+        BOOST_CHECK_EQUAL(thread, pool.GetThreadCount() - 1);
+    });
+    pool.ParallelFor(0, 7, [&](std::size_t, std::size_t, unsigned) {
+        BOOST_FAIL("empty range ran");
+    });
+
+    TaskPool serial(0);
+    std::size_t total = 0;
+    serial.ParallelFor(count, 7, [&](std::size_t begin, std::size_t end, unsigned thread) {
+        BOOST_CHECK_EQUAL(thread, 0);
+        total += end - begin;
+    });
+    BOOST_CHECK_EQUAL(total, count);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that a layout recalculated in parallel matches a serial
+//!        recalculation, curves and ties alike
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(LayoutRecalculatorTest) {
+    TaskPool pool(3);
+    LayoutRecalculator recalculator(pool);
+
+    const unsigned count = 500;
+    std::vector<std::shared_ptr<BezierCurve>> curves;
+    std::vector<BezierCurve> expected(count);
+    std::vector<std::shared_ptr<FlexTrackSegment>> segments;
+    for (unsigned i = 0; i < count; i++) {
+        curves.push_back(std::make_shared<BezierCurve>());
+        SetCurve(*curves.back(), 10.0 * i, 5.0 * i);
+        SetCurve(expected[i], 10.0 * i, 5.0 * i);
+        expected[i].Update();
+
+        segments.push_back(std::make_shared<FlexTrackSegment>());
+        SetCurve(*segments.back()->GetCurve(), 10.0 * i, 5.0 * i);
+    }
+
+    BOOST_CHECK_EQUAL(LayoutRecalculator::GetModifiedCount(curves), count);
+    BOOST_CHECK_EQUAL(recalculator.Recalculate(curves), count);
+    BOOST_CHECK_EQUAL(LayoutRecalculator::GetModifiedCount(curves), 0);
+    for (unsigned i = 0; i < count; i++) {
+        BOOST_REQUIRE_EQUAL(curves[i]->GetPointCount(), expected[i].GetPointCount());
+        for (unsigned p = 0; p < expected[i].GetPointCount(); p++) {
+            BOOST_REQUIRE_EQUAL(curves[i]->GetCenterline()[p].x, expected[i].GetCenterline()[p].x);
+            BOOST_REQUIRE_EQUAL(curves[i]->GetCenterline()[p].y, expected[i].GetCenterline()[p].y);
+            BOOST_REQUIRE_EQUAL(curves[i]->GetLeftRail()[p].x, expected[i].GetLeftRail()[p].x);
+            BOOST_REQUIRE_EQUAL(curves[i]->GetRightRail()[p].y, expected[i].GetRightRail()[p].y);
+        }
+    }
+
+    // only the modified curves are recalculated again
+    curves[3]->Move(1, 0);
+    curves[400]->Move(0, 1);
+    BOOST_CHECK_EQUAL(recalculator.Recalculate(curves), 2);
+
+    recalculator.Recalculate(segments);
+    FlexTrackSegment serial;
+    for (unsigned i = 0; i < count; i++) {
+        SetCurve(*serial.GetCurve(), 10.0 * i, 5.0 * i);
+        BOOST_REQUIRE_EQUAL(segments[i]->GetTieCount(), serial.GetTieCount());
+        const Quad *ties = segments[i]->GetTieData();
+        const Quad *serial_ties = serial.GetTieData();
+        for (unsigned t = 0; t < serial.GetTieCount(); t++) {
+            for (unsigned c = 0; c < 4; c++) {
+                BOOST_REQUIRE_EQUAL(ties[t].corners[c].x, serial_ties[t].corners[c].x);
+                BOOST_REQUIRE_EQUAL(ties[t].corners[c].y, serial_ties[t].corners[c].y);
+            }
+        }
+    }
+}
+
+}
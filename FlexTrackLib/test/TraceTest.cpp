@@ -0,0 +1,91 @@
+//
+// Lock free trace buffer
+//
+
+#define BOOST_TEST_MODULE TraceTest
+
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <thread>
+#include "Trace.h"
+
+namespace ByteTrail {
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that events are drained in order with their values and that a
+//!        disabled category records nothing
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(RecordTest) {
+    TraceBuffer buffer;
+    BOOST_CHECK(buffer.IsEnabled(TRACE_RENDER));
+    BOOST_CHECK(buffer.Record(TRACE_RENDER, "first", 1.0, 2.0));
+    BOOST_CHECK(buffer.Record(TRACE_GEOMETRY, "second", 3.0, 4.0));
+
+    buffer.SetEnabled(TRACE_INPUT, false);
+    BOOST_CHECK(!buffer.IsEnabled(TRACE_INPUT));
+    BOOST_CHECK(!buffer.Record(TRACE_INPUT, "ignored", 0.0, 0.0));
+
+    std::vector<TraceEvent> events;
+    BOOST_TEST(buffer.Drain(events) == 2U);
+    BOOST_TEST_REQUIRE(events.size() == 2U);
+    BOOST_TEST(std::strcmp(events[0].name, "first") == 0);
+    BOOST_TEST(events[0].category == TRACE_RENDER);
+    BOOST_TEST(events[0].values[1] == 2.0);
+    BOOST_TEST(std::strcmp(events[1].name, "second") == 0);
+    BOOST_TEST(events[1].values[0] == 3.0);
+    BOOST_TEST(events[1].timestamp >= events[0].timestamp);
+
+    BOOST_TEST(buffer.Drain(events) == 0U);
+    BOOST_TEST(buffer.GetDropped() == 0U);
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that a full buffer drops and counts events and accepts new ones
+//!        once drained
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(OverflowTest) {
+    TraceBuffer buffer;
+    for (std::size_t i = 0; i < TraceBuffer::kCapacity; i++) {
+        BOOST_REQUIRE(buffer.Record(TRACE_GEOMETRY, "fill", i, 0.0));
+    }
+    BOOST_CHECK(!buffer.Record(TRACE_GEOMETRY, "overflow", 0.0, 0.0));
+    BOOST_TEST(buffer.GetDropped() == 1U);
+
+    std::vector<TraceEvent> events;
+    BOOST_TEST(buffer.Drain(events) == TraceBuffer::kCapacity);
+    BOOST_TEST(events.back().values[0] == TraceBuffer::kCapacity - 1.0);
+    BOOST_CHECK(buffer.Record(TRACE_GEOMETRY, "after", 0.0, 0.0));
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that events from concurrent writers are neither lost nor torn
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(ConcurrentRecordTest) {
+    TraceBuffer buffer;
+    const unsigned writers = 4;
+    const unsigned per_writer = 1000;
+    std::vector<std::thread> threads;
+    for (unsigned w = 0; w < writers; w++) {
+        threads.push_back(std::thread([&buffer, w, per_writer]() {
+            for (unsigned i = 0; i < per_writer; i++)
+                buffer.Record(TRACE_RENDER, "writer", w, i);
+        }));
+    }
+
+    std::vector<TraceEvent> events;
+    for (auto &thread : threads)
+        thread.join();
+    buffer.Drain(events);
+
+    BOOST_TEST(events.size() == writers * per_writer);
+    std::vector<double> last(writers, -1.0);
+    for (const TraceEvent &event : events) {
+        unsigned w = static_cast<unsigned>(event.values[0]);
+        BOOST_REQUIRE(w < writers);
+        // each writer's events stay in order
+        BOOST_CHECK(event.values[1] > last[w]);
+        last[w] = event.values[1];
+    }
+}
+
+}
@@ -0,0 +1,150 @@
+//
+// Joints between track segments
+//
+
+#define BOOST_TEST_MODULE TrackGraphTest
+
+#include <boost/test/unit_test.hpp>
+#include <cmath>
+#include <memory>
+#include "BezierBatch.h"
+#include "BezierCurve.h"
+#include "TrackGraph.h"
+
+namespace utf = boost::unit_test;
+
+namespace ByteTrail {
+
+    //! chain of segments along the x axis, each 300 long, joined end to start
+    static void BuildChain(TrackGraph &graph, unsigned count) {
+        for (unsigned i = 0; i < count; i++) {
+            std::shared_ptr<BezierCurve> curve = std::make_shared<BezierCurve>();
+            curve->SetControlPoint(300.0 * i, 0, 0);
+            curve->SetControlPoint(300.0 * i + 100, 0, 1);
+            curve->SetControlPoint(300.0 * i + 200, 0, 2);
+            curve->SetControlPoint(300.0 * i + 300, 0, 3);
+            curve->Update();
+            unsigned segment = graph.AddSegment(curve);
+            if (segment > 0)
+                BOOST_CHECK(graph.Connect(segment - 1, TrackGraph::END_FINISH, segment, TrackGraph::END_START));
+        }
+    }
+
+    //! tells whether the tangents at the joint after a segment are continuous
+    static bool IsSmooth(TrackGraph &graph, unsigned segment) {
+        const Connector &finish = graph.GetConnector(segment, TrackGraph::END_FINISH);
+        const Connector &start = graph.GetConnector(segment + 1, TrackGraph::END_START);
+        double turn = std::remainder(finish.GetAngle() - start.GetAngle() - M_PI, 2.0 * M_PI);
+        return finish.GetLocation().Distance(start.GetLocation()) < 1.0e-9 && std::abs(turn) < 1.0e-9;
+    }
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates connecting and disconnecting ends
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(ConnectTest) {
+    TrackGraph graph;
+    BuildChain(graph, 3);
+    BOOST_CHECK_EQUAL(graph.GetSegmentCount(), 3);
+
+    unsigned other;
+    TrackGraph::End end;
+    BOOST_CHECK(graph.GetNeighbor(1, TrackGraph::END_START, other, end));
+    BOOST_CHECK_EQUAL(other, 0);
+    BOOST_CHECK_EQUAL(end, TrackGraph::END_FINISH);
+    BOOST_CHECK(!graph.GetNeighbor(0, TrackGraph::END_START, other, end));
+    BOOST_CHECK(!graph.Connect(0, TrackGraph::END_FINISH, 2, TrackGraph::END_FINISH));
+
+    graph.PopSegment();
+    BOOST_CHECK_EQUAL(graph.GetSegmentCount(), 2);
+    BOOST_CHECK(!graph.GetNeighbor(1, TrackGraph::END_FINISH, other, end));
+    graph.Disconnect(0, TrackGraph::END_FINISH);
+    BOOST_CHECK(!graph.GetNeighbor(1, TrackGraph::END_START, other, end));
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that edits of flexible track stop at the first joint
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(FlexPropagationTest, * utf::tolerance(0.000001)) {
+    TrackGraph graph;
+    BuildChain(graph, 5);
+
+    // moving a joint moves the handles on both sides along
+    graph.MoveControlPoint(2, 3, Point(900, 50));
+    BOOST_REQUIRE_EQUAL(graph.GetTouched().size(), 2);
+    BOOST_CHECK_EQUAL(graph.GetTouched()[0].segment, 2);
+    BOOST_CHECK_EQUAL(graph.GetTouched()[1].segment, 3);
+    BOOST_TEST(graph.GetTouched()[1].bounds.y == -4.5);
+    BOOST_TEST(graph.GetCurve(3)->GetControlPoint(0).y == 50.0);
+    BOOST_TEST(graph.GetCurve(3)->GetControlPoint(1).x == 1000.0);
+    BOOST_TEST(graph.GetCurve(3)->GetControlPoint(1).y == 50.0);
+    BOOST_TEST(graph.GetCurve(2)->GetControlPoint(2).y == 50.0);
+    BOOST_CHECK(IsSmooth(graph, 2));
+
+    // turning a handle turns the one across the joint and keeps its length
+    graph.MoveControlPoint(1, 1, Point(400, 100));
+    BOOST_REQUIRE_EQUAL(graph.GetTouched().size(), 2);
+    BOOST_CHECK_EQUAL(graph.GetTouched()[1].segment, 0);
+    const Point &handle = graph.GetCurve(0)->GetControlPoint(2);
+    BOOST_TEST(handle.Distance(Point(300, 0)) == 100.0);
+    BOOST_TEST(handle.x == 300.0 - 100.0 / std::sqrt(2.0));
+    BOOST_CHECK(IsSmooth(graph, 0));
+
+    // the far handles of the neighbors never move
+    BOOST_TEST(graph.GetCurve(0)->GetControlPoint(1).x == 100.0);
+    BOOST_TEST(graph.GetCurve(4)->GetControlPoint(0).x == 1200.0);
+
+    // an open end takes only its own segment
+    graph.MoveControlPoint(4, 3, Point(1500, 30));
+    BOOST_CHECK_EQUAL(graph.GetTouched().size(), 1);
+
+    BezierBatch batch;
+    graph.MoveControlPoint(2, 0, Point(600, -40));
+    BOOST_CHECK(graph.GetCurve(1)->IsModified());
+    graph.Recalculate(batch);
+    BOOST_CHECK(!graph.GetCurve(1)->IsModified());
+    BOOST_CHECK(!graph.GetCurve(2)->IsModified());
+    BOOST_CHECK(graph.GetCurve(4)->IsModified());
+}
+
+//---------------------------------------------------------------------------------------
+//! \brief Validates that fixed track carries a change on to the next joint and
+//!        holds the tangent of handles next to it
+//---------------------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(FixedPropagationTest, * utf::tolerance(0.000001)) {
+    TrackGraph graph;
+    BuildChain(graph, 5);
+    graph.SetFixed(1, true);
+    graph.SetFixed(2, true);
+
+    graph.MoveControlPoint(0, 3, Point(300, 20));
+    BOOST_REQUIRE_EQUAL(graph.GetTouched().size(), 4);
+    BOOST_CHECK_EQUAL(graph.GetTouched()[3].segment, 3);
+    BOOST_TEST(graph.GetCurve(2)->GetControlPoint(1).y == 20.0);
+    BOOST_TEST(graph.GetCurve(3)->GetControlPoint(0).y == 20.0);
+    BOOST_TEST(graph.GetCurve(3)->GetControlPoint(3).y == 0.0);
+    for (unsigned i = 0; i < 3; i++)
+        BOOST_CHECK(IsSmooth(graph, i));
+
+    // the handle is kept on the line of the fixed segment
+    graph.MoveControlPoint(3, 1, Point(1000, 60));
+    BOOST_TEST(graph.GetCurve(3)->GetControlPoint(1).x == 1000.0);
+    BOOST_TEST(graph.GetCurve(3)->GetControlPoint(1).y == 20.0);
+    BOOST_CHECK(IsSmooth(graph, 2));
+
+    // control points of fixed segments other than the ends cannot be moved alone
+    graph.MoveControlPoint(1, 1, Point(0, 0));
+    BOOST_CHECK(graph.GetTouched().empty());
+
+    // a ring of fixed track is moved once and closed by the flexible segment
+    TrackGraph ring;
+    BuildChain(ring, 3);
+    ring.SetFixed(0, true);
+    ring.SetFixed(1, true);
+    BOOST_CHECK(ring.Connect(2, TrackGraph::END_FINISH, 0, TrackGraph::END_START));
+    ring.MoveControlPoint(1, 3, Point(600, 10));
+    BOOST_CHECK_EQUAL(ring.GetTouched().size(), 3);
+    BOOST_TEST(ring.GetCurve(0)->GetControlPoint(0).y == 10.0);
+    BOOST_TEST(ring.GetCurve(2)->GetControlPoint(3).y == 10.0);
+}
+
+}